@@ -0,0 +1,225 @@
+#include "aes.h"
+#include "fastmem.h"
+
+#include <string.h>
+#include <generated/csr.h>
+
+static const uint8_t sbox[256] FASTDATA = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+};
+
+static inline uint8_t xtime(uint8_t b) {
+    return (uint8_t)((b << 1) ^ ((b & 0x80) ? 0x1b : 0x00));
+}
+
+static inline void xor_block(uint8_t *dst, const uint8_t *src) {
+    for (unsigned i = 0; i < AES_BLOCK_LEN; i++) dst[i] ^= src[i];
+}
+
+// ============================================
+// === Software ===
+// ============================================
+
+static void sw_expand(uint8_t rk[176], const uint8_t key[AES_KEY_LEN]) {
+    uint8_t rcon = 0x01;
+
+    memcpy(rk, key, AES_KEY_LEN);
+    for (unsigned i = AES_KEY_LEN; i < 176; i += 4) {
+        uint8_t t[4] = { rk[i - 4], rk[i - 3], rk[i - 2], rk[i - 1] };
+        if (i % AES_KEY_LEN == 0) {
+            // SubWord(RotWord(w)) ^ rcon
+            uint8_t t0 = t[0];
+            t[0] = sbox[t[1]] ^ rcon;
+            t[1] = sbox[t[2]];
+            t[2] = sbox[t[3]];
+            t[3] = sbox[t0];
+            rcon = xtime(rcon);
+        }
+        for (unsigned j = 0; j < 4; j++) rk[i + j] = rk[i - AES_KEY_LEN + j] ^ t[j];
+    }
+}
+
+// Estado em colunas (byte i = linha i % 4, coluna i / 4), como no FIPS-197.
+FASTTEXT static void sw_encrypt(const uint8_t rk[176], const uint8_t in[AES_BLOCK_LEN],
+                                uint8_t out[AES_BLOCK_LEN]) {
+    uint8_t s[AES_BLOCK_LEN], t[AES_BLOCK_LEN];
+
+    for (unsigned i = 0; i < AES_BLOCK_LEN; i++) s[i] = in[i] ^ rk[i];
+    for (unsigned r = 1; r <= 10; r++) {
+        // SubBytes + ShiftRows: a linha i % 4 gira (i % 4) colunas.
+        for (unsigned i = 0; i < AES_BLOCK_LEN; i++)
+            t[i] = sbox[s[(i + 4 * (i & 3)) & 15]];
+        if (r < 10) {
+            for (unsigned c = 0; c < AES_BLOCK_LEN; c += 4) {
+                uint8_t a0 = t[c], a1 = t[c + 1], a2 = t[c + 2], a3 = t[c + 3];
+                uint8_t e = a0 ^ a1 ^ a2 ^ a3;
+                t[c]     = a0 ^ e ^ xtime(a0 ^ a1);
+                t[c + 1] = a1 ^ e ^ xtime(a1 ^ a2);
+                t[c + 2] = a2 ^ e ^ xtime(a2 ^ a3);
+                t[c + 3] = a3 ^ e ^ xtime(a3 ^ a0);
+            }
+        }
+        for (unsigned i = 0; i < AES_BLOCK_LEN; i++) s[i] = t[i] ^ rk[AES_BLOCK_LEN * r + i];
+    }
+    memcpy(out, s, AES_BLOCK_LEN);
+}
+
+// ============================================
+// === Core do gateware ===
+// ============================================
+#ifdef CSR_AES_BASE
+static bool             use_hw = true;
+static const aes_key_t *hw_key;     // Chave carregada no core
+
+static inline uint32_t get_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static inline void put_be32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+}
+
+static void hw_load_key(const aes_key_t *k) {
+    if (hw_key == k) return;
+    aes_key0_write(get_be32(&k->rk[0]));
+    aes_key1_write(get_be32(&k->rk[4]));
+    aes_key2_write(get_be32(&k->rk[8]));
+    aes_key3_write(get_be32(&k->rk[12]));
+    hw_key = k;
+}
+
+// chain: cifra in ^ último resultado (passo do CBC-MAC dentro do core).
+static void hw_start(const uint8_t in[AES_BLOCK_LEN], bool chain) {
+    aes_din0_write(get_be32(&in[0]));
+    aes_din1_write(get_be32(&in[4]));
+    aes_din2_write(get_be32(&in[8]));
+    aes_din3_write(get_be32(&in[12]));
+    aes_control_write((1 << CSR_AES_CONTROL_START_OFFSET) |
+                      ((chain ? 1 : 0) << CSR_AES_CONTROL_CHAIN_OFFSET));
+}
+
+// 11 ciclos por bloco: o laço quase nunca dá uma volta.
+static void hw_read(uint8_t out[AES_BLOCK_LEN]) {
+    while (aes_status_read() & (1 << CSR_AES_STATUS_BUSY_OFFSET)) { }
+    put_be32(&out[0],  aes_dout0_read());
+    put_be32(&out[4],  aes_dout1_read());
+    put_be32(&out[8],  aes_dout2_read());
+    put_be32(&out[12], aes_dout3_read());
+}
+#endif
+
+// ============================================
+// === API ===
+// ============================================
+
+// Dobra em GF(2^128) para as subchaves do CMAC.
+static void cmac_double(uint8_t out[AES_BLOCK_LEN], const uint8_t in[AES_BLOCK_LEN]) {
+    uint8_t carry = in[0] & 0x80;
+    for (unsigned i = 0; i < AES_BLOCK_LEN - 1; i++)
+        out[i] = (uint8_t)((in[i] << 1) | (in[i + 1] >> 7));
+    out[AES_BLOCK_LEN - 1] = (uint8_t)((in[AES_BLOCK_LEN - 1] << 1) ^ (carry ? 0x87 : 0x00));
+}
+
+void aes_set_key(aes_key_t *k, const uint8_t key[AES_KEY_LEN]) {
+    uint8_t l[AES_BLOCK_LEN] = {0};
+
+    sw_expand(k->rk, key);
+#ifdef CSR_AES_BASE
+    if (hw_key == k) hw_key = NULL;
+#endif
+    aes_encrypt_block(k, l, l);
+    cmac_double(k->k1, l);
+    cmac_double(k->k2, k->k1);
+}
+
+void aes_encrypt_block(const aes_key_t *k, const uint8_t in[AES_BLOCK_LEN], uint8_t out[AES_BLOCK_LEN]) {
+#ifdef CSR_AES_BASE
+    if (use_hw) {
+        hw_load_key(k);
+        hw_start(in, false);
+        hw_read(out);
+        return;
+    }
+#endif
+    sw_encrypt(k->rk, in, out);
+}
+
+void aes_ctr(const aes_key_t *k, uint8_t ctr[AES_BLOCK_LEN], uint8_t *data, size_t len) {
+    uint8_t ks[AES_BLOCK_LEN];
+
+    while (len > 0) {
+        size_t n = len < AES_BLOCK_LEN ? len : AES_BLOCK_LEN;
+        aes_encrypt_block(k, ctr, ks);
+        for (size_t i = 0; i < n; i++) data[i] ^= ks[i];
+        ctr[AES_BLOCK_LEN - 1]++;
+        data += n;
+        len  -= n;
+    }
+}
+
+void aes_cmac(const aes_key_t *k, const uint8_t *data, size_t len, uint8_t tag[AES_BLOCK_LEN]) {
+    size_t n = len ? (len + AES_BLOCK_LEN - 1) / AES_BLOCK_LEN : 1;
+    size_t rem = len - (n - 1) * AES_BLOCK_LEN;
+    uint8_t last[AES_BLOCK_LEN];
+
+    // Último bloco: completo ^ K1, ou com o preenchimento 10* ^ K2.
+    for (unsigned i = 0; i < AES_BLOCK_LEN; i++)
+        last[i] = i < rem ? data[(n - 1) * AES_BLOCK_LEN + i] : (i == rem ? 0x80 : 0x00);
+    xor_block(last, rem == AES_BLOCK_LEN ? k->k1 : k->k2);
+
+#ifdef CSR_AES_BASE
+    if (use_hw) {
+        hw_load_key(k);
+        for (size_t b = 0; b + 1 < n; b++) {
+            hw_start(&data[b * AES_BLOCK_LEN], b > 0);
+            while (aes_status_read() & (1 << CSR_AES_STATUS_BUSY_OFFSET)) { }
+        }
+        hw_start(last, n > 1);
+        hw_read(tag);
+        return;
+    }
+#endif
+    uint8_t x[AES_BLOCK_LEN] = {0};
+    for (size_t b = 0; b + 1 < n; b++) {
+        xor_block(x, &data[b * AES_BLOCK_LEN]);
+        sw_encrypt(k->rk, x, x);
+    }
+    xor_block(x, last);
+    sw_encrypt(k->rk, x, tag);
+}
+
+bool aes_hw_available(void) {
+#ifdef CSR_AES_BASE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool aes_use_hw(bool on) {
+#ifdef CSR_AES_BASE
+    use_hw = on;
+    return use_hw;
+#else
+    (void)on;
+    return false;
+#endif
+}
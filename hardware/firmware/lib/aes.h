@@ -0,0 +1,51 @@
+// ./lib/aes.h
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================
+// === AES-128: bloco, CTR e CMAC ===
+// ============================================
+/*
+ * Duas implementações da cifragem de bloco: o core 'aes' do gateware
+ * (--with-aes, hardware/litex/aes_core.py) e uma em software, orientada a
+ * bytes, usada quando o SoC não tem o core ou para comparação no 'bench'.
+ * As duas dão o mesmo resultado; aes_use_hw() escolhe entre elas.
+ *
+ * O receptor (software/inc/aes.h) tem a mesma implementação em software.
+ */
+#define AES_BLOCK_LEN 16
+#define AES_KEY_LEN   16
+
+typedef struct {
+    uint8_t rk[176];            // Chaves das 11 rodadas (rk[0..15] = chave)
+    uint8_t k1[AES_BLOCK_LEN];  // Subchaves do CMAC (RFC 4493)
+    uint8_t k2[AES_BLOCK_LEN];
+} aes_key_t;
+
+/** @brief Expande a chave e calcula as subchaves do CMAC. */
+void aes_set_key(aes_key_t *k, const uint8_t key[AES_KEY_LEN]);
+
+/** @brief Cifra um bloco; 'in' e 'out' podem ser o mesmo buffer. */
+void aes_encrypt_block(const aes_key_t *k, const uint8_t in[AES_BLOCK_LEN], uint8_t out[AES_BLOCK_LEN]);
+
+/**
+ * @brief CTR: aplica o fluxo de chave E(ctr), E(ctr + 1), ... sobre 'data'
+ * (cifra e decifra). O contador ocupa o último byte do bloco, que sai
+ * incrementado do número de blocos usados.
+ */
+void aes_ctr(const aes_key_t *k, uint8_t ctr[AES_BLOCK_LEN], uint8_t *data, size_t len);
+
+/** @brief AES-CMAC (RFC 4493) de 'data'; o tag tem AES_BLOCK_LEN bytes. */
+void aes_cmac(const aes_key_t *k, const uint8_t *data, size_t len, uint8_t tag[AES_BLOCK_LEN]);
+
+/** @brief true se o SoC tem o core AES. */
+bool aes_hw_available(void);
+
+/**
+ * @brief Usa o core (on) ou o software nas próximas operações. O padrão é o
+ * core quando existe.
+ * @return Backend que ficou ativo (false = software).
+ */
+bool aes_use_hw(bool on);
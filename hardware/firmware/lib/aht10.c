@@ -1,4 +1,7 @@
 #include "aht10.h"
+#include "log.h"
+#include "fastmem.h"
+#include "trace.h"
 #include <stdio.h>
 #include <generated/csr.h>
 #include <system.h> // Para busy_wait_us
@@ -6,6 +9,12 @@
 // ============================================
 // === Utils de tempo (Cópia local) ===
 // ============================================
+static void (*wait_hook)(void);
+
+void aht10_set_wait_hook(void (*hook)(void)) {
+    wait_hook = hook;
+}
+
 // Esta função é necessária pelo driver I2C e AHT10
 static void busy_wait_ms(unsigned int ms) {
     for (unsigned int i = 0; i < ms; ++i) {
@@ -14,97 +23,137 @@ static void busy_wait_ms(unsigned int ms) {
 #else
         for(volatile int j = 0; j < 1000; j++);
 #endif
+        if (wait_hook) wait_hook();
     }
 }
 
+// ============================================
+// === Barramentos ===
+// ============================================
+// Endereços explícitos por barramento: o layout dos CSRs do barramento 0
+// muda com o amostrador em hardware.
+static FASTDATA i2c_bus_t buses[AHT10_NUM_BUSES] = {
+    { .w = CSR_I2C_W_ADDR,  .r = CSR_I2C_R_ADDR,  .id = 0 },
+#if AHT10_NUM_BUSES > 1
+    { .w = CSR_I2C1_W_ADDR, .r = CSR_I2C1_R_ADDR, .id = 1 },
+#endif
+#if AHT10_NUM_BUSES > 2
+    { .w = CSR_I2C2_W_ADDR, .r = CSR_I2C2_R_ADDR, .id = 2 },
+#endif
+#if AHT10_NUM_BUSES > 3
+    { .w = CSR_I2C3_W_ADDR, .r = CSR_I2C3_R_ADDR, .id = 3 },
+#endif
+#if AHT10_NUM_BUSES > 4
+    { .w = CSR_I2C4_W_ADDR, .r = CSR_I2C4_R_ADDR, .id = 4 },
+#endif
+#if AHT10_NUM_BUSES > 5
+    { .w = CSR_I2C5_W_ADDR, .r = CSR_I2C5_R_ADDR, .id = 5 },
+#endif
+#if AHT10_NUM_BUSES > 6
+    { .w = CSR_I2C6_W_ADDR, .r = CSR_I2C6_R_ADDR, .id = 6 },
+#endif
+#if AHT10_NUM_BUSES > 7
+    { .w = CSR_I2C7_W_ADDR, .r = CSR_I2C7_R_ADDR, .id = 7 },
+#endif
+};
+
+i2c_bus_t *i2c_bus(unsigned id) {
+    return id < AHT10_NUM_BUSES ? &buses[id] : NULL;
+}
+
 // ============================================
 // === I2C Driver (Bitbang com CSR) ===
 // ============================================
 
-static uint32_t i2c_w_reg = 0;
 static void i2c_delay(void) { busy_wait_us(5); }
 
-static void i2c_set_scl(int val) {
-    if (val) i2c_w_reg |= (1 << CSR_I2C_W_SCL_OFFSET);
-    else     i2c_w_reg &= ~(1 << CSR_I2C_W_SCL_OFFSET);
-    i2c_w_write(i2c_w_reg);
+static FASTTEXT void i2c_set_scl(i2c_bus_t *b, int val) {
+    if (val) b->w_reg |= (1 << CSR_I2C_W_SCL_OFFSET);
+    else     b->w_reg &= ~(1 << CSR_I2C_W_SCL_OFFSET);
+    csr_write_simple(b->w_reg, b->w);
 }
 
-static void i2c_set_sda(int val) {
-    if (val) i2c_w_reg |= (1 << CSR_I2C_W_SDA_OFFSET);
-    else     i2c_w_reg &= ~(1 << CSR_I2C_W_SDA_OFFSET);
-    i2c_w_write(i2c_w_reg);
+static FASTTEXT void i2c_set_sda(i2c_bus_t *b, int val) {
+    if (val) b->w_reg |= (1 << CSR_I2C_W_SDA_OFFSET);
+    else     b->w_reg &= ~(1 << CSR_I2C_W_SDA_OFFSET);
+    csr_write_simple(b->w_reg, b->w);
 }
 
-static void i2c_set_oe(int val) {
-    if (val) i2c_w_reg |= (1 << CSR_I2C_W_OE_OFFSET);
-    else     i2c_w_reg &= ~(1 << CSR_I2C_W_OE_OFFSET);
-    i2c_w_write(i2c_w_reg);
+static FASTTEXT void i2c_set_oe(i2c_bus_t *b, int val) {
+    if (val) b->w_reg |= (1 << CSR_I2C_W_OE_OFFSET);
+    else     b->w_reg &= ~(1 << CSR_I2C_W_OE_OFFSET);
+    csr_write_simple(b->w_reg, b->w);
 }
 
-static int i2c_read_sda(void) {
-    return (i2c_r_read() & (1 << CSR_I2C_R_SDA_OFFSET)) != 0;
+static FASTTEXT int i2c_read_sda(i2c_bus_t *b) {
+    return (csr_read_simple(b->r) & (1 << CSR_I2C_R_SDA_OFFSET)) != 0;
 }
 
 // --- Funções Públicas (do aht10.h) ---
-void i2c_init(void) {
-    i2c_set_oe(1); i2c_set_scl(1); i2c_set_sda(1);
+void i2c_init(i2c_bus_t *b) {
+    i2c_set_oe(b, 1); i2c_set_scl(b, 1); i2c_set_sda(b, 1);
     busy_wait_ms(1);
 }
 
 // --- Funções Internas (static) ---
-static void i2c_start(void) {
-    i2c_set_sda(1); i2c_set_oe(1); i2c_set_scl(1); i2c_delay();
-    i2c_set_sda(0); i2c_delay();
-    i2c_set_scl(0); i2c_delay();
+static FASTTEXT void i2c_start(i2c_bus_t *b) {
+    i2c_set_sda(b, 1); i2c_set_oe(b, 1); i2c_set_scl(b, 1); i2c_delay();
+    i2c_set_sda(b, 0); i2c_delay();
+    i2c_set_scl(b, 0); i2c_delay();
 }
 
-static void i2c_stop(void) {
-    i2c_set_sda(0); i2c_set_oe(1); i2c_set_scl(0); i2c_delay();
-    i2c_set_scl(1); i2c_delay();
-    i2c_set_sda(1); i2c_delay();
+static FASTTEXT void i2c_stop(i2c_bus_t *b) {
+    i2c_set_sda(b, 0); i2c_set_oe(b, 1); i2c_set_scl(b, 0); i2c_delay();
+    i2c_set_scl(b, 1); i2c_delay();
+    i2c_set_sda(b, 1); i2c_delay();
 }
 
-static bool i2c_write_byte(uint8_t byte) {
+static FASTTEXT bool i2c_write_byte(i2c_bus_t *b, uint8_t byte) {
     int i; bool ack;
-    i2c_set_oe(1);
+    i2c_set_oe(b, 1);
     for (i = 0; i < 8; i++) {
-        i2c_set_sda((byte & 0x80) != 0); i2c_delay();
-        i2c_set_scl(1); i2c_delay();
-        i2c_set_scl(0); i2c_delay();
+        i2c_set_sda(b, (byte & 0x80) != 0); i2c_delay();
+        i2c_set_scl(b, 1); i2c_delay();
+        i2c_set_scl(b, 0); i2c_delay();
         byte <<= 1;
     }
-    i2c_set_oe(0); i2c_set_sda(1); i2c_delay();
-    i2c_set_scl(1); i2c_delay();
-    ack = !i2c_read_sda();
-    i2c_set_scl(0); i2c_delay();
+    i2c_set_oe(b, 0); i2c_set_sda(b, 1); i2c_delay();
+    i2c_set_scl(b, 1); i2c_delay();
+    ack = !i2c_read_sda(b);
+    i2c_set_scl(b, 0); i2c_delay();
     return ack;
 }
 
-static uint8_t i2c_read_byte(bool send_ack) {
+static FASTTEXT uint8_t i2c_read_byte(i2c_bus_t *b, bool send_ack) {
     int i; uint8_t byte = 0;
-    i2c_set_oe(0); i2c_set_sda(1); i2c_delay();
+    i2c_set_oe(b, 0); i2c_set_sda(b, 1); i2c_delay();
     for (i = 0; i < 8; i++) {
         byte <<= 1;
-        i2c_set_scl(1); i2c_delay();
-        if (i2c_read_sda()) byte |= 1;
-        i2c_set_scl(0); i2c_delay();
+        i2c_set_scl(b, 1); i2c_delay();
+        if (i2c_read_sda(b)) byte |= 1;
+        i2c_set_scl(b, 0); i2c_delay();
     }
-    i2c_set_oe(1); i2c_set_sda(!send_ack); i2c_delay();
-    i2c_set_scl(1); i2c_delay();
-    i2c_set_scl(0); i2c_delay();
+    i2c_set_oe(b, 1); i2c_set_sda(b, !send_ack); i2c_delay();
+    i2c_set_scl(b, 1); i2c_delay();
+    i2c_set_scl(b, 0); i2c_delay();
     return byte;
 }
 
-// --- Função Pública (do aht10.h) ---
-void i2c_scan(void) {
-    printf("Escaneando barramento I2C...\n");
+// --- Funções Públicas (do aht10.h) ---
+bool i2c_probe(i2c_bus_t *b, uint8_t addr) {
+    bool ack;
+    i2c_start(b);
+    ack = i2c_write_byte(b, addr << 1 | 0);
+    i2c_stop(b);
+    return ack;
+}
+
+void i2c_scan(i2c_bus_t *b) {
+    printf("Escaneando barramento I2C %d...\n", b->id);
     for (uint8_t addr = 1; addr < 128; addr++) {
-        i2c_start();
-        if (i2c_write_byte(addr << 1 | 0)) {
+        if (i2c_probe(b, addr)) {
             printf("  Dispositivo encontrado em 0x%02X\n", addr);
         }
-        i2c_stop();
         busy_wait_us(100);
     }
     printf("Scan completo.\n");
@@ -116,68 +165,126 @@ void i2c_scan(void) {
 // ============================================
 #define AHT10_I2C_ADDR 0x38
 
+// Envia START + endereço (escrita) + 3 bytes de comando + STOP.
+static bool aht10_command(i2c_bus_t *b, uint8_t c0, uint8_t c1, uint8_t c2) {
+    i2c_start(b);
+    if (!i2c_write_byte(b, AHT10_I2C_ADDR << 1 | 0)) { i2c_stop(b); return false; } // Escrita
+    if (!i2c_write_byte(b, c0)) { i2c_stop(b); return false; }
+    if (!i2c_write_byte(b, c1)) { i2c_stop(b); return false; }
+    if (!i2c_write_byte(b, c2)) { i2c_stop(b); return false; }
+    i2c_stop(b);
+    return true;
+}
+
 // --- Funções Públicas (do aht10.h) ---
 
-int aht10_init(void) {
-    i2c_start();
-    if (!i2c_write_byte(AHT10_I2C_ADDR << 1 | 0)) { i2c_stop(); return -1; }
-    if (!i2c_write_byte(0xE1)) { i2c_stop(); return -1; }
-    if (!i2c_write_byte(0x08)) { i2c_stop(); return -1; }
-    if (!i2c_write_byte(0x00)) { i2c_stop(); return -1; }
-    i2c_stop();
+int aht10_init(i2c_bus_t *b) {
+    b->present = aht10_command(b, 0xE1, 0x08, 0x00);
+    if (!b->present) return -1;
     busy_wait_ms(100);
     return 0;
 }
 
-bool aht10_get_data(dados *d) {
+bool aht10_trigger(i2c_bus_t *b) {
+    TRACE_BEGIN(TRACE_EV_SENSOR_TRIGGER, TRACE_ARG(b->id, 0));
+    bool ok = aht10_command(b, 0xAC, 0x33, 0x00);
+    TRACE_END(TRACE_EV_SENSOR_TRIGGER, TRACE_ARG(b->id, ok));
+    return ok;
+}
+
+bool aht10_fetch(i2c_bus_t *b, dados *d) {
     uint8_t data[6];
     uint32_t raw_hum, raw_temp;
-    
-    // 1. Dispara a medição
-    i2c_start();
-    if (!i2c_write_byte(AHT10_I2C_ADDR << 1 | 0)) { i2c_stop(); return false; } // Escrita
-    if (!i2c_write_byte(0xAC)) { i2c_stop(); return false; }
-    if (!i2c_write_byte(0x33)) { i2c_stop(); return false; }
-    if (!i2c_write_byte(0x00)) { i2c_stop(); return false; }
-    i2c_stop();
 
-    // 2. Espera pela medição
-    busy_wait_ms(80);
-
-    // 3. Lê os 6 bytes de dados
-    i2c_start();
-    if (!i2c_write_byte(AHT10_I2C_ADDR << 1 | 1)) { i2c_stop(); return false; } // Leitura
-    data[0] = i2c_read_byte(true);
-    data[1] = i2c_read_byte(true);
-    data[2] = i2c_read_byte(true);
-    data[3] = i2c_read_byte(true);
-    data[4] = i2c_read_byte(true);
-    data[5] = i2c_read_byte(false); // NACK
-    i2c_stop();
-
-    // 4. Verifica o bit de "busy"
+    // Lê os 6 bytes de dados
+    TRACE_BEGIN(TRACE_EV_SENSOR_FETCH, TRACE_ARG(b->id, 0));
+    i2c_start(b);
+    if (!i2c_write_byte(b, AHT10_I2C_ADDR << 1 | 1)) { // Leitura
+        i2c_stop(b);
+        TRACE_END(TRACE_EV_SENSOR_FETCH, TRACE_ARG(b->id, 0));
+        return false;
+    }
+    data[0] = i2c_read_byte(b, true);
+    data[1] = i2c_read_byte(b, true);
+    data[2] = i2c_read_byte(b, true);
+    data[3] = i2c_read_byte(b, true);
+    data[4] = i2c_read_byte(b, true);
+    data[5] = i2c_read_byte(b, false); // NACK
+    i2c_stop(b);
+    TRACE_END(TRACE_EV_SENSOR_FETCH, TRACE_ARG(b->id, 6));
+
+    // Verifica o bit de "busy"
     if (data[0] & 0x80) {
-        printf("Erro: AHT10 ainda ocupado.\n");
+        LOG_WARN("AHT10 %d ainda ocupado (status 0x%02X)", b->id, data[0]);
         return false;
     }
 
-    // 5. Calcula os valores
+    // Calcula os valores
     raw_hum = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) | (data[3] >> 4);
     raw_temp = (((uint32_t)data[3] & 0x0F) << 16) | ((uint32_t)data[4] << 8) | data[5];
+    aht10_convert(raw_hum, raw_temp, d);
+
+    return true;
+}
+
+bool aht10_ready(i2c_bus_t *b) {
+    uint8_t status;
+
+    i2c_start(b);
+    if (!i2c_write_byte(b, AHT10_I2C_ADDR << 1 | 1)) { i2c_stop(b); return false; } // Leitura
+    status = i2c_read_byte(b, false); // NACK
+    i2c_stop(b);
+    return !(status & 0x80);
+}
 
+void aht10_convert(uint32_t raw_hum, uint32_t raw_temp, dados *d) {
     // Umidade = (raw_hum * 10000) / 2^20 (para *100)
-    d->umidade = (int16_t)(((uint64_t)raw_hum * 10000) / 0x100000);
+    // 10000 / 2^20 == 625 / 2^16: cabe em 32 bits (raw < 2^20) e troca a
+    // divisão de 64 bits (__udivdi3) por multiplicação e deslocamento.
+    d->umidade = (int16_t)((raw_hum * 625u) >> 16);
 
     // Temperatura = (raw_temp * 20000) / 2^20 - 5000 (para *100)
-    d->temperatura = (int16_t)((((uint64_t)raw_temp * 20000) / 0x100000) - 5000);
-    
-    return true;
+    // 20000 / 2^20 == 1250 / 2^16
+    d->temperatura = (int16_t)((int32_t)((raw_temp * 1250u) >> 16) - 5000);
+}
+
+bool aht10_get_data(i2c_bus_t *b, dados *d) {
+    // 1. Dispara a medição
+    if (!aht10_trigger(b)) return false;
+
+    // 2. Espera pela medição
+    busy_wait_ms(AHT10_CONVERSION_MS);
+
+    // 3. Lê e converte
+    return aht10_fetch(b, d);
+}
+
+unsigned aht10_read_all(dados *d, bool *ok) {
+    unsigned i, n = 0;
+    bool any = false;
+
+    // 1. Dispara todos: as conversões correm em paralelo.
+    for (i = 0; i < AHT10_NUM_BUSES; i++) {
+        ok[i] = buses[i].present && aht10_trigger(&buses[i]);
+        any |= ok[i];
+    }
+    if (!any) return 0;
+
+    // 2. Uma única espera para todos.
+    busy_wait_ms(AHT10_CONVERSION_MS);
+
+    // 3. Busca na mesma ordem do disparo.
+    for (i = 0; i < AHT10_NUM_BUSES; i++) {
+        if (ok[i]) ok[i] = aht10_fetch(&buses[i], &d[i]);
+        if (ok[i]) n++;
+    }
+    return n;
 }
 
-void aht10_read(void) {
+void aht10_read(i2c_bus_t *b) {
     dados my_data;
-    printf("Lendo AHT10 (modo debug)...\n");
-    if (aht10_get_data(&my_data)) {
+    printf("Lendo AHT10 %d (modo debug)...\n", b->id);
+    if (aht10_get_data(b, &my_data)) {
         // Imprime os valores com duas casas decimais (dividindo por 100)
         printf("Umidade: %d.%02d %%\n",
             my_data.umidade / 100, my_data.umidade % 100);
@@ -186,4 +293,50 @@ void aht10_read(void) {
     } else {
         printf("Falha ao ler AHT10.\n");
     }
-}
\ No newline at end of file
+}
+
+
+// ============================================
+// === Amostrador em hardware ===
+// ============================================
+#ifdef AHT10_HAS_SAMPLER
+
+#define SAMPLER_ERROR_MASK ((1 << CSR_I2C_SAMPLER_STATUS_OVERFLOW_OFFSET) | \
+                            (1 << CSR_I2C_SAMPLER_STATUS_NACK_OFFSET)     | \
+                            (1 << CSR_I2C_SAMPLER_STATUS_TIMEOUT_OFFSET))
+
+void aht10_sampler_start(uint32_t period_ms) {
+    i2c_sampler_period_write(period_ms);
+    i2c_sampler_control_write(1 << CSR_I2C_SAMPLER_CONTROL_ENABLE_OFFSET);
+}
+
+void aht10_sampler_stop(void) {
+    i2c_sampler_control_write(0);
+}
+
+unsigned aht10_sampler_pending(void) {
+    uint32_t status = i2c_sampler_status_read();
+    return (status >> CSR_I2C_SAMPLER_STATUS_LEVEL_OFFSET) &
+           ((1 << CSR_I2C_SAMPLER_STATUS_LEVEL_SIZE) - 1);
+}
+
+bool aht10_sampler_pop(aht10_sample *s) {
+    if (aht10_sampler_pending() == 0) return false;
+
+    s->ts_us = i2c_sampler_ts_read();
+    aht10_convert(i2c_sampler_hum_read(), i2c_sampler_temp_read(), &s->d);
+    i2c_sampler_pop_write(1);
+    return true;
+}
+
+uint32_t aht10_sampler_errors(void) {
+    uint32_t errors = i2c_sampler_status_read() & SAMPLER_ERROR_MASK;
+    if (errors) {
+        // 'clear' é um pulso: preserva o bit 'enable' atual.
+        i2c_sampler_control_write(i2c_sampler_control_read() |
+                                  (1 << CSR_I2C_SAMPLER_CONTROL_CLEAR_OFFSET));
+    }
+    return errors;
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <generated/csr.h>
 
 // ============================================
 // === Struct de Dados ===
@@ -17,37 +18,162 @@ typedef struct {
 } dados;
 
 
+// ============================================
+// === Barramentos I2C ===
+// ============================================
+/*
+ * O AHT10 tem endereço fixo (0x38): um sensor por barramento. O SoC gera
+ * AHT10_BUSES mestres I2C (--aht10-buses); o barramento 0 usa o CSR 'i2c'
+ * original e os demais 'i2cN'.
+ */
+#ifdef AHT10_BUSES
+#define AHT10_NUM_BUSES AHT10_BUSES
+#else
+#define AHT10_NUM_BUSES 1
+#endif
+
+typedef struct {
+    unsigned long w;        // CSR de escrita (scl/oe/sda)
+    unsigned long r;        // CSR de leitura (sda)
+    uint32_t      w_reg;    // Cópia do último valor escrito em 'w'
+    uint8_t       id;
+    bool          present;  // AHT10 respondeu no aht10_init()
+} i2c_bus_t;
+
+/** @brief Barramento 'id' (0..AHT10_NUM_BUSES-1), ou NULL. */
+i2c_bus_t *i2c_bus(unsigned id);
+
+
 // ============================================
 // === Protótipos Públicos ===
 // ============================================
 
 /**
- * @brief Inicializa o driver I2C bitbang.
+ * @brief Inicializa o driver I2C bitbang do barramento.
  * Deve ser chamada antes de qualquer outra função I2C ou AHT10.
  */
-void i2c_init(void);
+void i2c_init(i2c_bus_t *b);
+
+/**
+ * @brief Envia START + endereço (escrita) + STOP.
+ * @return true se algum dispositivo respondeu com ACK.
+ */
+bool i2c_probe(i2c_bus_t *b, uint8_t addr);
 
 /**
  * @brief Varre o barramento I2C e imprime endereços de dispositivos encontrados.
  */
-void i2c_scan(void);
+void i2c_scan(i2c_bus_t *b);
 
 /**
- * @brief Inicializa o sensor AHT10.
+ * @brief Inicializa o sensor AHT10 do barramento.
  * @return 0 em sucesso, -1 em falha.
  */
-int aht10_init(void);
+int aht10_init(i2c_bus_t *b);
 
 /**
  * @brief Lê o sensor AHT10 e imprime os valores formatados (Debug).
  */
-void aht10_read(void);
+void aht10_read(i2c_bus_t *b);
+
+/** @brief Tempo de conversão do AHT10 após o disparo. */
+#define AHT10_CONVERSION_MS 80
+
+/**
+ * @brief Função chamada a cada 1 ms das esperas do driver (conversão e
+ * inicialização), para o que não pode ficar 80 ms sem atendimento, como o
+ * polling do beacon TDMA. NULL desliga.
+ */
+void aht10_set_wait_hook(void (*hook)(void));
+
+/**
+ * @brief Dispara uma medição (0xAC 0x33 0x00); o resultado fica pronto
+ * após AHT10_CONVERSION_MS.
+ * @return true se o sensor respondeu com ACK.
+ */
+bool aht10_trigger(i2c_bus_t *b);
+
+/**
+ * @brief Lê os 6 bytes da última medição e converte (x100).
+ * @return false se o sensor não respondeu ou ainda está ocupado.
+ */
+bool aht10_fetch(i2c_bus_t *b, dados *d);
+
+/**
+ * @brief Lê só o byte de status (1 byte, sem os dados).
+ * @return true se o sensor respondeu e a conversão terminou.
+ */
+bool aht10_ready(i2c_bus_t *b);
+
+/**
+ * @brief Converte as leituras brutas (20 bits) do AHT10 para x100.
+ * Usada pela leitura bitbang e pelas amostras do FIFO do amostrador.
+ */
+void aht10_convert(uint32_t raw_hum, uint32_t raw_temp, dados *d);
 
 /**
  * @brief Obtém os dados de temperatura e umidade do AHT10.
  * @param d Ponteiro para a struct 'dados' onde os resultados serão armazenados.
  * @return true em sucesso, false em falha.
  */
-bool aht10_get_data(dados *d);
+bool aht10_get_data(i2c_bus_t *b, dados *d);
+
+/**
+ * @brief Lê todos os sensores presentes com uma única espera: dispara todos,
+ * espera AHT10_CONVERSION_MS uma vez e busca os resultados.
+ * @param d  AHT10_NUM_BUSES posições, indexadas pelo barramento.
+ * @param ok AHT10_NUM_BUSES posições: true onde a leitura deu certo.
+ * @return Número de leituras válidas.
+ */
+unsigned aht10_read_all(dados *d, bool *ok);
+
+// ============================================
+// === Amostrador em hardware (opcional) ===
+// ============================================
+/*
+ * Com o SoC gerado com --with-aht10-sampler, o gateware dispara, espera e lê
+ * o AHT10 sozinho no período programado e enfileira as leituras brutas com o
+ * timestamp (us) do disparo. Enquanto ele está ligado, o barramento é do
+ * hardware: não use as funções bitbang acima.
+ */
+#ifdef CSR_I2C_SAMPLER_CONTROL_ADDR
+#define AHT10_HAS_SAMPLER 1
+
+/*
+ * O amostrador substitui só o barramento 0; o colorlight_i5.py recusa
+ * --with-aht10-sampler com mais de um barramento.
+ */
+#if AHT10_NUM_BUSES > 1
+#error "--with-aht10-sampler amostra so o barramento 0: gere o SoC com --aht10-buses 1"
+#endif
+
+/** @brief Amostra retirada do FIFO do amostrador. */
+typedef struct {
+    uint32_t ts_us;     // Timestamp do disparo (contador de us do gateware)
+    dados    d;
+} aht10_sample;
+
+/** @brief Liga a amostragem periódica; a primeira amostra é imediata. */
+void aht10_sampler_start(uint32_t period_ms);
+
+/** @brief Desliga a amostragem periódica (o FIFO é preservado). */
+void aht10_sampler_stop(void);
+
+/** @brief Número de amostras no FIFO. */
+unsigned aht10_sampler_pending(void);
+
+/**
+ * @brief Retira e converte a amostra mais antiga do FIFO.
+ * @return false se o FIFO está vazio.
+ */
+bool aht10_sampler_pop(aht10_sample *s);
+
+/**
+ * @brief Lê e limpa os flags de erro (bits de status do gateware:
+ * overflow, NACK e timeout).
+ * @return 0 se nenhum erro ocorreu desde a última chamada.
+ */
+uint32_t aht10_sampler_errors(void);
+#endif
 
 #endif // AHT10_H_
\ No newline at end of file
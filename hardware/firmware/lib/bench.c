@@ -0,0 +1,226 @@
+#include "bench.h"
+#include "cycles.h"
+#include "rfm95.h"
+#include "aht10.h"
+#include "frame.h"
+#include "aes.h"
+#include "log.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <system.h>
+
+#define BENCH_ITERATIONS 64
+
+/*
+ * Cada linha começa com "BENCH" para ser extraída do log do terminal por
+ * hardware/tools/bench_matrix.py, que monta a tabela entre perfis.
+ */
+static void bench_report(const char *name, uint64_t total, unsigned n) {
+    uint32_t avg = (uint32_t)(total / n);
+    printf("BENCH %-22s %10lu ciclos %8lu us\n", name,
+           (unsigned long)avg, (unsigned long)cycles_to_us(avg));
+}
+
+static void bench_header(void) {
+#ifdef SOC_PROFILE
+    const char *profile = SOC_PROFILE;
+#else
+    const char *profile = "custom";
+#endif
+#ifdef CONFIG_L2_SIZE
+    unsigned long l2 = CONFIG_L2_SIZE;
+#else
+    unsigned long l2 = 0;
+#endif
+#ifdef FASTMEM_DISABLE
+    int fastmem = 0;
+#else
+    int fastmem = 1;
+#endif
+    printf("BENCH-SOC profile=%s cpu=%s clk=%lu l2=%lu fastmem=%d\n",
+           profile, CONFIG_CPU_HUMAN_NAME, (unsigned long)CONFIG_CLOCK_FREQUENCY,
+           l2, fastmem);
+}
+
+static void bench_drivers(bool lora_ok, bool sensor_ok) {
+    rfm95_t *r = rfm95_radio(0);
+    uint64_t t0;
+
+    if (lora_ok) {
+        t0 = cycles_now();
+        for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+            (void)rfm95_read_reg(r, 0x42);
+        bench_report("rfm95_read_reg", cycles_now() - t0, BENCH_ITERATIONS);
+
+        t0 = cycles_now();
+        for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+            rfm95_write_reg(r, 0x0D, 0x00); // REG_FIFO_ADDR_PTR
+        bench_report("rfm95_write_reg", cycles_now() - t0, BENCH_ITERATIONS);
+    }
+
+    if (sensor_ok) {
+        t0 = cycles_now();
+        for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+            (void)i2c_probe(i2c_bus(0), 0x38);
+        bench_report("i2c_probe", cycles_now() - t0, BENCH_ITERATIONS);
+    }
+
+    // Nível DEBUG: mede o registro mesmo com o nível padrão (INFO).
+    uint8_t saved = log_level;
+    log_set_level(LOG_LEVEL_DEBUG);
+    t0 = cycles_now();
+    for (unsigned i = 0; i < 16; i++)
+        log_write(LOG_LEVEL_DEBUG, "bench %d", 1, (int)i);
+    bench_report("log_write", cycles_now() - t0, 16);
+    log_set_level(saved);
+
+    // Custo de um ponto de rastreio (0 com TRACE=0); marcas de console vazias.
+    t0 = cycles_now();
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+        TRACE_MARK(TRACE_EV_CONSOLE, 0);
+    bench_report("trace_event", cycles_now() - t0, BENCH_ITERATIONS);
+}
+
+static void bench_sensor(void) {
+    i2c_bus_t *b = i2c_bus(0);
+    dados d;
+    uint64_t t0, trig = 0, fetch = 0;
+
+    // Custo de CPU da leitura: disparo e busca, sem a espera da conversão.
+    for (unsigned i = 0; i < 4; i++) {
+        t0 = cycles_now();
+        aht10_trigger(b);
+        trig += cycles_now() - t0;
+
+        busy_wait(AHT10_CONVERSION_MS);
+
+        t0 = cycles_now();
+        aht10_fetch(b, &d);
+        fetch += cycles_now() - t0;
+    }
+    bench_report("aht10_trigger", trig, 4);
+    bench_report("aht10_fetch", fetch, 4);
+
+    t0 = cycles_now();
+    aht10_get_data(b, &d);
+    bench_report("sensor_read (total)", cycles_now() - t0, 1);
+
+    // Todos os barramentos com uma única espera de conversão.
+    dados all[AHT10_NUM_BUSES];
+    bool  ok[AHT10_NUM_BUSES];
+    t0 = cycles_now();
+    unsigned n = aht10_read_all(all, ok);
+    bench_report("sensor_read_all", cycles_now() - t0, 1);
+    printf("  (%u de %d sensores)\n", n, AHT10_NUM_BUSES);
+}
+
+static void bench_encode(void) {
+    uint8_t buf[FRAME_SAMPLE_LEN];
+    volatile size_t sink = 0;
+    uint64_t t0 = cycles_now();
+
+    for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+        sink += frame_encode_sample(buf, (int16_t)(2500 + i), (int16_t)(6000 - i));
+    bench_report("frame_encode", cycles_now() - t0, BENCH_ITERATIONS);
+    (void)sink;
+}
+
+// Cifragem em software x core do gateware: um bloco e o quadro de rastreio
+// completo (CTR + CMAC, frame_seal()), que é o custo por quadro no TX.
+static void bench_aes(void) {
+    static const uint8_t key[AES_KEY_LEN] = {
+        0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+    };
+    aes_key_t  k;
+    frame_keys fk;
+    uint8_t    blk[AES_BLOCK_LEN] = {0};
+    uint8_t    buf[FRAME_TRACE_LEN + FRAME_SECURE_OVERHEAD];
+    uint8_t    ref[sizeof(buf)];
+    uint64_t   t0;
+
+    for (int hw = 0; hw <= 1; hw++) {
+        if (hw && !aes_hw_available()) {
+            printf("  (aes: SoC sem o core, rode com --with-aes)\n");
+            break;
+        }
+        aes_use_hw(hw);
+        aes_set_key(&k, key);
+        frame_keys_init(&fk, key);
+
+        t0 = cycles_now();
+        for (unsigned i = 0; i < BENCH_ITERATIONS; i++)
+            aes_encrypt_block(&k, blk, blk);
+        bench_report(hw ? "aes_block_hw" : "aes_block_sw", cycles_now() - t0, BENCH_ITERATIONS);
+
+        t0 = cycles_now();
+        for (unsigned i = 0; i < BENCH_ITERATIONS; i++) {
+            size_t len = frame_encode_trace(buf, 1, 0, (int16_t)(2500 + i), 6000);
+            frame_seal(buf, len, &fk, 1, i + 1);
+        }
+        bench_report(hw ? "frame_seal_hw" : "frame_seal_sw", cycles_now() - t0, BENCH_ITERATIONS);
+
+        // O último quadro tem que sair igual nos dois caminhos.
+        if (!hw) memcpy(ref, buf, sizeof(buf));
+        else if (memcmp(ref, buf, sizeof(buf)) != 0)
+            printf("  (aes: core diverge do software!)\n");
+    }
+    aes_use_hw(true);
+}
+
+static void bench_spi_burst(void) {
+    static uint8_t payload[255];
+    rfm95_t *r = rfm95_radio(0);
+    uint64_t t0, total = 0;
+
+    for (unsigned i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)i;
+
+    for (unsigned i = 0; i < 8; i++) {
+        rfm95_write_reg(r, 0x0D, 0x00); // REG_FIFO_ADDR_PTR
+        t0 = cycles_now();
+        rfm95_write_fifo(r, payload, sizeof(payload));
+        total += cycles_now() - t0;
+    }
+    bench_report("spi_burst_255B", total, 8);
+
+#ifdef CSR_RFM95_DMA_BASE
+    // Mesma carga pelo DMA: custo de CPU para iniciar e total até o fim.
+    uint64_t start = 0;
+    total = 0;
+    for (unsigned i = 0; i < 8; i++) {
+        t0 = cycles_now();
+        rfm95_dma_start(payload, sizeof(payload));
+        start += cycles_now() - t0;
+        rfm95_dma_wait();
+        total += cycles_now() - t0;
+    }
+    bench_report("dma_start_255B", start, 8);
+    bench_report("dma_load_255B", total, 8);
+#endif
+}
+
+static void bench_end_to_end(void) {
+    uint8_t buf[FRAME_SAMPLE_LEN];
+    dados d;
+    uint64_t t0 = cycles_now();
+
+    // Ciclo completo de uma amostra: leitura, codificação e TX até o TxDone.
+    if (!aht10_get_data(i2c_bus(0), &d)) return;
+    frame_encode_sample(buf, d.temperatura, d.umidade);
+    rfm95_send_bytes(rfm95_radio(0), buf, sizeof(buf));
+    bench_report("sample_cycle (e2e)", cycles_now() - t0, 1);
+}
+
+void bench_run(bool lora_ok, bool sensor_ok) {
+    bench_header();
+    bench_drivers(lora_ok, sensor_ok);
+    bench_encode();
+    bench_aes();
+    if (sensor_ok) bench_sensor();
+    else           printf("  (sensor: rode 'sensor_setup')\n");
+    if (lora_ok)   bench_spi_burst();
+    else           printf("  (rfm95: rode 'lora_setup')\n");
+    if (lora_ok && sensor_ok) bench_end_to_end();
+}
@@ -0,0 +1,16 @@
+// ./lib/bench.h
+#pragma once
+#include <stdbool.h>
+
+/**
+ * @brief Suíte de benchmarks do nó: latência dos drivers, leitura do
+ * sensor, codificação do quadro, rajada SPI de 255 bytes e o ciclo completo
+ * de uma amostra (leitura + codificação + TX).
+ *
+ * Imprime um cabeçalho BENCH-SOC com perfil/CPU/clock/L2 e uma linha BENCH
+ * por medida, para comparar perfis do SoC (hardware/tools/bench_matrix.py)
+ * e builds com/sem FASTMEM.
+ * @param lora_ok   Rádio inicializado (lora_setup).
+ * @param sensor_ok I2C inicializado (sensor_setup).
+ */
+void bench_run(bool lora_ok, bool sensor_ok);
@@ -0,0 +1,73 @@
+#include "config.h"
+#include "log.h"
+
+#include <string.h>
+#include <generated/csr.h>
+#include <generated/mem.h>
+#include <generated/soc.h>
+#include <libbase/crc.h>
+#include <system.h>
+#ifdef CSR_SPIFLASH_CORE_MASTER_CS_ADDR
+#include <liblitespi/spiflash.h>
+#endif
+
+#define CONFIG_SECTOR_SIZE 4096
+
+typedef struct {
+    uint32_t    magic;
+    uint32_t    size;   // sizeof(fw_config_t) de quem gravou
+    uint32_t    crc;    // crc32 do corpo
+    fw_config_t body;
+} config_block_t;
+
+void config_defaults(fw_config_t *cfg) {
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->flags            = 0;
+    cfg->sample_period_ms = 10000;
+
+    cfg->report_oversample   = 3;
+    cfg->report_iir_shift    = 2;
+    cfg->report_deadband_t   = 20;      // 0,20 C
+    cfg->report_deadband_h   = 100;     // 1,00 %
+    cfg->report_heartbeat_ms = 300000;  // 5 min
+
+    cfg->gw_port             = 5400;
+}
+
+bool config_load(fw_config_t *cfg) {
+    config_defaults(cfg);
+#ifdef FLASH_CONFIG_ADDRESS
+    const config_block_t *blk = (const config_block_t *)FLASH_CONFIG_ADDRESS;
+
+    if (blk->magic != CONFIG_MAGIC) return false;
+    if (blk->size == 0 || blk->size > CONFIG_SECTOR_SIZE - 12) return false;
+    if (crc32((const unsigned char *)&blk->body, blk->size) != blk->crc) {
+        LOG_WARN("Bloco de configuracao com CRC invalido, usando padroes");
+        return false;
+    }
+    memcpy(cfg, &blk->body, blk->size < sizeof(*cfg) ? blk->size : sizeof(*cfg));
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool config_save(const fw_config_t *cfg) {
+#if defined(FLASH_CONFIG_ADDRESS) && defined(CSR_SPIFLASH_CORE_MASTER_CS_ADDR)
+    config_block_t blk;
+    uint32_t offset = FLASH_CONFIG_ADDRESS - SPIFLASH_BASE;
+
+    blk.magic = CONFIG_MAGIC;
+    blk.size  = sizeof(blk.body);
+    blk.body  = *cfg;
+    blk.crc   = crc32((const unsigned char *)&blk.body, sizeof(blk.body));
+
+    spiflash_erase_range(offset, CONFIG_SECTOR_SIZE);
+    spiflash_write_stream(offset, (uint8_t *)&blk, sizeof(blk));
+    flush_cpu_dcache();
+    return true;
+#else
+    (void)cfg;
+    return false;
+#endif
+}
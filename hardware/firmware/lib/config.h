@@ -0,0 +1,65 @@
+// ./lib/config.h
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+// ============================================
+// === Bloco de configuração persistente ===
+// ============================================
+/*
+ * Guardado em um setor de 4 KB da flash SPI, logo antes da imagem de boot
+ * (FLASH_CONFIG_ADDRESS, definido pelo SoC). O cabeçalho leva o tamanho do
+ * corpo, então versões novas do firmware podem acrescentar campos no fim:
+ * o que não estiver gravado fica com o valor padrão.
+ */
+
+#define CONFIG_MAGIC            0x31474643u  // "CFG1"
+
+#define CFG_AUTOSTART_LORA      (1u << 0)
+#define CFG_AUTOSTART_SENSOR    (1u << 1)
+#define CFG_AUTOSTART_SAMPLING  (1u << 2)
+#define CFG_TDMA                (1u << 3)   // Liga o TDMA no boot
+#define CFG_GATEWAY             (1u << 4)   // Modo gateway (LoRa -> UDP) no boot
+#define CFG_TRACE               (1u << 5)   // Quadros de amostra com rastreio de latência
+#define CFG_CRYPT               (1u << 6)   // Quadros cifrados e autenticados (FRAME_TYPE_SECURE)
+
+typedef struct {
+    uint32_t flags;             // CFG_AUTOSTART_*
+    uint32_t sample_period_ms;  // Período da amostragem automática
+
+    // Política de envio (send-on-delta)
+    uint8_t  report_oversample; // Leituras combinadas (mediana) por amostra
+    uint8_t  report_iir_shift;  // Filtro IIR: y += (x - y) >> shift (0 = sem)
+    uint16_t report_deadband_t; // Variação mínima de temperatura (x0.01 C; 0 = sempre envia)
+    uint16_t report_deadband_h; // Variação mínima de umidade (x0.01 %)
+    uint32_t report_heartbeat_ms; // Envio forçado sem variação (0 = nunca)
+
+    uint8_t  node_id;           // Id nos quadros e no mapa de slots TDMA (0 = sem id)
+
+    // Gateway
+    uint16_t gw_port;           // Porta UDP do host
+    uint32_t gw_host;           // IPv4 do host (0 = REMOTEIP do SoC)
+
+    uint8_t  lora_implicit_len; // Quadros deste tamanho sem cabeçalho LoRa (0 = sempre explícito)
+
+    // Quadros cifrados
+    uint8_t  crypt_key[16];     // Chave AES-128 do nó (a mesma no receptor)
+    uint16_t crypt_epoch;       // Época: 16 bits altos da sequência, +1 a cada boot com cifra
+} fw_config_t;
+
+/**
+ * @brief Preenche a configuração com os valores padrão.
+ */
+void config_defaults(fw_config_t *cfg);
+
+/**
+ * @brief Lê a configuração da flash (mapeada em memória).
+ * @return true se havia um bloco válido; false se ficou com os padrões.
+ */
+bool config_load(fw_config_t *cfg);
+
+/**
+ * @brief Apaga o setor e grava a configuração na flash.
+ * @return true em sucesso, false se o SoC não tem acesso de escrita à flash.
+ */
+bool config_save(const fw_config_t *cfg);
@@ -0,0 +1,48 @@
+// ./lib/cycles.h
+#pragma once
+#include <stdint.h>
+#include <generated/csr.h>
+#include <generated/soc.h>
+
+// ============================================
+// === Contador de ciclos (timer0 uptime) ===
+// ============================================
+/*
+ * O SoC é gerado com o contador "uptime" do timer0, que conta ciclos de
+ * sys_clk desde o reset. Sem ele (gateware antigo), retorna sempre 0.
+ */
+
+static inline uint64_t cycles_now(void) {
+#ifdef CSR_TIMER0_UPTIME_CYCLES_ADDR
+    timer0_uptime_latch_write(1);
+    return timer0_uptime_cycles_read();
+#else
+    return 0;
+#endif
+}
+
+/* Converte ciclos em microssegundos (fora de caminhos críticos). */
+static inline uint32_t cycles_to_us(uint64_t cycles) {
+    return (uint32_t)(cycles / (CONFIG_CLOCK_FREQUENCY / 1000000));
+}
+
+/* Converte ciclos em milissegundos (fora de caminhos críticos). */
+static inline uint32_t cycles_to_ms(uint64_t cycles) {
+    return (uint32_t)(cycles / (CONFIG_CLOCK_FREQUENCY / 1000));
+}
+
+/*
+ * Intervalos curtos, para os caminhos de polling: divisão de 32 bits em vez
+ * da chamada a __udivdi3. Com a extensão M é uma instrução divu; sem ela
+ * (picorv32 minimal, VexRiscv lite) vira __udivsi3, ainda bem mais barata
+ * que a de 64 bits. Satura em 2^32 ciclos (71 s a 60 MHz).
+ */
+static inline uint32_t cycles_to_us32(uint64_t cycles) {
+    uint32_t c = cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+    return c / (CONFIG_CLOCK_FREQUENCY / 1000000);
+}
+
+static inline uint32_t cycles_to_ms32(uint64_t cycles) {
+    uint32_t c = cycles > UINT32_MAX ? UINT32_MAX : (uint32_t)cycles;
+    return c / (CONFIG_CLOCK_FREQUENCY / 1000);
+}
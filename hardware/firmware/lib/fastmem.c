@@ -0,0 +1,19 @@
+#include "fastmem.h"
+
+#include <string.h>
+#include <system.h>
+
+// Símbolos definidos em linker.ld
+extern char _ffasttext[], _efasttext[], _ffasttext_rom[];
+extern char _ffastdata[], _efastdata[], _ffastdata_rom[];
+extern char _ffastbss[],  _efastbss[];
+
+void fastmem_init(void) {
+    // Sem fast_sram as seções já executam de onde foram carregadas.
+    if ((void *)_ffasttext != (void *)_ffasttext_rom)
+        memcpy(_ffasttext, _ffasttext_rom, _efasttext - _ffasttext);
+    if ((void *)_ffastdata != (void *)_ffastdata_rom)
+        memcpy(_ffastdata, _ffastdata_rom, _efastdata - _ffastdata);
+    memset(_ffastbss, 0, _efastbss - _ffastbss);
+    flush_cpu_icache();
+}
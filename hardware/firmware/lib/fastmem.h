@@ -0,0 +1,29 @@
+// ./lib/fastmem.h
+#pragma once
+
+// ============================================
+// === Posicionamento na SRAM rápida ===
+// ============================================
+/*
+ * FASTTEXT: função executada da SRAM integrada (fast_sram), fora da SDRAM/L2.
+ * FASTDATA: variável inicializada na SRAM integrada.
+ * FASTBSS:  variável zerada na SRAM integrada (não ocupa espaço na imagem).
+ *
+ * "make FASTMEM=0" define FASTMEM_DISABLE e deixa tudo em main_ram, para
+ * comparar a latência antes/depois com o comando 'bench'.
+ */
+#ifndef FASTMEM_DISABLE
+#define FASTTEXT __attribute__((section(".fasttext"), noinline))
+#define FASTDATA __attribute__((section(".fastdata")))
+#define FASTBSS  __attribute__((section(".fastbss")))
+#else
+#define FASTTEXT
+#define FASTDATA
+#define FASTBSS
+#endif
+
+/**
+ * @brief Copia .fasttext/.fastdata para a SRAM e zera .fastbss.
+ * Deve ser a primeira chamada do main(), antes de qualquer função FASTTEXT.
+ */
+void fastmem_init(void);
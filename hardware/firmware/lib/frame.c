@@ -0,0 +1,96 @@
+#include "frame.h"
+
+#include <string.h>
+
+static inline void put_i16(uint8_t *p, int16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+}
+
+size_t frame_encode_sample(uint8_t *buf, int16_t temperatura, int16_t umidade) {
+    put_i16(&buf[0], temperatura);
+    put_i16(&buf[2], umidade);
+    return FRAME_SAMPLE_LEN;
+}
+
+size_t frame_encode_sample_id(uint8_t *buf, uint8_t node_id, uint8_t sensor,
+                              int16_t temperatura, int16_t umidade) {
+    buf[0] = FRAME_TYPE_SAMPLE;
+    buf[1] = node_id;
+    buf[2] = sensor;
+    put_i16(&buf[3], temperatura);
+    put_i16(&buf[5], umidade);
+    return FRAME_SAMPLE_ID_LEN;
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)((v >> 24) & 0xFF);
+}
+
+size_t frame_encode_trace(uint8_t *buf, uint8_t node_id, uint8_t sensor,
+                          int16_t temperatura, int16_t umidade) {
+    buf[0] = FRAME_TYPE_TRACE;
+    buf[1] = node_id;
+    buf[2] = sensor;
+    put_i16(&buf[3], temperatura);
+    put_i16(&buf[5], umidade);
+    put_u32(&buf[7], 0);
+    put_u32(&buf[11], 0);
+    return FRAME_TRACE_LEN;
+}
+
+void frame_trace_stamp(uint8_t *buf, uint32_t age_us, uint32_t prev_tx_us) {
+    put_u32(&buf[7], age_us);
+    put_u32(&buf[11], prev_tx_us);
+}
+
+void frame_keys_init(frame_keys *keys, const uint8_t key[AES_KEY_LEN]) {
+    aes_key_t master;
+    uint8_t   blk[AES_BLOCK_LEN] = {0};
+    uint8_t   sub[AES_KEY_LEN];
+
+    aes_set_key(&master, key);
+    blk[0] = 0x01;
+    aes_encrypt_block(&master, blk, sub);
+    aes_set_key(&keys->enc, sub);
+    blk[0] = 0x02;
+    aes_encrypt_block(&master, blk, sub);
+    aes_set_key(&keys->mac, sub);
+}
+
+size_t frame_seal(uint8_t *buf, size_t len, const frame_keys *keys, uint8_t node_id, uint32_t seq) {
+    uint8_t ctr[AES_BLOCK_LEN] = {0};
+    uint8_t tag[AES_BLOCK_LEN];
+
+    memmove(&buf[FRAME_SECURE_HDR_LEN], buf, len);
+    buf[0] = FRAME_TYPE_SECURE;
+    buf[1] = node_id;
+    put_u32(&buf[2], seq);
+
+    ctr[0] = 0x01;
+    ctr[1] = node_id;
+    memcpy(&ctr[2], &buf[2], 4);
+    ctr[AES_BLOCK_LEN - 1] = 1;
+    aes_ctr(&keys->enc, ctr, &buf[FRAME_SECURE_HDR_LEN], len);
+
+    // Encrypt-then-MAC: o tag cobre cabeçalho e texto cifrado.
+    aes_cmac(&keys->mac, buf, FRAME_SECURE_HDR_LEN + len, tag);
+    memcpy(&buf[FRAME_SECURE_HDR_LEN + len], tag, FRAME_SECURE_TAG_LEN);
+    return len + FRAME_SECURE_OVERHEAD;
+}
+
+bool frame_decode_beacon(const uint8_t *buf, size_t len, frame_beacon *out) {
+    if (len < FRAME_BEACON_HDR_LEN || buf[0] != FRAME_TYPE_BEACON) return false;
+
+    out->seq     = buf[1];
+    out->slot_ms = (uint16_t)(buf[2] | (buf[3] << 8));
+    out->n_slots = buf[4];
+    if (out->slot_ms == 0 || out->n_slots == 0 || out->n_slots > FRAME_BEACON_MAX_SLOTS) return false;
+    if (len != FRAME_BEACON_HDR_LEN + (size_t)out->n_slots) return false;
+
+    memcpy(out->owner, &buf[FRAME_BEACON_HDR_LEN], out->n_slots);
+    return true;
+}
@@ -0,0 +1,120 @@
+// ./lib/frame.h
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "aes.h"
+
+// ============================================
+// === Formato dos quadros LoRa ===
+// ============================================
+/*
+ * Quadro de amostra (4 bytes, little-endian), como o receptor espera:
+ *   [0..1] temperatura x100 (int16)
+ *   [2..3] umidade x100     (int16)
+ */
+#define FRAME_SAMPLE_LEN 4
+
+/**
+ * @brief Codifica uma amostra no formato do quadro.
+ * @param buf Destino com pelo menos FRAME_SAMPLE_LEN bytes.
+ * @return Número de bytes escritos.
+ */
+size_t frame_encode_sample(uint8_t *buf, int16_t temperatura, int16_t umidade);
+
+/*
+ * Quadro de amostra com id do nó e do sensor (7 bytes), usado quando o nó tem
+ * node_id ou mais de um barramento AHT10:
+ *   [0]    FRAME_TYPE_SAMPLE
+ *   [1]    node_id (0..255)
+ *   [2]    sensor: barramento AHT10 de origem (0..AHT10_NUM_BUSES-1)
+ *   [3..4] temperatura x100 (int16)
+ *   [5..6] umidade x100     (int16)
+ * O receptor ainda aceita a versão de 6 bytes, sem o byte do sensor (sensor 0).
+ */
+#define FRAME_TYPE_SAMPLE   0x53    // 'S'
+#define FRAME_SAMPLE_ID_LEN 7
+
+size_t frame_encode_sample_id(uint8_t *buf, uint8_t node_id, uint8_t sensor,
+                              int16_t temperatura, int16_t umidade);
+
+/*
+ * Quadro de amostra com rastreio de latência (15 bytes), com 'cfg_set trace 1':
+ *   [0]      FRAME_TYPE_TRACE
+ *   [1]      node_id
+ *   [2]      sensor
+ *   [3..4]   temperatura x100 (int16)
+ *   [5..6]   umidade x100     (int16)
+ *   [7..10]  us da amostra pronta na CPU até o início do TX (uint32)
+ *   [11..14] us do TX anterior do mesmo rádio, início -> TxDone (uint32, 0 = nenhum)
+ * Os campos de tempo são preenchidos pelo despachante no rfm95_tx_start():
+ * o relógio do nó não é o do receptor, então viajam durações, não instantes.
+ * O receptor ainda aceita a versão de 14 bytes, sem o byte do sensor.
+ */
+#define FRAME_TYPE_TRACE     0x54    // 'T'
+#define FRAME_TRACE_LEN      15
+
+size_t frame_encode_trace(uint8_t *buf, uint8_t node_id, uint8_t sensor,
+                          int16_t temperatura, int16_t umidade);
+
+/** @brief Grava os campos de tempo num quadro montado por frame_encode_trace(). */
+void frame_trace_stamp(uint8_t *buf, uint32_t age_us, uint32_t prev_tx_us);
+
+/*
+ * Quadro cifrado e autenticado (cfg_set crypt 1), que envolve qualquer um
+ * dos quadros acima (o "interno", de n bytes):
+ *   [0]          FRAME_TYPE_SECURE
+ *   [1]          node_id
+ *   [2..5]       seq (uint32): época << 16 | quadro na época; só cresce
+ *   [6..n+5]     quadro interno cifrado (AES-128-CTR)
+ *   [n+6..n+9]   tag: 4 primeiros bytes do AES-CMAC de [0..n+5]
+ * Bloco do contador do CTR: 0x01, node_id, seq (LE), zeros e o contador de
+ * blocos no byte 15, a partir de 1. As chaves de cifra e de MAC são
+ * derivadas da chave do nó (frame_keys_init()). O receptor recusa seq
+ * menor ou igual ao último aceito do nó (replay).
+ */
+#define FRAME_TYPE_SECURE     0x45    // 'E'
+#define FRAME_SECURE_HDR_LEN  6
+#define FRAME_SECURE_TAG_LEN  4
+#define FRAME_SECURE_OVERHEAD (FRAME_SECURE_HDR_LEN + FRAME_SECURE_TAG_LEN)
+
+typedef struct {
+    aes_key_t enc;              // E_K(0x01 || 0^15)
+    aes_key_t mac;              // E_K(0x02 || 0^15)
+} frame_keys;
+
+/** @brief Deriva as chaves de cifra e de MAC da chave do nó. */
+void frame_keys_init(frame_keys *keys, const uint8_t key[AES_KEY_LEN]);
+
+/**
+ * @brief Cifra e autentica, no lugar, um quadro de 'len' bytes.
+ * @param buf Quadro interno; precisa de len + FRAME_SECURE_OVERHEAD bytes.
+ * @return Tamanho do quadro FRAME_TYPE_SECURE.
+ */
+size_t frame_seal(uint8_t *buf, size_t len, const frame_keys *keys, uint8_t node_id, uint32_t seq);
+
+/*
+ * Beacon TDMA (receptor -> nós):
+ *   [0]    FRAME_TYPE_BEACON
+ *   [1]    seq (incrementa a cada superquadro)
+ *   [2..3] slot_ms (uint16)
+ *   [4]    n_slots
+ *   [5..]  node_id dono de cada slot (0 = livre)
+ * O superquadro tem n_slots + 1 slots: o primeiro é do próprio beacon.
+ */
+#define FRAME_TYPE_BEACON      0xBE
+#define FRAME_BEACON_HDR_LEN   5
+#define FRAME_BEACON_MAX_SLOTS 16
+
+typedef struct {
+    uint8_t  seq;
+    uint16_t slot_ms;
+    uint8_t  n_slots;
+    uint8_t  owner[FRAME_BEACON_MAX_SLOTS];
+} frame_beacon;
+
+/**
+ * @brief Decodifica um beacon.
+ * @return false se o quadro não é um beacon válido.
+ */
+bool frame_decode_beacon(const uint8_t *buf, size_t len, frame_beacon *out);
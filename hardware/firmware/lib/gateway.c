@@ -0,0 +1,148 @@
+#include "gateway.h"
+
+#ifdef GATEWAY_AVAILABLE
+#include "rfm95.h"
+#include "lora_dispatch.h"
+#include "cycles.h"
+#include "log.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <generated/soc.h>
+#include <libliteeth/udp.h>
+
+// MAC localmente administrado; o BIOS usa ...:00, aqui termina em :01.
+static const uint8_t gw_mac[6] = { 0x10, 0xe2, 0xd5, 0x00, 0x00, 0x01 };
+
+static bool     active;
+static uint32_t host;
+static uint16_t host_port;
+
+// O lote fica fora do buffer de TX do MAC: udp_service() o usa para as
+// respostas de ARP.
+static uint8_t  batch[GATEWAY_HDR_LEN + GATEWAY_BATCH_MAX];
+static unsigned batch_len;      // Bytes de registros
+static uint8_t  batch_count;
+static uint64_t batch_first;    // ciclos do primeiro registro
+static uint32_t seq;
+
+static uint32_t rx_frames, datagrams, tx_bytes, send_errors;
+
+static inline void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;         p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+static void gateway_flush(void) {
+    if (batch_count == 0) return;
+
+    batch[0] = 'L';
+    batch[1] = 'G';
+    batch[2] = GATEWAY_VERSION;
+    batch[3] = batch_count;
+    put_u32(&batch[4], seq++);
+
+    unsigned len = GATEWAY_HDR_LEN + batch_len;
+    TRACE_BEGIN(TRACE_EV_GATEWAY_TX, len);
+    memcpy(udp_get_tx_buffer(), batch, len);
+    if (udp_send(GATEWAY_SRC_PORT, host_port, len)) {
+        datagrams++;
+        tx_bytes += len;
+    } else {
+        send_errors++;
+    }
+    TRACE_END(TRACE_EV_GATEWAY_TX, len);
+    batch_len   = 0;
+    batch_count = 0;
+}
+
+bool gateway_start(uint32_t host_ip, uint16_t port) {
+#ifdef LOCALIP1
+    uint32_t local = GATEWAY_IP(LOCALIP1, LOCALIP2, LOCALIP3, LOCALIP4);
+#else
+    uint32_t local = GATEWAY_IP(192, 168, 1, 50);
+#endif
+
+    eth_init();
+    udp_start(gw_mac, local);
+    if (!udp_arp_resolve(host_ip)) {
+        LOG_ERR("Gateway: host nao respondeu ao ARP");
+        return false;
+    }
+
+    host        = host_ip;
+    host_port   = port;
+    batch_len   = 0;
+    batch_count = 0;
+    // Com cabeçalho implícito combinado, os nós mandam quadros de implicit_len.
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++) {
+        if (!dispatch_radio_ok(i)) continue;
+        rfm95_t *r = rfm95_radio(i);
+        r->rx_implicit = r->implicit_len != 0;
+        rfm95_rx_start(r);
+    }
+    active = true;
+    return true;
+}
+
+void gateway_stop(void) {
+    if (!active) return;
+    gateway_flush();
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++)
+        if (dispatch_radio_ok(i)) rfm95_rx_stop(rfm95_radio(i));
+    active = false;
+}
+
+bool gateway_active(void) {
+    return active;
+}
+
+void gateway_service(void) {
+    if (!active) return;
+
+    udp_service();
+
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++) {
+        if (!dispatch_radio_ok(i)) continue;
+        rfm95_t *r = rfm95_radio(i);
+
+        // Sem espaço para o maior quadro: envia antes de tirar do FIFO.
+        if (batch_len + GATEWAY_REC_HDR_LEN + 255 > GATEWAY_BATCH_MAX) gateway_flush();
+
+        uint8_t *rec = &batch[GATEWAY_HDR_LEN + batch_len];
+        int len = rfm95_rx_poll(r, rec + GATEWAY_REC_HDR_LEN, 255);
+        if (len <= 0) continue;
+
+        rec[0] = (uint8_t)len;
+        rec[1] = (uint8_t)i;
+        rec[2] = (uint8_t)(int8_t)(r->rx_rssi < -128 ? -128 : r->rx_rssi);
+        rec[3] = (uint8_t)r->rx_snr;
+        put_u32(&rec[4], cycles_to_ms(r->rx_at));
+
+        if (batch_count == 0) batch_first = r->rx_at;
+        batch_len += GATEWAY_REC_HDR_LEN + len;
+        batch_count++;
+        rx_frames++;
+        LOG_DBG("Gateway: radio %d, %d bytes, RSSI %d", (int)i, len, r->rx_rssi);
+
+        if (batch_count >= GATEWAY_BATCH_RECORDS) gateway_flush();
+    }
+
+    if (batch_count &&
+        cycles_now() - batch_first >= (uint64_t)GATEWAY_FLUSH_MS * (CONFIG_CLOCK_FREQUENCY / 1000))
+        gateway_flush();
+}
+
+void gateway_stats(void) {
+    printf("Gateway %s -> %u.%u.%u.%u:%u\n", active ? "ativo" : "parado",
+           (unsigned)(host >> 24), (unsigned)((host >> 16) & 0xFF),
+           (unsigned)((host >> 8) & 0xFF), (unsigned)(host & 0xFF), host_port);
+    printf("Quadros recebidos: %lu, datagramas: %lu (%lu bytes), falhas de envio: %lu\n",
+           (unsigned long)rx_frames, (unsigned long)datagrams,
+           (unsigned long)tx_bytes, (unsigned long)send_errors);
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++)
+        if (dispatch_radio_ok(i))
+            printf("Radio %u: %lu erros de RX\n", i, (unsigned long)rfm95_radio(i)->rx_errors);
+}
+#endif
@@ -0,0 +1,54 @@
+// ./lib/gateway.h
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <generated/csr.h>
+
+// ============================================
+// === Modo gateway (LoRa -> UDP) ===
+// ============================================
+/*
+ * Com Ethernet no SoC (--with-ethernet), todos os rádios ficam em RX contínuo
+ * e cada quadro recebido vira um registro num lote. O lote sai em um único
+ * datagrama UDP para o host quando enche, quando atinge GATEWAY_BATCH_RECORDS
+ * registros ou GATEWAY_FLUSH_MS depois do primeiro registro.
+ *
+ * Datagrama (little-endian):
+ *   cabeçalho: 'L' 'G' versão(1) n_registros seq(u32)
+ *   registro:  len rádio rssi(i8, dBm) snr(i8, dB) t_ms(u32) dados[len]
+ * O rssi vai como int8 com saturação em -128 dBm. hardware/tools/udp_listener.py
+ * decodifica o formato.
+ */
+#ifdef CSR_ETHMAC_BASE
+#define GATEWAY_AVAILABLE 1
+
+#define GATEWAY_VERSION        1
+#define GATEWAY_HDR_LEN        8
+#define GATEWAY_REC_HDR_LEN    8
+#define GATEWAY_BATCH_MAX      1024   // Bytes de registros por datagrama (< MTU)
+#define GATEWAY_BATCH_RECORDS  32
+#define GATEWAY_FLUSH_MS       200
+#define GATEWAY_SRC_PORT       5400
+#define GATEWAY_DEFAULT_PORT   5400
+
+#define GATEWAY_IP(a, b, c, d) \
+    (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+/**
+ * @brief Sobe a pilha UDP, resolve o host por ARP e coloca os rádios prontos
+ * em RX contínuo.
+ * @return false se o host não respondeu ao ARP.
+ */
+bool gateway_start(uint32_t host_ip, uint16_t port);
+
+/** @brief Envia o lote pendente e desliga o RX dos rádios. */
+void gateway_stop(void);
+
+bool gateway_active(void);
+
+/** @brief Recebe dos rádios, atende ARP e envia o lote quando for a hora. */
+void gateway_service(void);
+
+/** @brief Imprime destino e contadores. */
+void gateway_stats(void);
+#endif
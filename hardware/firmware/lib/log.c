@@ -0,0 +1,108 @@
+#include "log.h"
+#include "cycles.h"
+#include "fastmem.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <irq.h>
+
+// ============================================
+// === Anel de registros binários ===
+// ============================================
+/*
+ * Cada registro guarda só o ponteiro do formato e os argumentos; a
+ * formatação e a escrita na UART acontecem depois, em log_flush().
+ * Quando o anel enche, o registro novo é descartado e contado.
+ */
+typedef struct {
+    uint64_t    ts;                  // Ciclos desde o reset
+    const char *fmt;
+    uint8_t     level;
+    uint8_t     nargs;
+    int32_t     args[LOG_MAX_ARGS];
+} log_rec_t;
+
+FASTDATA uint8_t log_level = LOG_LEVEL_COMPILE;
+
+static FASTBSS log_rec_t ring[LOG_RING_SIZE];
+static FASTBSS volatile uint32_t head;      // Próxima escrita
+static FASTBSS volatile uint32_t tail;      // Próxima leitura
+static FASTBSS volatile uint32_t dropped;
+static uint32_t dropped_reported = 0;
+
+static const char *const level_names[] = { "", "ERRO", "AVISO", "INFO", "DBG" };
+
+FASTTEXT void log_write(uint8_t level, const char *fmt, int nargs, ...) {
+    va_list ap;
+    log_rec_t *r;
+
+#ifdef CONFIG_CPU_HAS_INTERRUPT
+    unsigned int ie = irq_getie();
+    irq_setie(0);
+#endif
+    if (head - tail >= LOG_RING_SIZE) {
+        dropped++;
+#ifdef CONFIG_CPU_HAS_INTERRUPT
+        irq_setie(ie);
+#endif
+        return;
+    }
+    r = &ring[head & (LOG_RING_SIZE - 1)];
+    head++;
+#ifdef CONFIG_CPU_HAS_INTERRUPT
+    irq_setie(ie);
+#endif
+
+    r->ts    = cycles_now();
+    r->fmt   = fmt;
+    r->level = level;
+    r->nargs = (uint8_t)nargs;
+    va_start(ap, nargs);
+    for (int i = 0; i < nargs && i < LOG_MAX_ARGS; i++)
+        r->args[i] = va_arg(ap, int);
+    va_end(ap);
+}
+
+unsigned log_flush(unsigned max) {
+    unsigned n = 0;
+
+    // Só marca quando há o que imprimir: o laço principal chama sempre.
+    if (tail == head && dropped == dropped_reported) return 0;
+    TRACE_BEGIN(TRACE_EV_LOG_FLUSH, head - tail);
+
+    if (dropped != dropped_reported) {
+        printf("[log] %lu registros descartados (anel cheio)\n",
+               (unsigned long)(dropped - dropped_reported));
+        dropped_reported = dropped;
+    }
+
+    while (n < max && tail != head) {
+        log_rec_t *r = &ring[tail & (LOG_RING_SIZE - 1)];
+        uint32_t ms = cycles_to_ms(r->ts);
+
+        printf("[%5lu.%03lu] %s: ", (unsigned long)(ms / 1000),
+               (unsigned long)(ms % 1000), level_names[r->level]);
+        printf(r->fmt, (int)r->args[0], (int)r->args[1],
+               (int)r->args[2], (int)r->args[3]);
+        putchar('\n');
+
+        tail++;
+        n++;
+    }
+    TRACE_END(TRACE_EV_LOG_FLUSH, n);
+    return n;
+}
+
+void log_set_level(uint8_t level) {
+    if (level > LOG_LEVEL_DEBUG) level = LOG_LEVEL_DEBUG;
+    log_level = level;
+}
+
+uint32_t log_dropped(void) {
+    return dropped;
+}
+
+unsigned log_pending(void) {
+    return head - tail;
+}
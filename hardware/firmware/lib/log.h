@@ -0,0 +1,65 @@
+// ./lib/log.h
+#pragma once
+#include <stdint.h>
+
+// ============================================
+// === Níveis de log ===
+// ============================================
+#define LOG_LEVEL_OFF    0
+#define LOG_LEVEL_ERROR  1
+#define LOG_LEVEL_WARN   2
+#define LOG_LEVEL_INFO   3
+#define LOG_LEVEL_DEBUG  4
+
+/**
+ * @brief Nível máximo compilado no binário.
+ * Chamadas acima deste nível são removidas pelo compilador
+ * (make LOG_LEVEL=2, por exemplo).
+ */
+#ifndef LOG_LEVEL_COMPILE
+#define LOG_LEVEL_COMPILE LOG_LEVEL_INFO
+#endif
+
+#define LOG_MAX_ARGS   4
+#define LOG_RING_SIZE  64   // Potência de 2
+
+// ============================================
+// === Protótipos Públicos ===
+// ============================================
+
+/** @brief Nível ativo em tempo de execução (não usar direto, ver log_set_level). */
+extern uint8_t log_level;
+
+/**
+ * @brief Grava um registro binário no anel em RAM (não formata nada).
+ * @param fmt Formato printf; deve ser uma string constante, pois só o
+ *            ponteiro é guardado. Os argumentos são inteiros (int).
+ */
+void log_write(uint8_t level, const char *fmt, int nargs, ...);
+
+/**
+ * @brief Formata e envia pela UART até 'max' registros pendentes.
+ * Deve ser chamada do laço ocioso, nunca de caminhos críticos.
+ * @return Número de registros impressos.
+ */
+unsigned log_flush(unsigned max);
+
+void     log_set_level(uint8_t level);
+uint32_t log_dropped(void);
+unsigned log_pending(void);
+
+// ============================================
+// === Macros ===
+// ============================================
+#define LOG_NARGS_(_0, _1, _2, _3, _4, N, ...) N
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+
+#define LOG_AT(lvl, fmt, ...) do {                                        \
+    if ((lvl) <= LOG_LEVEL_COMPILE && (lvl) <= log_level)                 \
+        log_write((lvl), (fmt), LOG_NARGS(__VA_ARGS__), ##__VA_ARGS__);   \
+} while (0)
+
+#define LOG_ERR(...)   LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN,  __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO,  __VA_ARGS__)
+#define LOG_DBG(...)   LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
@@ -0,0 +1,160 @@
+#include "lora_dispatch.h"
+#include "rfm95.h"
+#include "tdma.h"
+#include "frame.h"
+#include "cycles.h"
+#include "log.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    uint8_t  len;
+    uint8_t  data[DISPATCH_FRAME_MAX];
+    uint64_t t_sample;          // ciclos; 0 = quadro sem rastreio
+    bool     sealed;            // Já cifrado (um TX recusado não cifra de novo)
+} dispatch_frame;
+
+typedef struct {
+    bool     ok;
+    uint32_t sent;
+    uint32_t timeouts;
+    uint32_t last_tx_us;        // Último TX, início -> TxDone (precisão do polling)
+} dispatch_radio_stats;
+
+static dispatch_frame       queue[DISPATCH_QUEUE_LEN];
+static unsigned             q_head, q_tail;     // head: escrita, tail: leitura
+static dispatch_radio_stats stats[RFM95_NUM_RADIOS];
+static unsigned             next_radio;
+static uint32_t             total_sent, dropped;
+
+static const frame_keys    *seal_keys;
+static uint8_t              seal_node;
+static uint32_t             seal_seq;
+
+unsigned dispatch_init(void) {
+    unsigned ready = 0;
+
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++) {
+        stats[i].ok = rfm95_init(rfm95_radio(i), LORA_CHANNEL_HZ(i));
+        if (stats[i].ok) ready++;
+    }
+    q_head = q_tail = 0;
+    next_radio = 0;
+    return ready;
+}
+
+bool dispatch_send(const uint8_t *data, size_t len) {
+    return dispatch_send_traced(data, len, 0);
+}
+
+bool dispatch_send_traced(const uint8_t *data, size_t len, uint64_t t_sample) {
+    size_t max = seal_keys ? DISPATCH_FRAME_MAX - FRAME_SECURE_OVERHEAD : DISPATCH_FRAME_MAX;
+    if (len == 0 || len > max) return false;
+    if (q_head - q_tail >= DISPATCH_QUEUE_LEN) {
+        dropped++;
+        TRACE_MARK(TRACE_EV_TX_DROP, len);
+        LOG_WARN("Fila de TX cheia: quadro descartado");
+        return false;
+    }
+
+    dispatch_frame *f = &queue[q_head & (DISPATCH_QUEUE_LEN - 1)];
+    memcpy(f->data, data, len);
+    f->len = (uint8_t)len;
+    f->t_sample = t_sample;
+    f->sealed = false;
+    q_head++;
+    TRACE_COUNT(TRACE_EV_TX_QUEUE, q_head - q_tail);
+
+    // Começa já se houver rádio livre.
+    dispatch_service();
+    return true;
+}
+
+void dispatch_service(void) {
+    // 1. Conclui os TX em andamento.
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++) {
+        if (!stats[i].ok) continue;
+        switch (rfm95_tx_poll(rfm95_radio(i))) {
+        case RFM95_TX_DONE:
+            stats[i].sent++;
+            total_sent++;
+            stats[i].last_tx_us = cycles_to_us32(cycles_now() - rfm95_radio(i)->tx_start);
+            break;
+        case RFM95_TX_TIMEOUT: stats[i].timeouts++;           break;
+        default:                                              break;
+        }
+    }
+
+    // 2. Distribui a fila em rodízio pelos rádios livres (com TDMA, só no slot
+    //    e só se o quadro, já com a cifra, terminar antes do fim do slot).
+    if (q_tail == q_head) return;
+    uint64_t now = cycles_now();
+    for (unsigned n = 0; n < RFM95_NUM_RADIOS && q_tail != q_head; n++) {
+        unsigned i = next_radio;
+        rfm95_t *r = rfm95_radio(i);
+
+        next_radio = (next_radio + 1) % RFM95_NUM_RADIOS;
+        if (!stats[i].ok || r->tx_busy) continue;
+
+        dispatch_frame *f = &queue[q_tail & (DISPATCH_QUEUE_LEN - 1)];
+        bool seal = seal_keys && !f->sealed && f->len + FRAME_SECURE_OVERHEAD <= DISPATCH_FRAME_MAX;
+        size_t tx_len = f->len + (seal ? FRAME_SECURE_OVERHEAD : 0);
+        if (!tdma_frame_fits(r, tx_len)) {
+            q_tail++;
+            dropped++;
+            TRACE_MARK(TRACE_EV_TX_DROP, tx_len);
+            LOG_WARN("TDMA: quadro de %d bytes maior que o slot: descartado", (int)tx_len);
+            continue;
+        }
+        if (!tdma_can_send(now, r, tx_len)) continue;
+
+        // Carimbo o mais perto possível do TX: a espera na fila e no slot conta.
+        if (f->t_sample && !f->sealed)
+            frame_trace_stamp(f->data, cycles_to_us32(cycles_now() - f->t_sample),
+                              stats[i].last_tx_us);
+        if (seal) {
+            TRACE_BEGIN(TRACE_EV_SEAL, f->len);
+            f->len = (uint8_t)frame_seal(f->data, f->len, seal_keys, seal_node, ++seal_seq);
+            f->sealed = true;
+            TRACE_END(TRACE_EV_SEAL, f->len);
+        }
+        if (rfm95_tx_start(r, f->data, f->len)) {
+            q_tail++;
+            TRACE_COUNT(TRACE_EV_TX_QUEUE, q_head - q_tail);
+        }
+    }
+}
+
+void dispatch_set_seal(const frame_keys *keys, uint8_t node_id, uint32_t seq) {
+    seal_keys = keys;
+    seal_node = node_id;
+    seal_seq  = seq;
+}
+
+uint32_t dispatch_seal_seq(void) {
+    return seal_seq;
+}
+
+bool dispatch_radio_ok(unsigned id) {
+    return id < RFM95_NUM_RADIOS && stats[id].ok;
+}
+
+uint32_t dispatch_sent(void) {
+    return total_sent;
+}
+
+void dispatch_stats(void) {
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++) {
+        rfm95_t *r = rfm95_radio(i);
+        printf("Radio %u: %s, %lu kHz, %lu enviados, %lu timeouts, ultimo TX %lu us%s\n", i,
+               stats[i].ok ? "ok" : "falhou",
+               (unsigned long)(LORA_CHANNEL_HZ(i) / 1000),
+               (unsigned long)stats[i].sent, (unsigned long)stats[i].timeouts,
+               (unsigned long)stats[i].last_tx_us,
+               r->tx_busy ? " (transmitindo)" : "");
+    }
+    printf("Fila: %u de %d, %lu descartados\n",
+           q_head - q_tail, DISPATCH_QUEUE_LEN, (unsigned long)dropped);
+}
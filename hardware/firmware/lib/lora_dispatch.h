@@ -0,0 +1,70 @@
+// ./lib/lora_dispatch.h
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "frame.h"
+
+// ============================================
+// === Plano de canais ===
+// ============================================
+/*
+ * O rádio N transmite no canal N: LORA_CHANNEL_BASE_HZ + N * LORA_CHANNEL_STEP_HZ
+ * (passo de 200 kHz para BW de 125 kHz). O receptor usa o mesmo plano
+ * (software/inc/rfm96.h); cada receptor escuta um canal.
+ */
+#define LORA_CHANNEL_BASE_HZ 915000000u
+#define LORA_CHANNEL_STEP_HZ 200000u
+#define LORA_CHANNEL_HZ(ch)  (LORA_CHANNEL_BASE_HZ + (uint32_t)(ch) * LORA_CHANNEL_STEP_HZ)
+
+// ============================================
+// === Despachante de quadros ===
+// ============================================
+#define DISPATCH_QUEUE_LEN  8     // Potência de 2
+#define DISPATCH_FRAME_MAX  64
+
+/**
+ * @brief Inicializa todos os rádios, cada um no seu canal.
+ * @return Número de rádios prontos (0 = nenhum).
+ */
+unsigned dispatch_init(void);
+
+/**
+ * @brief Copia o quadro para a fila; ele sai pelo próximo rádio livre
+ * (rodízio entre os rádios prontos).
+ * @return false se a fila está cheia ou o quadro é maior que DISPATCH_FRAME_MAX.
+ */
+bool dispatch_send(const uint8_t *data, size_t len);
+
+/**
+ * @brief Como dispatch_send(), para quadros FRAME_TYPE_TRACE: no início do TX
+ * o despachante grava no quadro o tempo desde 't_sample' (ciclos) e a duração
+ * do TX anterior do rádio escolhido (frame_trace_stamp()).
+ */
+bool dispatch_send_traced(const uint8_t *data, size_t len, uint64_t t_sample);
+
+/**
+ * @brief Liga a cifra dos quadros (frame_seal()) no início do TX, depois do
+ * carimbo de rastreio; keys NULL desliga. Cada quadro usa o número de
+ * sequência seguinte a 'seq' (o último usado).
+ */
+void dispatch_set_seal(const frame_keys *keys, uint8_t node_id, uint32_t seq);
+
+/** @brief Último número de sequência usado num quadro cifrado. */
+uint32_t dispatch_seal_seq(void);
+
+/**
+ * @brief Verifica os TX em andamento e inicia os quadros da fila nos rádios
+ * livres; com TDMA ligado, só dentro dos slots do nó (lib/tdma.h). Chamar no
+ * laço principal.
+ */
+void dispatch_service(void);
+
+/** @brief true se o rádio 'id' passou pelo dispatch_init(). */
+bool dispatch_radio_ok(unsigned id);
+
+/** @brief Total de quadros com TxDone desde o boot. */
+uint32_t dispatch_sent(void);
+
+/** @brief Imprime canal e contadores de cada rádio. */
+void dispatch_stats(void);
@@ -1,9 +1,14 @@
 // ==== rfm95.c (driver corrigido) ====
 #include "./rfm95.h"
+#include "./log.h"
+#include "./fastmem.h"
+#include "./cycles.h"
+#include "./trace.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <generated/csr.h>
+#include <generated/mem.h>
 #include <system.h>
 #include <stddef.h>
 #include <stdbool.h>
@@ -24,8 +29,12 @@
 #define REG_FIFO_ADDR_PTR        0x0D
 #define REG_FIFO_TX_BASE_ADDR    0x0E
 #define REG_FIFO_RX_BASE_ADDR    0x0F
+#define REG_FIFO_RX_CURRENT_ADDR 0x10
 #define REG_IRQ_FLAGS_MASK       0x11
 #define REG_IRQ_FLAGS            0x12
+#define REG_RX_NB_BYTES          0x13
+#define REG_PKT_SNR_VALUE        0x19
+#define REG_PKT_RSSI_VALUE       0x1A
 #define REG_MODEM_CONFIG_1       0x1D
 #define REG_MODEM_CONFIG_2       0x1E
 #define REG_PREAMBLE_MSB         0x20
@@ -41,15 +50,102 @@
 #define MODE_SLEEP               0x00
 #define MODE_STDBY               0x01
 #define MODE_TX                  0x03
+#define MODE_RX_CONTINUOUS       0x05
 
 #define IRQ_TX_DONE_MASK         0x08
+#define IRQ_PAYLOAD_CRC_ERROR    0x20
+#define IRQ_RX_DONE_MASK         0x40
+
+// ============================================
+// === Acesso aos CSRs por instância ===
+// ============================================
+/*
+ * Todos os SPIMaster/GPIO têm o mesmo layout: o endereço de cada CSR é a base
+ * da instância mais o deslocamento medido nos CSRs do rádio 0.
+ */
+#define SPI_CONTROL  (CSR_SPI_CONTROL_ADDR - CSR_SPI_BASE)
+#define SPI_STATUS   (CSR_SPI_STATUS_ADDR  - CSR_SPI_BASE)
+#define SPI_MOSI     (CSR_SPI_MOSI_ADDR    - CSR_SPI_BASE)
+#define SPI_MISO     (CSR_SPI_MISO_ADDR    - CSR_SPI_BASE)
+#define SPI_CS       (CSR_SPI_CS_ADDR      - CSR_SPI_BASE)
+#ifdef CSR_SPI_LOOPBACK_ADDR
+#define SPI_LOOPBACK (CSR_SPI_LOOPBACK_ADDR - CSR_SPI_BASE)
+#endif
+#ifdef CSR_LORA_RESET_BASE
+#define RESET_OUT    (CSR_LORA_RESET_OUT_ADDR - CSR_LORA_RESET_BASE)
+#endif
+#ifdef CSR_LORA_DIO0_BASE
+#define DIO0_IN      (CSR_LORA_DIO0_IN_ADDR - CSR_LORA_DIO0_BASE)
+#endif
+
+/*
+ * Janela mapeada em memória (--with-lora-regs, só no rádio 0): o registrador
+ * 'reg' é a palavra 'reg' da região 'rfm' e o gateware faz a transação SPI.
+ * Escritas são postadas; leituras esperam as escritas pendentes. A palavra
+ * 128 escolhe o registrador pré-lido continuamente (bit 7 = habilita).
+ */
+#define RFM_PREFETCH        128
+#define RFM_PREFETCH_ENABLE 0x80
+
+static rfm95_t radios[RFM95_NUM_RADIOS] = {
+    {
+        .spi   = CSR_SPI_BASE,
+#ifdef CSR_LORA_RESET_BASE
+        .reset = CSR_LORA_RESET_BASE,
+#endif
+#ifdef CSR_LORA_DIO0_BASE
+        .dio0  = CSR_LORA_DIO0_BASE,
+#endif
+#ifdef RFM_BASE
+        .regs  = (volatile uint32_t *)RFM_BASE,
+#endif
+#ifdef CSR_RFM95_DMA_BASE
+        .dma   = true,
+#endif
+        .id    = 0,
+    },
+#if RFM95_NUM_RADIOS > 1
+    {
+        .spi   = CSR_LORA1_SPI_BASE,
+        .reset = CSR_LORA1_RESET_BASE,
+#ifdef CSR_LORA1_DIO0_BASE
+        .dio0  = CSR_LORA1_DIO0_BASE,
+#endif
+        .id    = 1,
+    },
+#endif
+#if RFM95_NUM_RADIOS > 2
+    {
+        .spi   = CSR_LORA2_SPI_BASE,
+        .reset = CSR_LORA2_RESET_BASE,
+#ifdef CSR_LORA2_DIO0_BASE
+        .dio0  = CSR_LORA2_DIO0_BASE,
+#endif
+        .id    = 2,
+    },
+#endif
+#if RFM95_NUM_RADIOS > 3
+    {
+        .spi   = CSR_LORA3_SPI_BASE,
+        .reset = CSR_LORA3_RESET_BASE,
+#ifdef CSR_LORA3_DIO0_BASE
+        .dio0  = CSR_LORA3_DIO0_BASE,
+#endif
+        .id    = 3,
+    },
+#endif
+};
+
+// BW -> código de REG_MODEM_CONFIG_1[7:4]
+static const uint32_t bw_table[] = {
+    7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000
+};
 
 static void busy_wait_ms_local(unsigned int ms);
-static void spi_init(void);
-static inline void rfm95_select(void);
-static inline void rfm95_deselect(void);
-static inline uint8_t rfm95_txrx(uint8_t tx_byte);
-static void rfm95_write_fifo(const uint8_t *data, uint8_t len);
+static void spi_init(rfm95_t *r);
+static inline void rfm95_select(rfm95_t *r);
+static inline void rfm95_deselect(rfm95_t *r);
+static FASTTEXT uint8_t rfm95_txrx(rfm95_t *r, uint8_t tx_byte);
 
 static void busy_wait_ms_local(unsigned int ms) {
     for (unsigned int i = 0; i < ms; ++i) {
@@ -61,145 +157,371 @@ static void busy_wait_ms_local(unsigned int ms) {
     }
 }
 
-static void spi_init(void) {
-    spi_cs_write(SPI_MODE_MANUAL | 0x0000);
-#ifdef CSR_SPI_LOOPBACK_ADDR
-    spi_loopback_write(0);
+static void spi_init(rfm95_t *r) {
+    csr_write_simple(SPI_MODE_MANUAL | 0x0000, r->spi + SPI_CS);
+#ifdef SPI_LOOPBACK
+    csr_write_simple(0, r->spi + SPI_LOOPBACK);
 #endif
     busy_wait_ms_local(1);
 }
 
-static inline void rfm95_select(void) {
-    spi_cs_write(SPI_MODE_MANUAL | SPI_CS_MASK);
+static inline void rfm95_select(rfm95_t *r) {
+    csr_write_simple(SPI_MODE_MANUAL | SPI_CS_MASK, r->spi + SPI_CS);
     busy_wait_us(2);
 }
 
-static inline void rfm95_deselect(void) {
-    spi_cs_write(SPI_MODE_MANUAL | 0x0000);
+static inline void rfm95_deselect(rfm95_t *r) {
+    csr_write_simple(SPI_MODE_MANUAL | 0x0000, r->spi + SPI_CS);
     busy_wait_us(2);
 }
 
-static inline uint8_t rfm95_txrx(uint8_t tx_byte) {
+static FASTTEXT uint8_t rfm95_txrx(rfm95_t *r, uint8_t tx_byte) {
     uint32_t rx_byte;
-    spi_mosi_write((uint32_t)tx_byte);
-    spi_control_write(
+    csr_write_simple((uint32_t)tx_byte, r->spi + SPI_MOSI);
+    csr_write_simple(
         (1 << CSR_SPI_CONTROL_START_OFFSET) |
-        (8 << CSR_SPI_CONTROL_LENGTH_OFFSET)
+        (8 << CSR_SPI_CONTROL_LENGTH_OFFSET),
+        r->spi + SPI_CONTROL
     );
-    while ((spi_status_read() & (1 << CSR_SPI_STATUS_DONE_OFFSET)) == 0) { }
-    rx_byte = spi_miso_read();
+    while ((csr_read_simple(r->spi + SPI_STATUS) & (1 << CSR_SPI_STATUS_DONE_OFFSET)) == 0) { }
+    rx_byte = csr_read_simple(r->spi + SPI_MISO);
     return (uint8_t)(rx_byte & 0xFF);
 }
 
-static void rfm95_write_fifo(const uint8_t *data, uint8_t len) {
-    rfm95_select();
-    rfm95_txrx(REG_FIFO | 0x80);
+static inline void rfm95_prefetch(rfm95_t *r, uint32_t value) {
+    if (r->regs) r->regs[RFM_PREFETCH] = value;
+}
+
+/* ===== API ===== */
+
+rfm95_t *rfm95_radio(unsigned id) {
+    return id < RFM95_NUM_RADIOS ? &radios[id] : NULL;
+}
+
+FASTTEXT void rfm95_write_fifo(rfm95_t *r, const uint8_t *data, uint8_t len) {
+    if (r->regs) {
+        // Cada escrita em REG_FIFO avança o ponteiro do FIFO no rádio.
+        for (uint8_t i = 0; i < len; i++) {
+            r->regs[REG_FIFO] = data[i];
+        }
+        return;
+    }
+    rfm95_select(r);
+    rfm95_txrx(r, REG_FIFO | 0x80);
     for (uint8_t i = 0; i < len; i++) {
-        rfm95_txrx(data[i]);
+        rfm95_txrx(r, data[i]);
     }
-    rfm95_deselect();
+    rfm95_deselect(r);
 }
 
-/* ===== API ===== */
+static FASTTEXT void rfm95_read_fifo(rfm95_t *r, uint8_t *data, uint8_t len) {
+    if (r->regs) {
+        for (uint8_t i = 0; i < len; i++) {
+            data[i] = (uint8_t)r->regs[REG_FIFO];
+        }
+        return;
+    }
+    rfm95_select(r);
+    rfm95_txrx(r, REG_FIFO & 0x7F);
+    for (uint8_t i = 0; i < len; i++) {
+        data[i] = rfm95_txrx(r, 0x00);
+    }
+    rfm95_deselect(r);
+}
 
-uint8_t rfm95_read_reg(uint8_t reg) {
+FASTTEXT uint8_t rfm95_read_reg(rfm95_t *r, uint8_t reg) {
     uint8_t val;
-    rfm95_select();
-    rfm95_txrx(reg & 0x7F);
-    val = rfm95_txrx(0x00);
-    rfm95_deselect();
+    if (r->regs) return (uint8_t)r->regs[reg & 0x7F];
+    rfm95_select(r);
+    rfm95_txrx(r, reg & 0x7F);
+    val = rfm95_txrx(r, 0x00);
+    rfm95_deselect(r);
     return val;
 }
 
-void rfm95_write_reg(uint8_t reg, uint8_t value) {
-    rfm95_select();
-    rfm95_txrx(reg | 0x80);
-    rfm95_txrx(value);
-    rfm95_deselect();
+FASTTEXT void rfm95_write_reg(rfm95_t *r, uint8_t reg, uint8_t value) {
+    if (r->regs) {
+        r->regs[reg & 0x7F] = value;
+        return;
+    }
+    rfm95_select(r);
+    rfm95_txrx(r, reg | 0x80);
+    rfm95_txrx(r, value);
+    rfm95_deselect(r);
+}
+
+#ifdef CSR_RFM95_DMA_BASE
+/*
+ * O DMA lê o quadro pelo barramento: as escritas da CPU já estão lá (a D$ do
+ * VexRiscv é write-through e o picorv32 não tem cache), então não há flush.
+ */
+void rfm95_dma_start(const uint8_t *data, uint8_t len) {
+    rfm95_dma_ev_pending_write(rfm95_dma_ev_pending_read());
+    rfm95_dma_address_write((uint32_t)(uintptr_t)data);
+    rfm95_dma_length_write(len);
+    rfm95_dma_control_write(1 << CSR_RFM95_DMA_CONTROL_START_OFFSET);
 }
 
-void rfm95_set_mode(uint8_t mode) {
-    rfm95_write_reg(REG_OP_MODE, (0x80 | mode));
+bool rfm95_dma_wait(void) {
+    uint32_t status;
+    while ((status = rfm95_dma_status_read()) & (1 << CSR_RFM95_DMA_STATUS_BUSY_OFFSET)) { }
+    rfm95_dma_ev_pending_write(rfm95_dma_ev_pending_read());
+    return (status & (1 << CSR_RFM95_DMA_STATUS_ERROR_OFFSET)) == 0;
 }
+#endif
 
-bool rfm95_init(void) {
-    spi_init();
+void rfm95_set_mode(rfm95_t *r, uint8_t mode) {
+    rfm95_write_reg(r, REG_OP_MODE, (0x80 | mode));
+}
 
-#ifdef CSR_LORA_RESET_BASE
-    lora_reset_out_write(0); busy_wait_ms_local(5);
-    lora_reset_out_write(1); busy_wait_ms_local(10);
+void rfm95_set_frequency(rfm95_t *r, uint32_t hz) {
+    /* FRF = Freq * 2^19 / 32e6 */
+    uint64_t frf = ((uint64_t)hz << 19) / 32000000;
+    rfm95_write_reg(r, REG_FRF_MSB, (uint8_t)(frf >> 16));
+    rfm95_write_reg(r, REG_FRF_MID, (uint8_t)(frf >> 8));
+    rfm95_write_reg(r, REG_FRF_LSB, (uint8_t)(frf >> 0));
+    r->frequency = hz;
+}
+
+bool rfm95_ldro_required(uint8_t sf, uint32_t bw_hz) {
+    // Tsym = 2^SF / BW > 16 ms
+    return (1000u << sf) > 16u * bw_hz;
+}
+
+uint32_t rfm95_airtime_us(const rfm95_t *r, size_t len, bool implicit) {
+    uint32_t tsym = (uint32_t)(((uint64_t)1000000 << r->sf) / r->bw_hz);
+    int de  = rfm95_ldro_required(r->sf, r->bw_hz) ? 1 : 0;
+    int num = 8 * (int)len - 4 * r->sf + 28 + 16 - (implicit ? 20 : 0);
+    int den = 4 * (r->sf - 2 * de);
+    int n   = num > 0 ? ((num + den - 1) / den) * (r->cr + 4) : 0;
+
+    // Preâmbulo: n_preamble + 4,25 símbolos (em quartos de símbolo).
+    return ((4u * r->preamble + 17u) * tsym) / 4u + (uint32_t)(8 + n) * tsym;
+}
+
+static uint8_t rfm95_modem_config_1(rfm95_t *r, bool implicit) {
+    uint8_t bw = 7;
+    for (uint8_t i = 0; i < sizeof(bw_table) / sizeof(bw_table[0]); i++)
+        if (bw_table[i] == r->bw_hz) bw = i;
+    return (uint8_t)((bw << 4) | (r->cr << 1) | (implicit ? 1 : 0));
+}
+
+bool rfm95_init(rfm95_t *r, uint32_t frequency) {
+    spi_init(r);
+    r->tx_busy = false;
+    r->rx_on   = false;
+    if (!r->sf)       r->sf       = 12;
+    if (!r->bw_hz)    r->bw_hz    = 125000;
+    if (!r->cr)       r->cr       = 4;
+    if (!r->preamble) r->preamble = 12;
+
+#ifdef RESET_OUT
+    if (r->reset) {
+        csr_write_simple(0, r->reset + RESET_OUT); busy_wait_ms_local(5);
+        csr_write_simple(1, r->reset + RESET_OUT); busy_wait_ms_local(10);
+    }
 #endif
 
-    uint8_t rx = rfm95_read_reg(REG_VERSION);
+    uint8_t rx = rfm95_read_reg(r, REG_VERSION);
     if (rx != 0x12) {
-        printf("⚠️ Versão inesperada (0x%02X, esperado 0x12). SPI falhou ou chip incorreto.\n", rx);
+        LOG_ERR("Radio %d: versao inesperada (0x%02X, esperado 0x12). SPI falhou ou chip incorreto.", r->id, rx);
         return false;
     }
 
-    rfm95_set_mode(MODE_SLEEP);
+    rfm95_set_mode(r, MODE_SLEEP);
 
-    /* 915 MHz  (FRF = Freq * 2^19 / 32e6) */
-    uint64_t frf = ((uint64_t)915000000 << 19) / 32000000;
-    rfm95_write_reg(REG_FRF_MSB, (uint8_t)(frf >> 16));
-    rfm95_write_reg(REG_FRF_MID, (uint8_t)(frf >> 8));
-    rfm95_write_reg(REG_FRF_LSB, (uint8_t)(frf >> 0));
-    printf("Frequencia LoRa configurada para 915 MHz\n");
+    rfm95_set_frequency(r, frequency);
+    LOG_INFO("Radio %d: frequencia LoRa configurada para %d kHz", r->id, (int)(frequency / 1000));
 
     /* Parametrização básica */
-    rfm95_write_reg(REG_PA_CONFIG, 0xFF);
-    rfm95_write_reg(REG_PA_DAC,    0x87);
-    rfm95_write_reg(REG_MODEM_CONFIG_1, 0x78);
-    rfm95_write_reg(REG_MODEM_CONFIG_2, 0xC4);
-    rfm95_write_reg(REG_MODEM_CONFIG_3, 0x0C);
-    rfm95_write_reg(REG_PREAMBLE_MSB,   0x00);
-    rfm95_write_reg(REG_PREAMBLE_LSB,   0x0C);
-    rfm95_write_reg(REG_SYNC_WORD,      0x12);
-    rfm95_write_reg(REG_OCP,            0x37);
-    rfm95_write_reg(REG_FIFO_TX_BASE_ADDR, 0x00);
-    rfm95_write_reg(REG_FIFO_RX_BASE_ADDR, 0x00);
-    rfm95_write_reg(REG_LNA, 0x23);
-    rfm95_write_reg(REG_IRQ_FLAGS_MASK, 0x00);
-    rfm95_write_reg(REG_IRQ_FLAGS,      0xFF);
-
-    rfm95_set_mode(MODE_STDBY);
+    rfm95_write_reg(r, REG_PA_CONFIG, 0xFF);
+    rfm95_write_reg(r, REG_PA_DAC,    0x87);
+    // CRC sempre ligado (RxPayloadCrcOn): no modo implícito os dois lados o assumem.
+    bool ldro = rfm95_ldro_required(r->sf, r->bw_hz);
+    rfm95_write_reg(r, REG_MODEM_CONFIG_1, rfm95_modem_config_1(r, false));
+    rfm95_write_reg(r, REG_MODEM_CONFIG_2, (uint8_t)((r->sf << 4) | 0x04));
+    rfm95_write_reg(r, REG_MODEM_CONFIG_3, (uint8_t)((ldro ? 0x08 : 0) | 0x04));   // LDRO + AGC
+    rfm95_write_reg(r, REG_PREAMBLE_MSB,   (uint8_t)(r->preamble >> 8));
+    rfm95_write_reg(r, REG_PREAMBLE_LSB,   (uint8_t)r->preamble);
+    rfm95_write_reg(r, REG_SYNC_WORD,      0x12);
+    rfm95_write_reg(r, REG_OCP,            0x37);
+    rfm95_write_reg(r, REG_FIFO_TX_BASE_ADDR, 0x00);
+    rfm95_write_reg(r, REG_FIFO_RX_BASE_ADDR, 0x00);
+    rfm95_write_reg(r, REG_LNA, 0x23);
+    rfm95_write_reg(r, REG_IRQ_FLAGS_MASK, 0x00);
+    rfm95_write_reg(r, REG_IRQ_FLAGS,      0xFF);
+
+    rfm95_set_mode(r, MODE_STDBY);
     busy_wait_ms_local(10);
 
-    printf("Modulacao: BW=62.5kHz, SF=12, CR=4/8, Preamble=12, SyncWord=0x12\n");
+    LOG_INFO("Modulacao: BW=%d kHz, SF=%d, CR=4/%d, LDRO=%d",
+             (int)(r->bw_hz / 1000), r->sf, r->cr + 4, ldro);
     return true;
 }
 
-bool rfm95_send_bytes(const uint8_t *data, size_t len) {
+bool rfm95_tx_start(rfm95_t *r, const uint8_t *data, size_t len) {
     if (len == 0 || len > 255) {
-        printf("Erro LoRa: Tamanho do pacote inválido (%d bytes)\n", (int)len);
+        LOG_ERR("LoRa: tamanho do pacote invalido (%d bytes)", (int)len);
+        return false;
+    }
+    if (r->tx_busy) {
+        LOG_WARN("Radio %d: TX em andamento", r->id);
         return false;
     }
 
-    rfm95_set_mode(MODE_STDBY);
+    TRACE_BEGIN(TRACE_EV_RADIO_TX, TRACE_ARG(r->id, len));
+    rfm95_set_mode(r, MODE_STDBY);
+
+    // Quadro do tamanho combinado: sem cabeçalho; o PAYLOAD_LENGTH vale para os dois modos.
+    bool implicit = r->implicit_len && len == r->implicit_len;
+    rfm95_write_reg(r, REG_MODEM_CONFIG_1, rfm95_modem_config_1(r, implicit));
+
+    TRACE_BEGIN(TRACE_EV_RADIO_LOAD, TRACE_ARG(r->id, len));
+#ifdef CSR_RFM95_DMA_BASE
+    if (r->dma) {
+        // FIFO_ADDR_PTR, carga do FIFO e PAYLOAD_LENGTH pelo gateware.
+        rfm95_dma_start(data, (uint8_t)len);
+        if (!rfm95_dma_wait()) {
+            TRACE_END(TRACE_EV_RADIO_LOAD, TRACE_ARG(r->id, 0));
+            TRACE_END(TRACE_EV_RADIO_TX, TRACE_ARG(r->id, 0));
+            LOG_ERR("LoRa: erro de barramento no DMA");
+            return false;
+        }
+    } else
+#endif
+    {
+        rfm95_write_reg(r, REG_FIFO_ADDR_PTR, 0x00);
+        rfm95_write_fifo(r, data, (uint8_t)len);
+        rfm95_write_reg(r, REG_PAYLOAD_LENGTH, (uint8_t)len);
+    }
+    TRACE_END(TRACE_EV_RADIO_LOAD, TRACE_ARG(r->id, len));
+
+    rfm95_write_reg(r, REG_IRQ_FLAGS, 0xFF);
+    rfm95_write_reg(r, REG_DIO_MAPPING_1, 0x40);    // DIO0 = TxDone
 
-    rfm95_write_reg(REG_FIFO_ADDR_PTR, 0x00);
-    rfm95_write_fifo(data, (uint8_t)len);
-    rfm95_write_reg(REG_PAYLOAD_LENGTH, (uint8_t)len);
+    LOG_DBG("Radio %d: enviando %d bytes via LoRa", r->id, (int)len);
 
-    rfm95_write_reg(REG_IRQ_FLAGS, 0xFF);
-    rfm95_write_reg(REG_DIO_MAPPING_1, 0x40);
+    // Sem DIO0, o polling do TxDone lê o valor pré-lido pelo gateware (janela).
+    if (!r->dio0) rfm95_prefetch(r, RFM_PREFETCH_ENABLE | REG_IRQ_FLAGS);
+    rfm95_set_mode(r, MODE_TX);
 
-    printf("Enviando %d bytes via LoRa...\n", (int)len);
+    r->tx_busy  = true;
+    r->tx_len   = (uint8_t)len;
+    r->tx_start = cycles_now();
+    return true;
+}
 
-    rfm95_set_mode(MODE_TX);
+rfm95_tx_status rfm95_tx_poll(rfm95_t *r) {
+    bool done;
 
-    int timeout_cnt = TX_TIMEOUT_MS;
-    while (timeout_cnt > 0) {
-        if (rfm95_read_reg(REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) {
-            rfm95_write_reg(REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
-            rfm95_set_mode(MODE_STDBY);
-            printf("Pacote enviado com sucesso!\n");
-            return true;
-        }
-        busy_wait_ms_local(1);
-        timeout_cnt--;
+    if (!r->tx_busy) return RFM95_TX_IDLE;
+
+#ifdef DIO0_IN
+    if (r->dio0)
+        done = (csr_read_simple(r->dio0 + DIO0_IN) & 1) != 0;
+    else
+#endif
+        done = (rfm95_read_reg(r, REG_IRQ_FLAGS) & IRQ_TX_DONE_MASK) != 0;
+
+    // O timeout compara ciclos: nenhuma divisão a cada poll.
+    uint64_t elapsed = cycles_now() - r->tx_start;
+
+    if (done) {
+        rfm95_write_reg(r, REG_IRQ_FLAGS, IRQ_TX_DONE_MASK);
+        rfm95_set_mode(r, MODE_STDBY);
+        rfm95_prefetch(r, 0);
+        r->tx_busy = false;
+        if (r->rx_on) rfm95_rx_start(r);
+        TRACE_END(TRACE_EV_RADIO_TX, TRACE_ARG(r->id, r->tx_len));
+        LOG_INFO("Radio %d: pacote de %d bytes enviado (%d ms)", r->id, r->tx_len,
+                 (int)cycles_to_ms32(elapsed));
+        return RFM95_TX_DONE;
     }
 
-    printf("Erro: Timeout de TX! O radio foi resetado para Standby.\n");
-    rfm95_set_mode(MODE_STDBY);
-    return false;
+    if (elapsed >= (uint64_t)TX_TIMEOUT_MS * (CONFIG_CLOCK_FREQUENCY / 1000)) {
+        TRACE_MARK(TRACE_EV_RADIO_TIMEOUT, TRACE_ARG(r->id, r->tx_len));
+        TRACE_END(TRACE_EV_RADIO_TX, TRACE_ARG(r->id, 0));
+        LOG_ERR("Radio %d: timeout de TX! O radio foi resetado para Standby.", r->id);
+        rfm95_set_mode(r, MODE_STDBY);
+        rfm95_prefetch(r, 0);
+        r->tx_busy = false;
+        if (r->rx_on) rfm95_rx_start(r);
+        return RFM95_TX_TIMEOUT;
+    }
+    return RFM95_TX_BUSY;
+}
+
+bool rfm95_send_bytes(rfm95_t *r, const uint8_t *data, size_t len) {
+    rfm95_tx_status st;
+
+    if (!rfm95_tx_start(r, data, len)) return false;
+
+    // Com DIO0 o polling é uma leitura de CSR; sem ele, uma transação SPI por ms.
+    while ((st = rfm95_tx_poll(r)) == RFM95_TX_BUSY) {
+        if (!r->dio0) busy_wait_ms_local(1);
+    }
+    return st == RFM95_TX_DONE;
+}
+
+void rfm95_rx_start(rfm95_t *r) {
+    rfm95_set_mode(r, MODE_STDBY);
+    rfm95_write_reg(r, REG_IRQ_FLAGS, 0xFF);
+    rfm95_write_reg(r, REG_DIO_MAPPING_1, 0x00);    // DIO0 = RxDone
+    rfm95_write_reg(r, REG_FIFO_ADDR_PTR, 0x00);
+    // Sem cabeçalho o rádio só sabe o tamanho pelo PAYLOAD_LENGTH.
+    bool implicit = r->rx_implicit && r->implicit_len;
+    rfm95_write_reg(r, REG_MODEM_CONFIG_1, rfm95_modem_config_1(r, implicit));
+    if (implicit) rfm95_write_reg(r, REG_PAYLOAD_LENGTH, r->implicit_len);
+    if (!r->dio0) rfm95_prefetch(r, RFM_PREFETCH_ENABLE | REG_IRQ_FLAGS);
+    rfm95_set_mode(r, MODE_RX_CONTINUOUS);
+    r->rx_on = true;
+}
+
+void rfm95_rx_stop(rfm95_t *r) {
+    r->rx_on = false;
+    if (r->tx_busy) return;     // O TX em andamento termina em standby
+    rfm95_set_mode(r, MODE_STDBY);
+    rfm95_prefetch(r, 0);
+}
+
+int rfm95_rx_poll(rfm95_t *r, uint8_t *buf, size_t maxlen) {
+    bool done;
+
+    if (!r->rx_on || r->tx_busy) return 0;
+
+#ifdef DIO0_IN
+    if (r->dio0)
+        done = (csr_read_simple(r->dio0 + DIO0_IN) & 1) != 0;
+    else
+#endif
+        done = (rfm95_read_reg(r, REG_IRQ_FLAGS) & IRQ_RX_DONE_MASK) != 0;
+    if (!done) return 0;
+
+    r->rx_at = cycles_now();
+    uint8_t flags = rfm95_read_reg(r, REG_IRQ_FLAGS);
+    rfm95_write_reg(r, REG_IRQ_FLAGS, 0xFF);
+
+    if (flags & IRQ_PAYLOAD_CRC_ERROR) {
+        r->rx_errors++;
+        TRACE_MARK(TRACE_EV_RADIO_RX_ERROR, TRACE_ARG(r->id, 0));
+        LOG_DBG("Radio %d: quadro com CRC invalido", r->id);
+        return -1;
+    }
+
+    uint8_t len = rfm95_read_reg(r, REG_RX_NB_BYTES);
+    if (len > maxlen) {
+        r->rx_errors++;
+        TRACE_MARK(TRACE_EV_RADIO_RX_ERROR, TRACE_ARG(r->id, len));
+        LOG_DBG("Radio %d: quadro de %d bytes descartado", r->id, len);
+        return -1;
+    }
+
+    // RSSI do pacote na banda alta (HF): -157 + valor; SNR em quartos de dB.
+    r->rx_snr  = (int8_t)((int8_t)rfm95_read_reg(r, REG_PKT_SNR_VALUE) / 4);
+    r->rx_rssi = (int16_t)(rfm95_read_reg(r, REG_PKT_RSSI_VALUE) - 157);
+
+    rfm95_write_reg(r, REG_FIFO_ADDR_PTR, rfm95_read_reg(r, REG_FIFO_RX_CURRENT_ADDR));
+    rfm95_read_fifo(r, buf, len);
+    TRACE_MARK(TRACE_EV_RADIO_RX, TRACE_ARG(r->id, len));
+    return len;
 }
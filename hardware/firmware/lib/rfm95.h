@@ -3,9 +3,132 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <generated/csr.h>
+#include <generated/soc.h>
 
-uint8_t rfm95_read_reg(uint8_t reg);
-void    rfm95_write_reg(uint8_t reg, uint8_t value);
-void    rfm95_set_mode(uint8_t mode);
-bool    rfm95_init(void);
-bool    rfm95_send_bytes(const uint8_t *data, size_t len);
+// ============================================
+// === Instâncias de rádio ===
+// ============================================
+/*
+ * O SoC gera LORA_RADIOS rádios (--lora-radios), cada um com seu SPIMaster,
+ * RESET e, com --with-lora-dio0, o DIO0; sem ele, o TxDone/RxDone é lido em
+ * REG_IRQ_FLAGS (o padrão: as placas existentes não ligam o DIO0). O rádio 0 usa os CSRs originais (spi, lora_reset) e, se
+ * existirem, a janela de registradores e o DMA; os demais usam loraN_*.
+ */
+#ifdef LORA_RADIOS
+#define RFM95_NUM_RADIOS LORA_RADIOS
+#else
+#define RFM95_NUM_RADIOS 1
+#endif
+
+typedef struct {
+    unsigned long spi;          // Base dos CSRs do SPIMaster
+    unsigned long reset;        // Base do GPIOOut do RESET (0 = sem)
+    unsigned long dio0;         // Base do GPIOIn do DIO0 (0 = polling de REG_IRQ_FLAGS)
+    volatile uint32_t *regs;    // Janela mapeada (NULL = SPI pelos CSRs)
+    bool     dma;               // Carga do FIFO pelo DMA
+    uint8_t  id;
+    uint32_t frequency;         // Hz
+
+    // Modulação: campos zerados ficam com o padrão no rfm95_init() (SF12,
+    // 125 kHz, CR 4/8, preâmbulo de 12). O LDRO é derivado de SF/BW.
+    uint8_t  sf;                // 6..12
+    uint32_t bw_hz;
+    uint8_t  cr;                // 1..4 = 4/5..4/8
+    uint16_t preamble;
+
+    // Cabeçalho implícito: quadros de implicit_len bytes vão sem cabeçalho
+    // (tamanho e CRC combinados com o receptor); os demais, com cabeçalho.
+    uint8_t  implicit_len;      // 0 = sempre explícito
+    bool     rx_implicit;       // RX espera quadros de implicit_len sem cabeçalho
+
+    // TX não bloqueante
+    bool     tx_busy;
+    uint8_t  tx_len;
+    uint64_t tx_start;          // ciclos (cycles_now)
+
+    // RX contínuo (volta a ele depois de cada TX)
+    bool     rx_on;
+    uint64_t rx_at;             // ciclos em que o último RxDone foi visto
+    int16_t  rx_rssi;           // dBm do último quadro
+    int8_t   rx_snr;            // dB do último quadro
+    uint32_t rx_errors;         // CRC inválido ou quadro maior que o buffer
+} rfm95_t;
+
+typedef enum {
+    RFM95_TX_IDLE = 0,          // Nenhuma transmissão iniciada
+    RFM95_TX_BUSY,              // Transmitindo
+    RFM95_TX_DONE,              // TxDone: rádio de volta em standby
+    RFM95_TX_TIMEOUT,           // Sem TxDone em TX_TIMEOUT_MS: rádio em standby
+} rfm95_tx_status;
+
+/** @brief Rádio 'id' (0..RFM95_NUM_RADIOS-1), ou NULL. */
+rfm95_t *rfm95_radio(unsigned id);
+
+uint8_t rfm95_read_reg(rfm95_t *r, uint8_t reg);
+void    rfm95_write_reg(rfm95_t *r, uint8_t reg, uint8_t value);
+void    rfm95_write_fifo(rfm95_t *r, const uint8_t *data, uint8_t len);
+void    rfm95_set_mode(rfm95_t *r, uint8_t mode);
+
+/** @brief Ajusta a portadora; chame com o rádio em sleep/standby. */
+void    rfm95_set_frequency(rfm95_t *r, uint32_t hz);
+
+/** @brief true se o símbolo passa de 16 ms e o LowDataRateOptimize é obrigatório. */
+bool    rfm95_ldro_required(uint8_t sf, uint32_t bw_hz);
+
+/**
+ * @brief Tempo no ar de um quadro de 'len' bytes com a modulação do rádio
+ * (fórmula do datasheet do SX1276, CRC ligado).
+ */
+uint32_t rfm95_airtime_us(const rfm95_t *r, size_t len, bool implicit);
+
+/** @brief Reset, verificação da versão e configuração LoRa na frequência dada. */
+bool    rfm95_init(rfm95_t *r, uint32_t frequency);
+
+/**
+ * @brief Carrega o quadro e coloca o rádio em TX sem esperar o TxDone.
+ * @return false se o tamanho é inválido, o rádio já está transmitindo ou o
+ * DMA falhou.
+ */
+bool    rfm95_tx_start(rfm95_t *r, const uint8_t *data, size_t len);
+
+/**
+ * @brief Verifica o TX iniciado por rfm95_tx_start() (DIO0 quando existe,
+ * senão REG_IRQ_FLAGS). DONE e TIMEOUT são informados uma única vez.
+ */
+rfm95_tx_status rfm95_tx_poll(rfm95_t *r);
+
+/** @brief TX bloqueante: rfm95_tx_start() e espera o TxDone. */
+bool    rfm95_send_bytes(rfm95_t *r, const uint8_t *data, size_t len);
+
+/**
+ * @brief Coloca o rádio em RX contínuo (DIO0 = RxDone), sem cabeçalho se
+ * r->rx_implicit. Enquanto ligado, o rádio volta ao RX no fim de cada TX.
+ */
+void    rfm95_rx_start(rfm95_t *r);
+/** @brief Desliga o RX contínuo e deixa o rádio em standby. */
+void    rfm95_rx_stop(rfm95_t *r);
+
+/**
+ * @brief Verifica se chegou um quadro e o copia do FIFO; r->rx_at guarda o
+ * instante em que o RxDone foi visto (a precisão é a do polling), e
+ * r->rx_rssi/r->rx_snr a qualidade do sinal.
+ * @return Tamanho do quadro, 0 se nada chegou, -1 se o quadro foi descartado
+ * (CRC inválido ou maior que maxlen).
+ */
+int     rfm95_rx_poll(rfm95_t *r, uint8_t *buf, size_t maxlen);
+
+#ifdef CSR_RFM95_DMA_BASE
+/**
+ * @brief Inicia a carga de um quadro pelo DMA do gateware (rádio 0):
+ * FIFO_ADDR_PTR, rajada no FIFO e PAYLOAD_LENGTH, sem a CPU no caminho. O
+ * buffer precisa ficar intacto até rfm95_dma_wait() e estar em memória no
+ * barramento (main_ram/sram/fast_sram).
+ */
+void    rfm95_dma_start(const uint8_t *data, uint8_t len);
+/**
+ * @brief Espera o fim da carga iniciada por rfm95_dma_start().
+ * @return false se o DMA teve erro de barramento.
+ */
+bool    rfm95_dma_wait(void);
+#endif
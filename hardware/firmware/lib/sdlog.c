@@ -0,0 +1,281 @@
+#include "sdlog.h"
+
+#ifdef SDLOG_AVAILABLE
+#include "cycles.h"
+#include "log.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <libbase/crc.h>
+#ifdef CSR_SPISDCARD_BASE
+#include <liblitesdcard/spisdcard.h>
+#else
+#include <liblitesdcard/sdcard.h>
+#endif
+
+#define SDLOG_MAGIC 0x31474c53u     // "SLG1"
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t count;
+    uint16_t rec_size;
+    uint32_t crc;           // crc32 dos 'count' registros
+    uint32_t hdr_crc;       // crc32 dos campos acima
+    uint8_t  reserved[SDLOG_HDR_LEN - 20];
+} sdlog_hdr;
+
+typedef struct {
+    sdlog_hdr hdr;
+    sdlog_rec rec[SDLOG_RECS_PER_SEG];
+} sdlog_seg;
+
+_Static_assert(sizeof(sdlog_hdr) == SDLOG_HDR_LEN, "cabecalho do sdlog");
+_Static_assert(sizeof(sdlog_seg) <= SDLOG_SEG_BLOCKS * 512, "segmento do sdlog");
+
+// Buffers alinhados a palavra: o SD copia blocos inteiros.
+static union { sdlog_seg seg; uint8_t raw[SDLOG_SEG_BLOCKS * 512]; } stage, scratch;
+
+static bool     ready;
+static uint32_t cur_seq;        // Segmento em preparação no 'stage'
+static unsigned shadow_next;    // Sombra da próxima gravação parcial (0 ou 1)
+static bool     dirty;          // 'stage' tem registros ainda não gravados
+static uint64_t last_sync;
+static uint32_t appended, writes, write_errors;
+
+// ---- Acesso ao cartão (SPI ou nativo) ----
+
+static bool sd_init(void) {
+#ifdef CSR_SPISDCARD_BASE
+    return spisdcard_init() != 0;
+#else
+    return sdcard_init() != 0;
+#endif
+}
+
+static bool sd_read(uint32_t block, uint32_t count, uint8_t *buf) {
+#ifdef CSR_SPISDCARD_BASE
+    return spisdcard_read(block, count, buf) != 0;
+#else
+    sdcard_read(block, count, buf);
+    return true;
+#endif
+}
+
+static bool sd_write(uint32_t block, uint32_t count, uint8_t *buf) {
+#ifdef CSR_SPISDCARD_BASE
+    return spisdcard_write(block, count, buf) != 0;
+#else
+    sdcard_write(block, count, buf);
+    return true;
+#endif
+}
+
+static inline uint32_t slot_block(uint32_t seq) {
+    return SDLOG_FIRST_BLOCK + (seq % SDLOG_SEGMENTS) * SDLOG_SEG_BLOCKS;
+}
+
+static inline uint32_t shadow_block(unsigned k) {
+    return SDLOG_FIRST_BLOCK + (SDLOG_SEGMENTS + k) * SDLOG_SEG_BLOCKS;
+}
+
+static uint32_t hdr_crc(const sdlog_hdr *h) {
+    return crc32((const unsigned char *)h, offsetof(sdlog_hdr, hdr_crc));
+}
+
+static uint32_t rec_crc(const sdlog_seg *s) {
+    return crc32((const unsigned char *)s->rec, s->hdr.count * sizeof(sdlog_rec));
+}
+
+// Lê só o primeiro bloco do slot e valida o cabeçalho.
+static bool read_hdr(uint32_t slot, sdlog_hdr *out) {
+    if (!sd_read(SDLOG_FIRST_BLOCK + slot * SDLOG_SEG_BLOCKS, 1, scratch.raw)) return false;
+    *out = scratch.seg.hdr;
+    return out->magic == SDLOG_MAGIC && out->rec_size == sizeof(sdlog_rec) &&
+           out->count <= SDLOG_RECS_PER_SEG && out->hdr_crc == hdr_crc(out);
+}
+
+// Lê o segmento em 'block' para 'scratch' e confere seq e os dois CRCs.
+static bool read_seg_at(uint32_t block, uint32_t seq) {
+    sdlog_seg *s = &scratch.seg;
+    if (!sd_read(block, SDLOG_SEG_BLOCKS, scratch.raw)) return false;
+    return s->hdr.magic == SDLOG_MAGIC && s->hdr.seq == seq &&
+           s->hdr.rec_size == sizeof(sdlog_rec) && s->hdr.count <= SDLOG_RECS_PER_SEG &&
+           s->hdr.hdr_crc == hdr_crc(&s->hdr) && s->hdr.crc == rec_crc(s);
+}
+
+static bool read_seg(uint32_t seq) {
+    return read_seg_at(slot_block(seq), seq);
+}
+
+// Cópia do segmento 'seq' com mais registros entre as sombras, para o 'stage'.
+static bool shadow_load(uint32_t seq) {
+    bool found = false;
+
+    for (unsigned k = 0; k < 2; k++) {
+        if (!read_seg_at(shadow_block(k), seq)) continue;
+        if (found && scratch.seg.hdr.count <= stage.seg.hdr.count) continue;
+        memcpy(&stage.seg, &scratch.seg, sizeof(stage.seg));
+        shadow_next = k ^ 1;            // A próxima gravação preserva esta
+        found = true;
+    }
+    if (found) {
+        cur_seq = seq;
+        dirty   = false;
+    }
+    return found;
+}
+
+static void stage_reset(uint32_t seq) {
+    memset(&stage.seg.hdr, 0, sizeof(stage.seg.hdr));
+    stage.seg.hdr.seq = seq;
+    cur_seq = seq;
+    dirty   = false;
+}
+
+static bool stage_write(void) {
+    sdlog_hdr *h = &stage.seg.hdr;
+
+    h->magic    = SDLOG_MAGIC;
+    h->seq      = cur_seq;
+    h->rec_size = sizeof(sdlog_rec);
+    h->crc      = rec_crc(&stage.seg);
+    h->hdr_crc  = hdr_crc(h);
+
+    // Cheio vai para o anel; parcial, para a sombra que não tem a última cópia.
+    // Uma escrita cortada deixa o CRC errado só no slot que estava sendo escrito.
+    bool     full  = h->count == SDLOG_RECS_PER_SEG;
+    uint32_t block = full ? slot_block(cur_seq) : shadow_block(shadow_next);
+    if (!sd_write(block, SDLOG_SEG_BLOCKS, stage.raw)) {
+        write_errors++;
+        return false;
+    }
+    if (!full) shadow_next ^= 1;
+    writes++;
+    dirty     = false;
+    last_sync = cycles_now();
+    return true;
+}
+
+// ---- Busca do fim ----
+
+/*
+ * Os slots 0..t têm seq = base + slot (volta corrente); depois de t vêm a
+ * volta anterior ou slots vazios. O predicado "seq == base + slot" é
+ * verdadeiro até t e falso depois: busca binária.
+ */
+static bool find_tail(uint32_t *tail_seq) {
+    sdlog_hdr h;
+    uint32_t base, lo = 0, hi = SDLOG_SEGMENTS - 1;
+
+    if (!read_hdr(0, &h)) {
+        // Slot 0 ilegível: log vazio, ou queda na regravação do slot 0 ao
+        // começar uma volta (então o slot 1 é da volta anterior).
+        if (!read_hdr(1, &h)) return false;
+        *tail_seq = h.seq - 1 + SDLOG_SEGMENTS;
+        return true;
+    }
+    base = h.seq;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if (read_hdr(mid, &h) && h.seq == base + mid) lo = mid;
+        else                                          hi = mid - 1;
+    }
+    *tail_seq = base + lo;
+    return true;
+}
+
+bool sdlog_init(void) {
+    uint32_t tail, next;
+
+    ready = false;
+    if (!sd_init()) {
+        LOG_WARN("sdlog: cartao SD nao respondeu");
+        return false;
+    }
+
+    uint64_t t0 = cycles_now();
+    shadow_next = 0;
+    if (!find_tail(&tail)) {
+        next = 0;
+    } else if (!read_seg(tail)) {
+        // Escrita do segmento cheio cortada: ele volta da sombra e é refeito.
+        LOG_WARN("sdlog: segmento %d corrompido, reescrevendo", (int)tail);
+        next = tail;
+    } else {
+        next = tail + 1;
+    }
+    if (!shadow_load(next)) stage_reset(next);
+    last_sync = cycles_now();
+    ready = true;
+
+    LOG_INFO("sdlog: segmento %d, %d registros (busca em %d ms)",
+             (int)cur_seq, stage.seg.hdr.count, (int)cycles_to_ms(cycles_now() - t0));
+    return true;
+}
+
+bool sdlog_append(const sdlog_rec *rec) {
+    if (!ready) return false;
+
+    stage.seg.rec[stage.seg.hdr.count++] = *rec;
+    dirty = true;
+    appended++;
+
+    if (stage.seg.hdr.count < SDLOG_RECS_PER_SEG) return true;
+    bool ok = stage_write();
+    stage_reset(cur_seq + 1);
+    return ok;
+}
+
+void sdlog_sync(void) {
+    if (ready && dirty) stage_write();
+}
+
+void sdlog_service(void) {
+    if (!ready || !dirty) return;
+    if (cycles_now() - last_sync >= (uint64_t)SDLOG_SYNC_MS * (CONFIG_CLOCK_FREQUENCY / 1000))
+        stage_write();
+}
+
+static uint32_t oldest_seq(void) {
+    return cur_seq >= SDLOG_SEGMENTS ? cur_seq - SDLOG_SEGMENTS + 1 : 0;
+}
+
+void sdlog_dump(uint32_t first_seq, uint32_t n) {
+    if (!ready) return;
+
+    if (first_seq < oldest_seq()) first_seq = oldest_seq();
+
+    // Os cheios vêm do anel; o corrente, do 'stage'.
+    printf("seq,indice,t_ms,sensor,motivo,temp,umid\n");
+    for (uint32_t seq = first_seq; seq < first_seq + n && seq <= cur_seq; seq++) {
+        const sdlog_seg *s = &scratch.seg;
+        if (seq == cur_seq) {
+            s = &stage.seg;
+        } else if (!read_seg(seq)) {
+            printf("# segmento %lu ilegivel\n", (unsigned long)seq);
+            continue;
+        }
+        for (unsigned i = 0; i < s->hdr.count; i++) {
+            const sdlog_rec *r = &s->rec[i];
+            printf("%lu,%u,%lu,%u,%u,%d,%d\n", (unsigned long)seq, i,
+                   (unsigned long)r->t_ms, r->sensor, r->reason, r->temperatura, r->umidade);
+        }
+    }
+}
+
+void sdlog_stats(void) {
+    if (!ready) {
+        printf("sdlog: sem cartao.\n");
+        return;
+    }
+    printf("sdlog: segmentos %lu..%lu (anel de %d x %d KB), %u registros no corrente%s\n",
+           (unsigned long)oldest_seq(), (unsigned long)cur_seq,
+           SDLOG_SEGMENTS, SDLOG_SEG_BLOCKS / 2, stage.seg.hdr.count, dirty ? " (pendente)" : "");
+    printf("Capacidade: %lu registros; %lu acrescentados, %lu escritas, %lu falhas\n",
+           (unsigned long)((uint64_t)SDLOG_SEGMENTS * SDLOG_RECS_PER_SEG),
+           (unsigned long)appended, (unsigned long)writes, (unsigned long)write_errors);
+}
+#endif
@@ -0,0 +1,72 @@
+// ./lib/sdlog.h
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <generated/csr.h>
+
+// ============================================
+// === Log de amostras em blocos do cartão SD ===
+// ============================================
+/*
+ * Log só de acréscimo, direto nos blocos do cartão (sem sistema de arquivos),
+ * a partir de SDLOG_FIRST_BLOCK. O cartão é dedicado ao log. A área é dividida
+ * em segmentos de SDLOG_SEG_BLOCKS blocos, escritos de uma vez (escrita
+ * multibloco alinhada) a partir de um buffer em RAM. Cada segmento começa com
+ * um cabeçalho:
+ *   magic, seq (cresce 1 por segmento), count, rec_size, crc32 dos registros
+ *   e crc32 do próprio cabeçalho
+ * e o segmento 'seq' fica no slot seq % SDLOG_SEGMENTS (anel). No anel só
+ * entram segmentos cheios, numa única escrita.
+ *
+ * Enquanto enche, o segmento corrente é gravado a cada SDLOG_SYNC_MS em dois
+ * slots de sombra depois do anel, um de cada vez: uma escrita cortada só
+ * estraga a cópia que estava sendo gravada, e a outra, anterior, continua
+ * válida. Uma queda perde no máximo 2 x SDLOG_SYNC_MS. No boot, uma busca
+ * binária pelos cabeçalhos (log2(SDLOG_SEGMENTS) leituras de um bloco) acha o
+ * último segmento do anel, e o log continua na cópia mais nova do segmento
+ * seguinte nas sombras (ou do próprio último, se a escrita dele foi cortada).
+ */
+#if defined(CSR_SPISDCARD_BASE) || defined(CSR_SDCORE_BASE)
+#define SDLOG_AVAILABLE 1
+
+#define SDLOG_FIRST_BLOCK   2048            // 1 MiB: preserva uma tabela de partições
+#define SDLOG_SEG_BLOCKS    16              // 8 KB por escrita
+#define SDLOG_SEGMENTS      65536           // 512 MiB de log (mais 2 segmentos de sombra)
+#define SDLOG_SYNC_MS       60000
+#define SDLOG_HDR_LEN       32
+
+typedef struct {
+    uint32_t t_ms;          // Uptime do nó na amostra (volta a 0 a cada boot)
+    uint8_t  sensor;
+    uint8_t  reason;        // report_reason de main.c (0 = suprimida)
+    int16_t  temperatura;   // x100
+    int16_t  umidade;       // x100
+    uint16_t reserved;
+} sdlog_rec;
+
+#define SDLOG_RECS_PER_SEG  ((SDLOG_SEG_BLOCKS * 512 - SDLOG_HDR_LEN) / sizeof(sdlog_rec))
+
+/**
+ * @brief Inicializa o cartão e acha o fim do log.
+ * @return false se o cartão não respondeu.
+ */
+bool sdlog_init(void);
+
+/** @brief Acrescenta um registro; grava o segmento quando ele enche. */
+bool sdlog_append(const sdlog_rec *rec);
+
+/** @brief Grava o segmento parcial se passou SDLOG_SYNC_MS. Chamar no laço. */
+void sdlog_service(void);
+
+/** @brief Grava já o segmento parcial. */
+void sdlog_sync(void);
+
+/**
+ * @brief Envia 'n' segmentos a partir de 'first_seq' pelo console, um
+ * registro CSV por linha (seq,indice,t_ms,sensor,motivo,temp,umid).
+ */
+void sdlog_dump(uint32_t first_seq, uint32_t n);
+
+/** @brief Imprime faixa de seq disponível, registros e capacidade. */
+void sdlog_stats(void);
+#endif
@@ -0,0 +1,155 @@
+#include "tdma.h"
+#include "frame.h"
+#include "rfm95.h"
+#include "cycles.h"
+#include "log.h"
+#include "trace.h"
+
+#include <stdio.h>
+
+#define CYCLES_PER_MS (CONFIG_CLOCK_FREQUENCY / 1000)
+
+static bool     enabled, synced;
+static uint8_t  node;
+static uint8_t  last_seq;
+static uint16_t slot_mask;      // Bit i: o slot i do mapa é deste nó
+static uint8_t  n_slots;
+static uint32_t slot_ms;
+
+static uint64_t ref;            // Início do superquadro corrente (ciclos, no RxDone)
+static uint64_t period;         // Superquadro medido (ciclos)
+static uint64_t nominal;        // Superquadro pelo relógio do nó (ciclos)
+
+static uint32_t beacons, resyncs, lost, foreign;
+
+void tdma_enable(bool on, uint8_t node_id) {
+    rfm95_t *r = rfm95_radio(0);
+
+    enabled = on;
+    synced  = false;
+    node    = node_id;
+    // O beacon tem tamanho variável: RX sempre com cabeçalho.
+    r->rx_implicit = false;
+    if (on) rfm95_rx_start(r);
+    else    rfm95_rx_stop(r);
+}
+
+bool tdma_enabled(void) {
+    return enabled;
+}
+
+static void tdma_beacon(const frame_beacon *b, uint64_t rx_at) {
+    uint64_t nom = (uint64_t)(b->n_slots + 1) * b->slot_ms * CYCLES_PER_MS;
+    uint16_t mask = 0;
+
+    for (unsigned i = 0; i < b->n_slots; i++)
+        if (b->owner[i] == node) mask |= 1u << i;
+
+    beacons++;
+    if (!mask) foreign++;
+    TRACE_MARK(TRACE_EV_TDMA_BEACON, b->seq);
+
+    // Mesmo plano e sem salto grande: corrige fase e período aos poucos.
+    bool tracked = false;
+    if (synced && nom == nominal) {
+        uint8_t  k   = (uint8_t)(b->seq - last_seq);    // Superquadros desde o último beacon
+        int64_t  err = (int64_t)(rx_at - (ref + k * period));
+        int64_t  lim = (int64_t)(period / 8);
+
+        if (k > 0 && k <= TDMA_MAX_MISSED && err > -lim && err < lim) {
+            ref     = ref + k * period + err / 4;
+            period += err / (4 * k);
+            tracked = true;
+        } else {
+            resyncs++;
+        }
+    }
+
+    // Primeiro beacon, plano novo ou erro grande: assume o beacon como está.
+    if (!tracked) {
+        ref     = rx_at;
+        period  = nom;
+        nominal = nom;
+        LOG_INFO("TDMA: sincronizado, %d slots de %d ms", b->n_slots, b->slot_ms);
+    }
+
+    synced    = true;
+    last_seq  = b->seq;
+    slot_mask = mask;
+    n_slots   = b->n_slots;
+    slot_ms   = b->slot_ms;
+}
+
+void tdma_service(void) {
+    uint8_t buf[FRAME_BEACON_HDR_LEN + FRAME_BEACON_MAX_SLOTS];
+    frame_beacon b;
+    rfm95_t *r = rfm95_radio(0);
+
+    if (!enabled) return;
+
+    int len = rfm95_rx_poll(r, buf, sizeof(buf));
+    if (len <= 0) return;
+    if (!frame_decode_beacon(buf, len, &b)) {
+        LOG_DBG("TDMA: quadro de %d bytes ignorado", len);
+        return;
+    }
+    tdma_beacon(&b, r->rx_at);
+}
+
+static uint64_t airtime_cycles(const rfm95_t *r, size_t len) {
+    bool implicit = r->implicit_len && len == r->implicit_len;
+    return (uint64_t)rfm95_airtime_us(r, len, implicit) * (CONFIG_CLOCK_FREQUENCY / 1000000);
+}
+
+bool tdma_can_send(uint64_t now, const rfm95_t *r, size_t len) {
+    if (!enabled) return true;
+    if (!synced || now < ref) return false;
+
+    // Beacons perdidos: extrapola pelo período medido.
+    uint64_t m = (now - ref) / period;
+    if (m > TDMA_MAX_MISSED) {
+        synced = false;
+        lost++;
+        LOG_WARN("TDMA: sem beacon, sincronismo perdido");
+        return false;
+    }
+
+    // Slots escalados pelo período medido: acompanham a deriva.
+    uint64_t off   = now - ref - m * period;
+    uint64_t slot  = period / (n_slots + 1);
+    uint64_t guard = (uint64_t)TDMA_GUARD_MS * CYCLES_PER_MS;
+    if (off < guard) return false;
+
+    uint64_t i = (off - guard) / slot;
+    if (i >= n_slots || !(slot_mask & (1u << i))) return false;
+    uint64_t into = (off - guard) - i * slot;
+    if (into >= (uint64_t)TDMA_TX_WINDOW_MS * CYCLES_PER_MS) return false;
+
+    // O quadro inteiro no ar antes do slot do próximo nó.
+    return airtime_cycles(r, len) <= slot - into;
+}
+
+bool tdma_frame_fits(const rfm95_t *r, size_t len) {
+    if (!enabled || !synced) return true;
+    return airtime_cycles(r, len) <= period / (n_slots + 1);
+}
+
+void tdma_stats(void) {
+    if (!enabled) {
+        printf("TDMA desligado.\n");
+        return;
+    }
+    printf("TDMA: no %u, %s, %u slots de %lu ms, meus slots 0x%04x\n",
+           node, synced ? "sincronizado" : "sem sincronismo",
+           n_slots, (unsigned long)slot_ms, slot_mask);
+    if (nominal) {
+        // Deriva em ppm: diferença entre o período medido e o nominal.
+        long ppm = (long)(((int64_t)period - (int64_t)nominal) * 1000000 / (int64_t)nominal);
+        printf("Superquadro: %lu ms nominal, deriva %ld ppm\n",
+               (unsigned long)(nominal / CYCLES_PER_MS), ppm);
+    }
+    printf("Beacons: %lu, ressincronismos %lu, perdas %lu, sem slot %lu, erros de RX %lu\n",
+           (unsigned long)beacons, (unsigned long)resyncs, (unsigned long)lost,
+           (unsigned long)foreign, (unsigned long)rfm95_radio(0)->rx_errors);
+
+}
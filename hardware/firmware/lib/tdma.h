@@ -0,0 +1,55 @@
+// ./lib/tdma.h
+#pragma once
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "rfm95.h"
+
+// ============================================
+// === Slots TDMA sincronizados por beacon ===
+// ============================================
+/*
+ * O receptor transmite um beacon por superquadro com o dono de cada slot
+ * (lib/frame.h). O superquadro começa no beacon e tem n_slots + 1 slots: o
+ * slot 'i' do mapa começa TDMA_GUARD_MS + i * slot_ms depois do RxDone do
+ * beacon. O nó só inicia TX nos primeiros TDMA_TX_WINDOW_MS dos seus slots,
+ * e só se o tempo no ar do quadro couber no que resta do slot.
+ *
+ * O rádio 0 fica em RX contínuo entre os TX para ouvir o beacon. A referência
+ * é corrigida a cada beacon por um laço de fase de primeira ordem, e o período
+ * medido em ciclos compensa a deriva entre os relógios do nó e do receptor.
+ * Sem beacon por TDMA_MAX_MISSED superquadros, o nó perde o sincronismo e
+ * segura os quadros até o próximo beacon.
+ */
+#define TDMA_GUARD_MS       100
+#define TDMA_TX_WINDOW_MS   50
+#define TDMA_MAX_MISSED     4
+
+/**
+ * @brief Liga/desliga o TDMA. Ligar coloca o rádio 0 em RX e começa sem
+ * sincronismo. Desligado, tdma_can_send() sempre permite o TX.
+ */
+void tdma_enable(bool on, uint8_t node_id);
+bool tdma_enabled(void);
+
+/**
+ * @brief Recebe e processa beacons no rádio 0. Chamar no laço principal e
+ * nas esperas longas: o instante do beacon é o da chamada que o encontra.
+ */
+void tdma_service(void);
+
+/**
+ * @brief true se o nó pode iniciar agora o TX de 'len' bytes pelo rádio 'r':
+ * TDMA desligado, ou sincronizado, dentro da janela de um dos seus slots e
+ * com o tempo no ar terminando antes do fim do slot.
+ */
+bool tdma_can_send(uint64_t now, const rfm95_t *r, size_t len);
+
+/**
+ * @brief false se o tempo no ar de 'len' bytes passa de um slot inteiro: o
+ * quadro nunca seria enviado. Sem sincronismo, sempre true.
+ */
+bool tdma_frame_fits(const rfm95_t *r, size_t len);
+
+/** @brief Imprime sincronismo, slots, deriva e contadores. */
+void tdma_stats(void);
@@ -0,0 +1,123 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <uart.h>
+
+// ============================================
+// === Formato do 'trace_dump' ===
+// ============================================
+/*
+ *   texto:   "TRACE-BEGIN <bytes>\n"
+ *   binário (little-endian, <bytes> bytes):
+ *     [0..3]   "TRC1"
+ *     [4..5]   tamanho do evento (12)
+ *     [6..7]   número de nomes
+ *     [8..11]  clock do SoC (Hz)
+ *     [12..15] número de eventos
+ *     [16..19] eventos sobrescritos antes do dump
+ *     nomes:   { u16 id, u8 formato do arg, u8 tamanho, nome } por id
+ *     eventos: trace_event_t, do mais antigo para o mais novo
+ *   texto:   "\nTRACE-END\n"
+ * Formato do arg: 'i' = instância no byte alto + valor de 24 bits,
+ * 's' = 4 caracteres ASCII, 'u' = inteiro sem sinal.
+ */
+#define TRACE_MAGIC    "TRC1"
+#define TRACE_HDR_LEN  20
+
+typedef struct {
+    const char *name;
+    char        fmt;
+} trace_name_t;
+
+static const trace_name_t names[TRACE_EV_COUNT] = {
+    [TRACE_EV_CONSOLE]        = { "console",        's' },
+    [TRACE_EV_SAMPLE]         = { "sample",         'u' },
+    [TRACE_EV_SENSOR_TRIGGER] = { "aht10_trigger",  'i' },
+    [TRACE_EV_SENSOR_FETCH]   = { "aht10_fetch",    'i' },
+    [TRACE_EV_RADIO_TX]       = { "radio_tx",       'i' },
+    [TRACE_EV_RADIO_LOAD]     = { "radio_load",     'i' },
+    [TRACE_EV_RADIO_TIMEOUT]  = { "radio_timeout",  'i' },
+    [TRACE_EV_RADIO_RX]       = { "radio_rx",       'i' },
+    [TRACE_EV_RADIO_RX_ERROR] = { "radio_rx_error", 'i' },
+    [TRACE_EV_TX_QUEUE]       = { "tx_queue",       'u' },
+    [TRACE_EV_TX_DROP]        = { "tx_drop",        'u' },
+    [TRACE_EV_SEAL]           = { "frame_seal",     'u' },
+    [TRACE_EV_TDMA_BEACON]    = { "tdma_beacon",    'u' },
+    [TRACE_EV_GATEWAY_TX]     = { "gateway_tx",     'u' },
+    [TRACE_EV_LOG_FLUSH]      = { "log_flush",      'u' },
+};
+
+// Em .bss, na main_ram (SDRAM): fora da SRAM rápida, que não comporta o anel.
+trace_event_t     trace_ring[TRACE_RING_LEN];
+volatile uint32_t trace_head;
+static uint32_t   trace_base;           // trace_head no último trace_clear()
+
+// Bytes crus: o putchar() do console troca '\n' por "\r\n".
+static void put_bytes(const void *data, size_t len) {
+    const uint8_t *p = data;
+    while (len--) uart_write(*p++);
+}
+
+static void put_u16(uint16_t v) {
+    put_bytes(&v, sizeof(v));
+}
+
+static void put_u32(uint32_t v) {
+    put_bytes(&v, sizeof(v));
+}
+
+void trace_dump(uint32_t n) {
+    // O laço principal fica parado durante o envio; só uma ISR poderia
+    // gravar, e no máximo sobrescreveria os eventos mais antigos.
+    uint32_t head  = trace_head;
+    uint32_t avail = head - trace_base;
+    uint32_t lost  = 0;
+
+    if (avail > TRACE_RING_LEN) {
+        lost  = avail - TRACE_RING_LEN;
+        avail = TRACE_RING_LEN;
+    }
+    if (n == 0 || n > avail) n = avail;
+
+    uint32_t bytes = TRACE_HDR_LEN + n * sizeof(trace_event_t);
+    uint16_t n_names = 0;
+    for (unsigned id = 0; id < TRACE_EV_COUNT; id++) {
+        if (!names[id].name) continue;
+        bytes += 4 + strlen(names[id].name);
+        n_names++;
+    }
+
+    printf("TRACE-BEGIN %lu\n", (unsigned long)bytes);
+    put_bytes(TRACE_MAGIC, 4);
+    put_u16(sizeof(trace_event_t));
+    put_u16(n_names);
+    put_u32(CONFIG_CLOCK_FREQUENCY);
+    put_u32(n);
+    put_u32(lost + (avail - n));
+    for (unsigned id = 0; id < TRACE_EV_COUNT; id++) {
+        if (!names[id].name) continue;
+        uint8_t len = (uint8_t)strlen(names[id].name);
+        put_u16((uint16_t)id);
+        uart_write(names[id].fmt);
+        uart_write(len);
+        put_bytes(names[id].name, len);
+    }
+    for (uint32_t i = head - n; i != head; i++)
+        put_bytes(&trace_ring[i & (TRACE_RING_LEN - 1)], sizeof(trace_event_t));
+    printf("\nTRACE-END\n");
+}
+
+void trace_stats(void) {
+    uint32_t total = trace_head - trace_base;
+    uint32_t lost  = total > TRACE_RING_LEN ? total - TRACE_RING_LEN : 0;
+
+    printf("Rastreio: %s, %lu eventos gravados, %lu sobrescritos, anel de %d (%lu KB)\n",
+           TRACE_ENABLE ? "ligado" : "compilado fora",
+           (unsigned long)total, (unsigned long)lost, TRACE_RING_LEN,
+           (unsigned long)(sizeof(trace_ring) / 1024));
+}
+
+void trace_clear(void) {
+    trace_base = trace_head;
+}
@@ -0,0 +1,111 @@
+// ./lib/trace.h
+#pragma once
+#include <stdint.h>
+#include <irq.h>
+#include <generated/csr.h>
+#include <generated/soc.h>
+
+// ============================================
+// === Linha do tempo de eventos (SDRAM) ===
+// ============================================
+/*
+ * Anel de eventos binários de 12 bytes (instante em ciclos, id, argumento)
+ * em main_ram (SDRAM), para ver *quando* cada etapa aconteceu, não só
+ * médias. Não confundir com o rastreio de latência nos quadros ('cfg_set
+ * trace', FRAME_TYPE_TRACE).
+ *
+ * Um ponto de rastreio é inline: desliga a IRQ, trava o uptime do timer0,
+ * duas leituras de CSR e três stores, sem formatar nada; fica ligado em
+ * produção. "make TRACE=0" tira todos do binário. Quando o anel dá a volta,
+ * o evento mais antigo é sobrescrito.
+ *
+ * 'trace_dump' envia o anel em binário pela UART; o formato está em
+ * trace.c e hardware/tools/trace2perfetto.py o converte para o JSON do
+ * Chrome/Perfetto.
+ */
+#ifndef TRACE_ENABLE
+#define TRACE_ENABLE 1
+#endif
+
+#ifndef TRACE_RING_LEN
+#define TRACE_RING_LEN 16384        // Eventos (potência de 2): 192 KB
+#endif
+
+// Fase, nos 2 bits altos do id: o conversor monta as fatias com BEGIN/END.
+#define TRACE_PH_INSTANT 0x0000
+#define TRACE_PH_BEGIN   0x4000
+#define TRACE_PH_END     0x8000
+#define TRACE_PH_COUNTER 0xC000
+#define TRACE_ID_MASK    0x3FFF
+
+// Argumento com instância (rádio, barramento) no byte alto: cada instância
+// vira uma trilha no visualizador.
+#define TRACE_ARG(inst, val) (((uint32_t)(inst) << 24) | ((uint32_t)(val) & 0xFFFFFFu))
+
+typedef enum {
+    TRACE_EV_CONSOLE = 1,       // Comando do console (arg: 4 primeiros caracteres)
+    TRACE_EV_SAMPLE,            // Leitura dos sensores + política de envio
+    TRACE_EV_SENSOR_TRIGGER,    // Comando de medição do AHT10 (inst: barramento)
+    TRACE_EV_SENSOR_FETCH,      // Leitura dos 6 bytes do AHT10 (inst: barramento)
+    TRACE_EV_RADIO_TX,          // rfm95_tx_start() -> TxDone visto (inst: rádio, val: bytes)
+    TRACE_EV_RADIO_LOAD,        // Carga do FIFO (SPI ou DMA)
+    TRACE_EV_RADIO_TIMEOUT,     // TX sem TxDone
+    TRACE_EV_RADIO_RX,          // RxDone (val: bytes)
+    TRACE_EV_RADIO_RX_ERROR,    // CRC inválido ou quadro grande demais
+    TRACE_EV_TX_QUEUE,          // Contador: quadros na fila do despachante
+    TRACE_EV_TX_DROP,           // Fila cheia
+    TRACE_EV_SEAL,              // frame_seal() (AES CTR + CMAC)
+    TRACE_EV_TDMA_BEACON,       // Beacon aceito (val: seq)
+    TRACE_EV_GATEWAY_TX,        // Datagrama UDP (val: bytes)
+    TRACE_EV_LOG_FLUSH,         // Registros de log formatados na UART
+    TRACE_EV_COUNT
+} trace_id_t;
+
+typedef struct {
+    uint32_t ts_lo;             // Ciclos desde o reset, 32 bits baixos
+    uint16_t ts_hi;             // Bits 32..47 (54 dias a 60 MHz)
+    uint16_t id;                // trace_id_t | TRACE_PH_*
+    uint32_t arg;
+} trace_event_t;
+
+extern trace_event_t     trace_ring[TRACE_RING_LEN];
+extern volatile uint32_t trace_head;    // Total de eventos gravados
+
+static inline void trace_event(uint16_t id, uint32_t arg) {
+#if TRACE_ENABLE && defined(CSR_TIMER0_UPTIME_CYCLES_ADDR)
+#ifdef CONFIG_CPU_HAS_INTERRUPT
+    unsigned int ie = irq_getie();
+    irq_setie(0);
+#endif
+    trace_event_t *e = &trace_ring[trace_head++ & (TRACE_RING_LEN - 1)];
+    // CSR de 64 bits em duas palavras, a mais significativa primeiro.
+    timer0_uptime_latch_write(1);
+    e->ts_hi = (uint16_t)csr_read_simple(CSR_TIMER0_UPTIME_CYCLES_ADDR);
+    e->ts_lo = csr_read_simple(CSR_TIMER0_UPTIME_CYCLES_ADDR + 4);
+    e->id    = id;
+    e->arg   = arg;
+#ifdef CONFIG_CPU_HAS_INTERRUPT
+    irq_setie(ie);
+#endif
+#else
+    (void)id;
+    (void)arg;
+#endif
+}
+
+#define TRACE_MARK(id, arg)   trace_event((id), (arg))
+#define TRACE_BEGIN(id, arg)  trace_event((id) | TRACE_PH_BEGIN, (arg))
+#define TRACE_END(id, arg)    trace_event((id) | TRACE_PH_END, (arg))
+#define TRACE_COUNT(id, v)    trace_event((id) | TRACE_PH_COUNTER, (v))
+
+/**
+ * @brief Envia pela UART, em binário, os 'n' eventos mais recentes (0 =
+ * todos os que estão no anel), do mais antigo para o mais novo.
+ */
+void trace_dump(uint32_t n);
+
+/** @brief Eventos gravados, sobrescritos e tamanho do anel. */
+void trace_stats(void);
+
+/** @brief Esvazia o anel. */
+void trace_clear(void);
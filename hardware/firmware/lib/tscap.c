@@ -0,0 +1,243 @@
+#include "tscap.h"
+
+#ifdef TSCAP_AVAILABLE
+#include "rfm95.h"
+#include "aht10.h"
+#include "lora_dispatch.h"
+#include "tdma.h"
+#include "cycles.h"
+
+#include <stdio.h>
+
+#define TSCAP_SPI_REPEAT 16             // Transações por medida (o FIFO tem 32 entradas)
+#define TSCAP_TX_LEN     6              // Tipo 0: o receptor descarta o quadro de teste
+#define TSCAP_POLL_MAX   4000           // Leituras de status do AHT10
+
+static uint32_t cycles_to_ns(uint32_t c) {
+    return (uint32_t)((uint64_t)c * 1000000000u / CONFIG_CLOCK_FREQUENCY);
+}
+
+// ============================================
+// === Acesso ao core ===
+// ============================================
+
+void tscap_start(uint32_t mask) {
+    tscap_control_write(0);
+    tscap_mask_write(mask);
+    tscap_control_write(1 << CSR_TSCAP_CONTROL_CLEAR_OFFSET);
+    tscap_control_write(1 << CSR_TSCAP_CONTROL_ENABLE_OFFSET);
+}
+
+void tscap_set_mask(uint32_t mask) {
+    tscap_mask_write(mask);
+}
+
+void tscap_stop(void) {
+    tscap_control_write(0);
+}
+
+bool tscap_pop(tscap_entry *e) {
+    uint32_t level = (tscap_status_read() >> CSR_TSCAP_STATUS_LEVEL_OFFSET) &
+                     ((1 << CSR_TSCAP_STATUS_LEVEL_SIZE) - 1);
+    if (level == 0) return false;
+    e->ts     = tscap_ts_read();
+    e->events = tscap_events_read();
+    tscap_pop_write(1);
+    return true;
+}
+
+bool tscap_overflow(void) {
+    return (tscap_status_read() >> CSR_TSCAP_STATUS_OVERFLOW_OFFSET) & 1;
+}
+
+// ============================================
+// === Medidas ===
+// ============================================
+
+typedef struct {
+    uint32_t n, sum, min, max;          // Ciclos
+} tscap_stat;
+
+static void stat_add(tscap_stat *s, uint32_t c) {
+    if (s->n == 0 || c < s->min) s->min = c;
+    if (c > s->max) s->max = c;
+    s->sum += c;
+    s->n++;
+}
+
+static void stat_print(const char *name, const tscap_stat *s) {
+    if (s->n == 0) {
+        printf("  %-22s sem eventos\n", name);
+        return;
+    }
+    printf("  %-22s n=%lu min %lu ns, media %lu ns, max %lu ns\n", name, (unsigned long)s->n,
+           (unsigned long)cycles_to_ns(s->min), (unsigned long)cycles_to_ns(s->sum / s->n),
+           (unsigned long)cycles_to_ns(s->max));
+}
+
+// Duração de cada transação (CS baixo) e o intervalo entre elas (CPU + driver).
+static void measure_spi(rfm95_t *r) {
+    uint32_t cs = TSCAP_RADIO_EV(r->id, TSCAP_CS), end = TSCAP_RADIO_EV(r->id, TSCAP_CS_END);
+    tscap_stat busy = {0}, gap = {0};
+    uint32_t t_cs = 0, t_end = 0;
+    bool in_cs = false, ended = false;
+    tscap_entry e;
+
+    tscap_start(cs | end);
+    for (unsigned i = 0; i < TSCAP_SPI_REPEAT; i++)
+        (void)rfm95_read_reg(r, 0x42);  // REG_VERSION
+    tscap_stop();
+
+    while (tscap_pop(&e)) {
+        if (e.events & cs) {
+            if (ended) stat_add(&gap, e.ts - t_end);
+            t_cs  = e.ts;
+            in_cs = true;
+        }
+        if ((e.events & end) && in_cs) {
+            stat_add(&busy, e.ts - t_cs);
+            t_end = e.ts;
+            in_cs = false;
+            ended = true;
+        }
+    }
+    printf("Radio %u: rfm95_read_reg x%d\n", r->id, TSCAP_SPI_REPEAT);
+    stat_print("CS baixo (transacao)", &busy);
+    stat_print("entre transacoes", &gap);
+}
+
+/*
+ * Tempo no ar: do fim da escrita do modo TX (último CS antes do DIO0) à
+ * subida do DIO0 (TxDone). Inclui a partida do transmissor (PLL e rampa do
+ * PA), que a fórmula do datasheet não conta.
+ */
+static void measure_airtime(rfm95_t *r) {
+    static const uint8_t frame[TSCAP_TX_LEN];
+    uint32_t dio0 = TSCAP_RADIO_EV(r->id, TSCAP_DIO0), end = TSCAP_RADIO_EV(r->id, TSCAP_CS_END);
+    bool implicit = r->implicit_len && TSCAP_TX_LEN == r->implicit_len;
+    uint32_t theory = rfm95_airtime_us(r, TSCAP_TX_LEN, implicit);
+    uint32_t t_start = 0, t_done = 0;
+    bool started = false, done = false;
+    rfm95_tx_status st;
+    uint64_t seen;
+    tscap_entry e;
+
+    if (!r->dio0) {
+        printf("Radio %u: sem DIO0 (--with-lora-dio0), tempo no ar nao medido\n", r->id);
+        return;
+    }
+    if (r->tx_busy) {
+        printf("Radio %u: TX em andamento, tempo no ar nao medido\n", r->id);
+        return;
+    }
+
+    tscap_start(end | dio0);
+    if (!rfm95_tx_start(r, frame, sizeof(frame))) {
+        tscap_stop();
+        return;
+    }
+    // Daqui em diante só o DIO0 interessa.
+    tscap_set_mask(dio0);
+
+    // Mesmo polling do laço principal: o 'seen' erra como ele.
+    do {
+        seen = cycles_now();
+        st = rfm95_tx_poll(r);
+    } while (st == RFM95_TX_BUSY);
+    tscap_stop();
+
+    while (tscap_pop(&e)) {
+        if (!done && (e.events & end)) { t_start = e.ts; started = true; }
+        if (!done && (e.events & dio0)) { t_done = e.ts; done = true; }
+    }
+
+    printf("Radio %u: quadro de %d bytes, SF%u, %s\n", r->id, TSCAP_TX_LEN, r->sf,
+           implicit ? "implicito" : "explicito");
+    if (st != RFM95_TX_DONE || !started || !done || tscap_overflow()) {
+        printf("  tempo no ar nao medido (TxDone %s, FIFO %s)\n",
+               st == RFM95_TX_DONE ? "ok" : "ausente", tscap_overflow() ? "cheio" : "ok");
+        return;
+    }
+    uint32_t hw_ns = cycles_to_ns(t_done - t_start);
+    uint32_t sw_us = cycles_to_us(seen - r->tx_start);
+    printf("  teorico %lu us, DIO0 (hardware) %lu.%03lu us, polling %lu us\n",
+           (unsigned long)theory, (unsigned long)(hw_ns / 1000), (unsigned long)(hw_ns % 1000),
+           (unsigned long)sw_us);
+    printf("  hardware - teorico: %ld us, polling - hardware: %ld us\n",
+           (long)(hw_ns / 1000) - (long)theory, (long)sw_us - (long)(hw_ns / 1000));
+}
+
+/*
+ * Conversão do AHT10: do STOP do comando de medição ao START da primeira
+ * leitura de status sem "busy". As leituras são seguidas, então a conversão
+ * fica entre a última leitura ocupada e a primeira pronta.
+ */
+static void measure_conversion(i2c_bus_t *b) {
+    uint32_t start = TSCAP_BUS_EV(b->id, TSCAP_START), stop = TSCAP_BUS_EV(b->id, TSCAP_STOP);
+    uint32_t t_cmd = 0, t_trig = 0, t_busy = 0, t_ready = 0;
+    unsigned polls = 0;
+    bool ready = false;
+    tscap_entry e;
+
+    tscap_start(start | stop);
+    if (!aht10_trigger(b)) {
+        tscap_stop();
+        printf("AHT10 %u: sem resposta ao comando de medicao\n", b->id);
+        return;
+    }
+    while (tscap_pop(&e)) {
+        if (e.events & start) t_cmd  = e.ts;
+        if (e.events & stop)  t_trig = e.ts;
+    }
+
+    t_busy = t_trig;
+    tscap_set_mask(start);
+    while (!ready && polls < TSCAP_POLL_MAX) {
+        uint32_t t = 0;
+        ready = aht10_ready(b);
+        polls++;
+        while (tscap_pop(&e))
+            if (e.events & start) t = e.ts;
+        if (ready) t_ready = t;
+        else       t_busy  = t;
+    }
+    tscap_stop();
+
+    uint32_t cmd_ns = cycles_to_ns(t_trig - t_cmd);
+    printf("AHT10 %u: comando de medicao %lu.%03lu us no barramento\n", b->id,
+           (unsigned long)(cmd_ns / 1000), (unsigned long)(cmd_ns % 1000));
+    if (!ready) {
+        printf("  conversao nao terminou em %u leituras de status\n", polls);
+        return;
+    }
+    printf("  conversao entre %lu e %lu us (%u leituras de status; espera fixa do driver: %d ms)\n",
+           (unsigned long)cycles_to_us(t_busy - t_trig), (unsigned long)cycles_to_us(t_ready - t_trig),
+           polls, AHT10_CONVERSION_MS);
+}
+
+void tscap_measure(bool lora, bool sensor) {
+    bool any = false;
+
+    printf("Captura em hardware: resolucao %lu ns\n",
+           (unsigned long)cycles_to_ns(1));
+    if (lora) {
+        for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++) {
+            if (!dispatch_radio_ok(i)) continue;
+            measure_spi(rfm95_radio(i));
+            if (tdma_enabled())
+                printf("Radio %u: TDMA ligado, tempo no ar nao medido (TX fora do slot)\n", i);
+            else
+                measure_airtime(rfm95_radio(i));
+            any = true;
+        }
+    }
+    if (sensor) {
+        for (unsigned i = 0; i < AHT10_NUM_BUSES; i++) {
+            if (!i2c_bus(i)->present) continue;
+            measure_conversion(i2c_bus(i));
+            any = true;
+        }
+    }
+    if (!any) puts("Nada a medir: rode 'lora_setup' e/ou 'sensor_setup'.");
+}
+#endif
@@ -0,0 +1,62 @@
+// ./lib/tscap.h
+#pragma once
+#include <stdbool.h>
+#include <stdint.h>
+#include <generated/csr.h>
+#include <generated/soc.h>
+
+// ============================================
+// === Captura de timestamps em hardware ===
+// ============================================
+/*
+ * Com --with-tscap, o gateware (hardware/litex/tscap_core.py) trava um
+ * contador livre de ciclos nas bordas do DIO0, do CS de cada rádio e no
+ * START/STOP de cada barramento I2C, e enfileira instante + máscara de
+ * eventos num FIFO. Os instantes de software em volta do TX e do TxDone
+ * erram pelo período do polling; os do FIFO têm a resolução do clock.
+ *
+ * Bits dos eventos (constantes TSCAP_* do soc.h): 3 por rádio a partir de
+ * TSCAP_LORA0_DIO0 e depois 2 por barramento a partir de TSCAP_I2C0_START.
+ * Sem --with-lora-dio0, o bit do DIO0 existe mas nunca dispara.
+ * O contador tem 32 bits (71 s a 60 MHz): só diferenças têm sentido.
+ */
+#ifdef CSR_TSCAP_BASE
+#define TSCAP_AVAILABLE 1
+
+#define TSCAP_DIO0      0           // DIO0 sobe (TxDone/RxDone)
+#define TSCAP_CS        1           // CS baixa: início da transação SPI
+#define TSCAP_CS_END    2           // CS sobe: fim da transação
+#define TSCAP_RADIO_EV(id, k)   (1u << (TSCAP_LORA0_DIO0 + 3 * (id) + (k)))
+
+#define TSCAP_START     0           // SDA cai com SCL alto
+#define TSCAP_STOP      1           // SDA sobe com SCL alto
+#define TSCAP_BUS_EV(id, k)     (1u << (TSCAP_I2C0_START + 2 * (id) + (k)))
+
+typedef struct {
+    uint32_t ts;                    // Ciclo (32 bits baixos do contador)
+    uint32_t events;                // TSCAP_*_EV() do mesmo ciclo
+} tscap_entry;
+
+/** @brief Esvazia o FIFO e liga a captura dos eventos de 'mask'. */
+void tscap_start(uint32_t mask);
+
+/** @brief Troca os eventos capturados sem esvaziar o FIFO. */
+void tscap_set_mask(uint32_t mask);
+
+/** @brief Desliga a captura. */
+void tscap_stop(void);
+
+/** @brief Retira a entrada mais antiga do FIFO; false se vazio. */
+bool tscap_pop(tscap_entry *e);
+
+/** @brief true se algum evento se perdeu com o FIFO cheio desde o tscap_start(). */
+bool tscap_overflow(void);
+
+/**
+ * @brief Mede com a captura: duração das transações SPI e tempo no ar (CS
+ * do modo TX -> DIO0) de cada rádio pronto, comparado com rfm95_airtime_us()
+ * e com o polling; comando I2C e tempo de conversão de cada AHT10 presente.
+ * Transmite um quadro de teste por rádio ('lora' false pula os rádios).
+ */
+void tscap_measure(bool lora, bool sensor);
+#endif
@@ -3,7 +3,6 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
-#include <math.h>
 
 #include <irq.h>
 #include <uart.h>
@@ -11,15 +10,34 @@
 #include <generated/csr.h>
 
 #include "./lib/rfm95.h"
+#include "./lib/log.h"
+#include "./lib/cycles.h"
+#include "./lib/config.h"
+#include "./lib/fastmem.h"
+#include "./lib/bench.h"
+#include "./lib/frame.h"
+#include "./lib/lora_dispatch.h"
+#include "./lib/tdma.h"
+#include "./lib/gateway.h"
+#include "./lib/sdlog.h"
+#include "./lib/aes.h"
+#include "./lib/trace.h"
+#include "./lib/tscap.h"
 
 #include "./lib/aht10.h" 
-void i2c_init(void);
 
 #define N_ELEMENTS 8
 
 static bool g_lora_ok   = false;
 static bool g_sensor_ok = false;
 
+static fw_config_t g_cfg;
+static frame_keys  g_keys;
+static bool        g_epoch_taken = false;
+static bool     g_sampling     = false;
+static uint64_t g_next_sample  = 0;
+static bool     g_first_packet = true;
+
 static char *readstr(void)
 {
     char c[2];
@@ -82,12 +100,50 @@ static void help(void)
     puts("Comandos Auxiliares:");
     puts("help                 - Mostra todos os comandos disponiveis");
     puts("reboot               - Reinicia a CPU");
+    puts("log_level [0-4]      - Mostra/ajusta o nivel de log (0=off ... 4=debug)");
+    puts("log_stats            - Mostra registros pendentes e descartados");
+    puts("bench                - Roda a suite de benchmarks (ciclos por etapa)");
+    puts("trace_dump [n]       - Envia os n eventos mais recentes em binario (trace2perfetto.py)");
+    puts("trace_stats          - Eventos gravados e sobrescritos no anel");
+    puts("trace_clear          - Esvazia o anel de eventos");
+#ifdef TSCAP_AVAILABLE
+    puts("tscap                - Mede SPI, tempo no ar e conversao do AHT10 com a captura em hardware");
+#endif
     puts("\nComandos do módulo LoRa:");
-    puts("lora_setup           - Realiza o setup do modulo LoRa (freq 915MHz)");
-    puts("lora_info            - Lê informacoes do modulo LoRa");
+    puts("lora_setup           - Realiza o setup dos radios LoRa (915MHz + 200kHz por radio)");
+    puts("lora_info            - Lê informacoes dos radios LoRa");
+    puts("lora_stats           - Quadros enviados por radio e fila de TX");
+    puts("lora_airtime         - Tempo no ar do quadro de amostra com/sem cabecalho");
+    puts("tdma_start           - Transmite so nos slots do beacon do receptor");
+    puts("tdma_stop            - Volta a transmitir livremente");
+    puts("tdma_stats           - Sincronismo, slots e deriva do relogio");
+#ifdef GATEWAY_AVAILABLE
+    puts("gateway_start [ip] [porta] - Encaminha os quadros recebidos por UDP");
+    puts("gateway_stop         - Para o gateway");
+    puts("gateway_stats        - Quadros recebidos e datagramas enviados");
+#endif
     puts("\nComandos do sensor AHT10:");
     puts("sensor_setup         - Inicializa I2C e o AHT10");
-    puts("sensor_send          - Lê o AHT10 e envia via LoRa (temp/umid)\n\n");
+    puts("sensor_send          - Lê o AHT10 e envia via LoRa (temp/umid)");
+    puts("sample_start [ms]    - Inicia a amostragem periodica (send-on-delta)");
+    puts("sample_stop          - Para a amostragem periodica");
+    puts("report_stats         - Envios x supressoes da politica send-on-delta");
+#ifdef SDLOG_AVAILABLE
+    puts("\nLog no cartao SD:");
+    puts("sdlog_stats          - Segmentos gravados e capacidade");
+    puts("sdlog_sync           - Grava ja o segmento corrente");
+    puts("sdlog_dump <seq> [n] - Envia n segmentos a partir de seq em CSV");
+#endif
+    puts("\nConfiguracao persistente (flash):");
+    puts("cfg_show             - Mostra a configuracao atual");
+    puts("cfg_set autostart 0|1 - Setup de LoRa/AHT10 e amostragem no boot");
+    puts("cfg_set period <ms>  - Periodo da amostragem");
+    puts("cfg_set oversample|iir|deadband_t|deadband_h|heartbeat <v> - Politica de envio");
+    puts("cfg_set node <id> | tdma 0|1 - Id do no e TDMA no boot");
+    puts("cfg_set gateway 0|1  - Gateway no boot (host do ultimo gateway_start)");
+    puts("cfg_set implicit <n> - Quadros de n bytes sem cabecalho LoRa (receptor igual)");
+    puts("cfg_set key <32 hex> | crypt 0|1 - Chave AES-128 e quadros cifrados");
+    puts("cfg_save             - Grava a configuracao na flash\n\n");
 }
 
 static void reboot(void)
@@ -95,88 +151,722 @@ static void reboot(void)
     ctrl_reset_write(1);
 }
 
+static void log_level_cmd(char *str)
+{
+    char *arg = get_token(&str);
+    if (*arg != 0) {
+        log_set_level((uint8_t)strtoul(arg, NULL, 0));
+    }
+    printf("Nivel de log: %d (compilado ate %d)\n", log_level, LOG_LEVEL_COMPILE);
+}
+
+static void log_stats(void)
+{
+    printf("Log: %u pendentes, %lu descartados, anel de %d registros\n",
+           log_pending(), (unsigned long)log_dropped(), LOG_RING_SIZE);
+}
+
 static void lora_info(void)
 {
     printf("Lendo LoRa...\n");
-    printf("Ret: %x\n", rfm95_read_reg(0x42));
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++) {
+        printf("Radio %u: Ret: %x\n", i, rfm95_read_reg(rfm95_radio(i), 0x42));
+    }
+}
+
+// Quadros do tamanho combinado (cfg_set implicit) saem sem cabeçalho; os
+// demais continuam com cabeçalho explícito.
+static void lora_apply_header(void)
+{
+    for (unsigned i = 0; i < RFM95_NUM_RADIOS; i++)
+        rfm95_radio(i)->implicit_len = g_cfg.lora_implicit_len;
 }
 
 static void lora_setup(void)
 {
-    printf("Configurando LoRa (915 MHz)...\n");
-    if (!rfm95_init()) {
+    printf("Configurando %d radio(s) LoRa (915 MHz + 200 kHz por radio)...\n", RFM95_NUM_RADIOS);
+    unsigned ready = dispatch_init();
+    if (ready == 0) {
         printf("Falha ao inicializar LoRa.\n");
         return;
     }
     g_lora_ok = true;
-    printf("LoRa pronto.\n");
+    lora_apply_header();
+    printf("LoRa pronto: %u de %d radio(s).\n", ready, RFM95_NUM_RADIOS);
 }
 
-static inline int16_t clamp_to_i16(int32_t v) {
-    if (v >  32767) return  32767;
-    if (v < -32768) return -32768;
-    return (int16_t)v;
+// O quadro de 4 bytes não tem nó nem sensor: só serve a um nó sem id com um AHT10.
+static bool sample_has_id(void)
+{
+    return g_cfg.node_id != 0 || AHT10_NUM_BUSES > 1;
+}
+
+// Tamanho do quadro de amostra que este nó envia.
+static size_t sample_frame_len(void)
+{
+    size_t len;
+
+    if (g_cfg.flags & CFG_TRACE) len = FRAME_TRACE_LEN;
+    else len = sample_has_id() ? FRAME_SAMPLE_ID_LEN : FRAME_SAMPLE_LEN;
+    return (g_cfg.flags & CFG_CRYPT) ? len + FRAME_SECURE_OVERHEAD : len;
 }
 
-static bool lora_send_data_i16(int16_t temperatura, int16_t umidade)
+// Tempo no ar do quadro de amostra com e sem cabeçalho, na modulação do rádio 0.
+static void lora_airtime(void)
 {
-    uint8_t buf[4];
-    buf[0] = (uint8_t)(temperatura & 0xFF);
-    buf[1] = (uint8_t)((temperatura >> 8) & 0xFF);
-    buf[2] = (uint8_t)(umidade & 0xFF);
-    buf[3] = (uint8_t)((umidade >> 8) & 0xFF);
+    rfm95_t *r = rfm95_radio(0);
+    size_t len = sample_frame_len();
 
-    printf("Enviando (i16): temp=%d (x0.01 C), umid=%d (x0.01 %%)\n", temperatura, umidade);
-    return rfm95_send_bytes(buf, sizeof(buf));
+    if (!g_lora_ok) {
+        LOG_ERR("LoRa nao inicializado. Rode 'lora_setup' primeiro.");
+        return;
+    }
+    uint32_t expl = rfm95_airtime_us(r, len, false);
+    uint32_t impl = rfm95_airtime_us(r, len, true);
+    printf("SF%u, %lu kHz, CR 4/%u, preambulo %u, LDRO %s\n", r->sf,
+           (unsigned long)(r->bw_hz / 1000), r->cr + 4, r->preamble,
+           rfm95_ldro_required(r->sf, r->bw_hz) ? "sim" : "nao");
+    printf("Quadro de %u bytes: explicito %lu us, implicito %lu us (economia de %lu us por quadro)\n",
+           (unsigned)len, (unsigned long)expl, (unsigned long)impl, (unsigned long)(expl - impl));
+    if (r->implicit_len)
+        printf("Cabecalho implicito ligado para quadros de %u bytes.\n", r->implicit_len);
+    else
+        printf("Cabecalho implicito desligado ('cfg_set implicit %u').\n", (unsigned)len);
+}
+
+// ============================================
+// === Quadros cifrados ===
+// ============================================
+/*
+ * A sequência dos quadros é época << 16 | contador. A época vai para a flash
+ * antes do primeiro quadro do boot: depois de um reset o nó não repete
+ * sequências que o receptor já aceitou (ele recusa seq <= último do nó).
+ * Só o campo da época é gravado; mudanças de cfg_set sem cfg_save ficam na RAM.
+ * Sem configuração válida na flash não há onde gravar só a época: a cifra
+ * fica desligada até um cfg_save.
+ */
+static bool crypt_new_epoch(void)
+{
+    fw_config_t saved;
+
+    if (!config_load(&saved)) {
+        LOG_ERR("Sem configuracao na flash para gravar a epoca. Use 'cfg_save'.");
+        return false;
+    }
+    saved.crypt_epoch = ++g_cfg.crypt_epoch;
+    if (!config_save(&saved))
+        LOG_WARN("Epoca %d so na RAM: apos um reset o receptor recusa os quadros", g_cfg.crypt_epoch);
+    return true;
+}
+
+// A chave zerada é a de fábrica: qualquer um forja quadros com ela.
+static bool crypt_key_set(void)
+{
+    bool set = false;
+    for (unsigned i = 0; i < AES_KEY_LEN; i++) set |= g_cfg.crypt_key[i] != 0;
+    return set;
+}
+
+static void crypt_apply(void)
+{
+    if (!(g_cfg.flags & CFG_CRYPT)) {
+        dispatch_set_seal(NULL, 0, 0);
+        return;
+    }
+    if (!crypt_key_set()) {
+        LOG_ERR("Cifra com a chave zerada. Use 'cfg_set key <32 hex>'.");
+        dispatch_set_seal(NULL, 0, 0);
+        return;
+    }
+    if (g_cfg.node_id == 0) {
+        LOG_ERR("Cifra precisa de um id. Use 'cfg_set node <1-255>'.");
+        dispatch_set_seal(NULL, 0, 0);
+        return;
+    }
+    if (!g_epoch_taken) {
+        if (!crypt_new_epoch()) {
+            dispatch_set_seal(NULL, 0, 0);
+            return;
+        }
+        g_epoch_taken = true;
+    }
+
+    uint32_t seq = dispatch_seal_seq();
+    if ((seq >> 16) != g_cfg.crypt_epoch) seq = (uint32_t)g_cfg.crypt_epoch << 16;
+    frame_keys_init(&g_keys, g_cfg.crypt_key);
+    dispatch_set_seal(&g_keys, g_cfg.node_id, seq);
+    LOG_INFO("Quadros cifrados: no %d, epoca %d, AES no gateware %d", g_cfg.node_id,
+             g_cfg.crypt_epoch, (int)aes_hw_available());
+}
+
+static bool parse_key(const char *hex, uint8_t key[AES_KEY_LEN])
+{
+    if (strlen(hex) != 2 * AES_KEY_LEN) return false;
+    for (unsigned i = 0; i < AES_KEY_LEN; i++) {
+        char byte[3] = { hex[2 * i], hex[2 * i + 1], 0 };
+        char *end;
+        key[i] = (uint8_t)strtoul(byte, &end, 16);
+        if (*end != 0) return false;
+    }
+    return true;
+}
+
+// sensor: barramento AHT10 da amostra, que vai no quadro.
+// t_sample: ciclos em que a amostra ficou pronta na CPU (início do rastreio).
+static bool lora_send_data_i16(unsigned sensor, int16_t temperatura, int16_t umidade, uint64_t t_sample)
+{
+    uint8_t buf[FRAME_TRACE_LEN];
+
+    LOG_DBG("Enviando (i16): sensor %d, temp=%d (x0.01 C), umid=%d (x0.01 %%)",
+            (int)sensor, temperatura, umidade);
+    // Contador da época perto do fim (folga para a fila de TX): época nova.
+    if ((g_cfg.flags & CFG_CRYPT) && (dispatch_seal_seq() & 0xFFFF) >= 0xFF00) {
+        // Sem época nova, o crypt_apply tenta de novo e desliga a cifra.
+        if (!crypt_new_epoch()) g_epoch_taken = false;
+        crypt_apply();
+    }
+    // O TX sai pelo próximo rádio livre; o TxDone é tratado em dispatch_service().
+    if (g_cfg.flags & CFG_TRACE) {
+        size_t len = frame_encode_trace(buf, g_cfg.node_id, (uint8_t)sensor, temperatura, umidade);
+        return dispatch_send_traced(buf, len, t_sample);
+    }
+
+    size_t len = sample_has_id()
+        ? frame_encode_sample_id(buf, g_cfg.node_id, (uint8_t)sensor, temperatura, umidade)
+        : frame_encode_sample(buf, temperatura, umidade);
+    return dispatch_send(buf, len);
+}
+
+// O uptime conta desde o reset do SoC: inclui BIOS e cópia da flash.
+static void first_packet_check(void)
+{
+    if (g_first_packet && dispatch_sent() > 0) {
+        g_first_packet = false;
+        LOG_INFO("Primeiro pacote enviado %d ms apos o reset",
+                 (int)cycles_to_ms(cycles_now()));
+    }
 }
 
-static bool lora_send_data(float temp_c, float umid_pct)
+/*
+ * A leitura por software espera 80 ms por sobreamostra (até ~640 ms): o
+ * beacon TDMA é procurado a cada 1 ms dessas esperas, senão o instante do
+ * RxDone sairia atrasado pelo laço inteiro.
+ */
+static void sensor_wait_hook(void)
 {
-    int32_t t = (int32_t)lroundf(temp_c  * 100.0f);
-    int32_t u = (int32_t)lroundf(umid_pct * 100.0f);
-    return lora_send_data_i16(clamp_to_i16(t), clamp_to_i16(u));
+    if (g_lora_ok) tdma_service();
 }
 
 static void sensor_setup(void)
 {
-    printf("Inicializando I2C e AHT10...\n");
-    i2c_init();
-    aht10_init();
-    g_sensor_ok = true;
-    printf("AHT10 pronto.\n");
+    unsigned found = 0;
+
+    printf("Inicializando I2C e AHT10 (%d barramento(s))...\n", AHT10_NUM_BUSES);
+    for (unsigned i = 0; i < AHT10_NUM_BUSES; i++) {
+        i2c_bus_t *b = i2c_bus(i);
+        i2c_init(b);
+        if (aht10_init(b) == 0) found++;
+        else printf("  AHT10 %u nao respondeu.\n", i);
+    }
+    g_sensor_ok = found > 0;
+    printf("AHT10 pronto: %u de %d sensor(es).\n", found, AHT10_NUM_BUSES);
 }
 
-static bool sensor_read_once(float *temp_c, float *umid_pct)
+// Leitura em ponto fixo (x100): o picorv32 não tem FPU, então nada de float.
+// Todos os sensores são disparados juntos: custa uma conversão, não N.
+static unsigned sensor_read_once(dados *d, bool *ok)
 {
     if (!g_sensor_ok) {
-        printf("ERRO: Sensor nao inicializado. Rode 'sensor_setup' primeiro.\n");
-        return false;
+        LOG_ERR("Sensor nao inicializado. Rode 'sensor_setup' primeiro.");
+        return 0;
     }
-
-    dados my_data;
-    if (!aht10_get_data(&my_data)) {
-        printf("ERRO ao ler AHT10.\n");
-        return false;
+#ifdef AHT10_HAS_SAMPLER
+    // Com o amostrador ligado o barramento é do gateware.
+    if (g_sampling) {
+        LOG_ERR("I2C em uso pelo amostrador. Rode 'sample_stop' primeiro.");
+        return 0;
     }
+#endif
 
-    *temp_c  = (float)my_data.temperatura / 100.0f;
-    *umid_pct = (float)my_data.umidade / 100.0f;
+    unsigned n = aht10_read_all(d, ok);
+    if (n == 0) {
+        LOG_ERR("Falha ao ler AHT10.");
+        return 0;
+    }
 
-    printf("AHT10 -> Temperatura: %d.%02d C, Umidade: %d.%02d %%\n",
-           my_data.temperatura/100, abs(my_data.temperatura)%100,
-           my_data.umidade/100,     abs(my_data.umidade)%100);
+    for (unsigned i = 0; i < AHT10_NUM_BUSES; i++) {
+        if (!ok[i]) continue;
+        // Dois registros: o log guarda no máximo LOG_MAX_ARGS argumentos.
+        LOG_INFO("AHT10 %d -> Temperatura: %d.%02d C", (int)i,
+               d[i].temperatura/100, abs(d[i].temperatura)%100);
+        LOG_INFO("AHT10 %d -> Umidade: %d.%02d %%", (int)i,
+               d[i].umidade/100, abs(d[i].umidade)%100);
+    }
 
-    return true;
+    return n;
 }
 
+// Um quadro por sensor; o despachante os distribui pelos rádios.
 static void sensor_send(void)
 {
-    float t, u;
-    if (!sensor_read_once(&t, &u)) return;
+    dados d[AHT10_NUM_BUSES];
+    bool  ok[AHT10_NUM_BUSES];
+    uint64_t t0 = cycles_now();
+    if (sensor_read_once(d, ok) == 0) return;
+    uint64_t t_ready = cycles_now();
+    LOG_DBG("Leitura + conversao: %d us", (int)cycles_to_us32(t_ready - t0));
+
+    for (unsigned i = 0; i < AHT10_NUM_BUSES; i++) {
+        if (ok[i] && !lora_send_data_i16(i, d[i].temperatura, d[i].umidade, t_ready)) {
+            LOG_ERR("Falha durante envio LoRa.");
+            return;
+        }
+    }
+}
+
+// ============================================
+// === Política de envio (send-on-delta) ===
+// ============================================
+/*
+ * Cada amostra é a mediana de report_oversample leituras, passada por um
+ * IIR inteiro (Q8). Só vira quadro se temperatura ou umidade andaram mais
+ * que a banda morta desde o último envio, ou se o heartbeat venceu: num
+ * ambiente que varia devagar a maior parte das amostras não gasta airtime.
+ */
+#define REPORT_OVERSAMPLE_MAX 8
+
+typedef enum {
+    REPORT_SUPPRESS = 0,
+    REPORT_FIRST,               // Primeira amostra depois do sample_start
+    REPORT_DELTA,               // Saiu da banda morta
+    REPORT_HEARTBEAT,           // Sem variação, mas o heartbeat venceu
+} report_reason;
+
+typedef struct {
+    dados    win[REPORT_OVERSAMPLE_MAX];
+    uint8_t  n;                 // Leituras na janela
+    bool     primed;
+    int32_t  iir_t, iir_h;      // Estado do IIR em Q8
+    int16_t  sent_t, sent_h;    // Último valor transmitido
+    uint64_t sent_at;           // ciclos
+
+    uint32_t sent_delta;
+    uint32_t sent_heartbeat;
+    uint32_t suppressed;
+} report_state;
+
+static report_state g_report[AHT10_NUM_BUSES];
+
+static void report_reset(void)
+{
+    for (unsigned i = 0; i < AHT10_NUM_BUSES; i++) {
+        g_report[i].n = 0;
+        g_report[i].primed = false;
+    }
+}
+
+static unsigned report_oversample(void)
+{
+    unsigned n = g_cfg.report_oversample;
+    return n == 0 ? 1 : (n > REPORT_OVERSAMPLE_MAX ? REPORT_OVERSAMPLE_MAX : n);
+}
+
+static void report_push(report_state *s, const dados *d)
+{
+    if (s->n < REPORT_OVERSAMPLE_MAX) s->win[s->n++] = *d;
+}
+
+// Inserção: a janela tem no máximo REPORT_OVERSAMPLE_MAX valores.
+static int16_t median_i16(int16_t *v, unsigned n)
+{
+    for (unsigned i = 1; i < n; i++) {
+        int16_t x = v[i];
+        unsigned j = i;
+        for (; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+        v[j] = x;
+    }
+    // Número par: média dos dois do meio.
+    return (n & 1) ? v[n / 2] : (int16_t)((v[n / 2 - 1] + v[n / 2]) / 2);
+}
+
+static int16_t iir_step(int32_t *y, int16_t x, unsigned shift, bool primed)
+{
+    int32_t xq = (int32_t)x << 8;
+    if (!primed || shift == 0) *y = xq;
+    else                       *y += (xq - *y) >> shift;
+    return (int16_t)((*y + 128) >> 8);
+}
+
+static report_reason report_decide(report_state *s, const dados *d, uint64_t now)
+{
+    if (!s->primed) return REPORT_FIRST;
+    if (abs(d->temperatura - s->sent_t) >= g_cfg.report_deadband_t ||
+        abs(d->umidade     - s->sent_h) >= g_cfg.report_deadband_h)
+        return REPORT_DELTA;
+    if (g_cfg.report_heartbeat_ms &&
+        now - s->sent_at >= (uint64_t)g_cfg.report_heartbeat_ms * (CONFIG_CLOCK_FREQUENCY / 1000))
+        return REPORT_HEARTBEAT;
+    return REPORT_SUPPRESS;
+}
+
+// Fecha a janela do sensor 'id': mediana, IIR, decisão e, se for o caso, TX.
+static void report_process(unsigned id)
+{
+    report_state *s = &g_report[id];
+    int16_t t[REPORT_OVERSAMPLE_MAX], h[REPORT_OVERSAMPLE_MAX];
+    unsigned n = s->n;
+    dados d;
+
+    if (n == 0) return;
+    for (unsigned i = 0; i < n; i++) {
+        t[i] = s->win[i].temperatura;
+        h[i] = s->win[i].umidade;
+    }
+    s->n = 0;
+
+    d.temperatura = iir_step(&s->iir_t, median_i16(t, n), g_cfg.report_iir_shift, s->primed);
+    d.umidade     = iir_step(&s->iir_h, median_i16(h, n), g_cfg.report_iir_shift, s->primed);
+
+    uint64_t now = cycles_now();
+    report_reason why = report_decide(s, &d, now);
+    s->primed = true;
+
+#ifdef SDLOG_AVAILABLE
+    // Toda amostra filtrada vai para o cartão, enviada ou não.
+    sdlog_rec rec = {
+        .t_ms = cycles_to_ms(now), .sensor = (uint8_t)id, .reason = (uint8_t)why,
+        .temperatura = d.temperatura, .umidade = d.umidade,
+    };
+    sdlog_append(&rec);
+#endif
+
+    if (why == REPORT_SUPPRESS) {
+        s->suppressed++;
+        LOG_DBG("AHT10 %d: %d / %d dentro da banda morta, suprimido",
+                (int)id, d.temperatura, d.umidade);
+        return;
+    }
+
+    LOG_INFO("AHT10 %d -> Temperatura: %d.%02d C", (int)id,
+             d.temperatura/100, abs(d.temperatura)%100);
+    LOG_INFO("AHT10 %d -> Umidade: %d.%02d %%", (int)id,
+             d.umidade/100, abs(d.umidade)%100);
+
+    if (!lora_send_data_i16(id, d.temperatura, d.umidade, now)) {
+        LOG_ERR("Falha durante envio LoRa.");
+        return;
+    }
+    s->sent_t  = d.temperatura;
+    s->sent_h  = d.umidade;
+    s->sent_at = now;
+    if (why == REPORT_HEARTBEAT) s->sent_heartbeat++;
+    else                         s->sent_delta++;
+}
+
+// Amostragem por software: sobreamostra todos os sensores e aplica a política.
+static void sensor_report(void)
+{
+    dados d[AHT10_NUM_BUSES];
+    bool  ok[AHT10_NUM_BUSES];
+    unsigned n = report_oversample(), got = 0;
+
+    if (!g_sensor_ok) return;
+    TRACE_BEGIN(TRACE_EV_SAMPLE, n);
+    for (unsigned k = 0; k < n; k++) {
+        if (aht10_read_all(d, ok) == 0) continue;
+        got++;
+        for (unsigned i = 0; i < AHT10_NUM_BUSES; i++)
+            if (ok[i]) report_push(&g_report[i], &d[i]);
+    }
+    if (got == 0) {
+        TRACE_END(TRACE_EV_SAMPLE, 0);
+        LOG_ERR("Falha ao ler AHT10.");
+        return;
+    }
+    for (unsigned i = 0; i < AHT10_NUM_BUSES; i++)
+        report_process(i);
+    TRACE_END(TRACE_EV_SAMPLE, got);
+}
+
+static void report_stats(void)
+{
+    printf("Politica: mediana de %u, IIR >>%u, banda %u (x0.01 C) / %u (x0.01 %%), heartbeat %lu ms\n",
+           report_oversample(), (unsigned)g_cfg.report_iir_shift,
+           (unsigned)g_cfg.report_deadband_t, (unsigned)g_cfg.report_deadband_h,
+           (unsigned long)g_cfg.report_heartbeat_ms);
+    for (unsigned i = 0; i < AHT10_NUM_BUSES; i++) {
+        report_state *s = &g_report[i];
+        uint32_t sent  = s->sent_delta + s->sent_heartbeat;
+        uint32_t total = sent + s->suppressed;
+        printf("AHT10 %u: %lu enviados (%lu variacao, %lu heartbeat), %lu suprimidos (%lu%%)\n", i,
+               (unsigned long)sent, (unsigned long)s->sent_delta,
+               (unsigned long)s->sent_heartbeat, (unsigned long)s->suppressed,
+               (unsigned long)(total ? (uint64_t)s->suppressed * 100 / total : 0));
+    }
+}
+
+// ============================================
+// === Amostragem periódica ===
+// ============================================
+
+static void sample_start(uint32_t period_ms)
+{
+    if (!g_sensor_ok) {
+        LOG_ERR("Sensor nao inicializado. Rode 'sensor_setup' primeiro.");
+        return;
+    }
+    if (period_ms == 0) period_ms = g_cfg.sample_period_ms;
+    g_cfg.sample_period_ms = period_ms;
+    g_next_sample = cycles_now();
+    g_sampling = true;
+    report_reset();
+#ifdef AHT10_HAS_SAMPLER
+    aht10_sampler_start(period_ms);
+    printf("Amostragem em hardware a cada %lu ms\n", (unsigned long)period_ms);
+#else
+    printf("Amostragem a cada %lu ms\n", (unsigned long)period_ms);
+#endif
+}
+
+static void sample_stop(void)
+{
+    g_sampling = false;
+#ifdef AHT10_HAS_SAMPLER
+    aht10_sampler_stop();
+#endif
+    printf("Amostragem parada.\n");
+}
+
+#ifdef AHT10_HAS_SAMPLER
+// O gateware mede no período exato; aqui só drenamos o FIFO, convertemos e
+// transmitimos. Continua drenando depois do 'sample_stop' (amostras em voo).
+static void sampling_service(void)
+{
+    aht10_sample s;
+    uint32_t errors = aht10_sampler_errors();
+
+    if (errors) LOG_WARN("Amostrador AHT10: erro 0x%03X", (int)errors);
+
+    if (!aht10_sampler_pop(&s)) return;
+
+    LOG_DBG("AHT10 @%d us -> Temperatura: %d.%02d C, Umidade: %d.%02d %%",
+             (int)s.ts_us,
+             s.d.temperatura/100, abs(s.d.temperatura)%100,
+             s.d.umidade/100,     abs(s.d.umidade)%100);
+
+    if (!g_lora_ok) return;
+    // O período do amostrador vira o período de sobreamostragem.
+    report_push(&g_report[0], &s.d);
+    if (g_report[0].n >= report_oversample()) report_process(0);
+}
+#else
+static void sampling_service(void)
+{
+    if (!g_sampling) return;
+    if (cycles_now() < g_next_sample) return;
+
+    g_next_sample += (uint64_t)g_cfg.sample_period_ms * (CONFIG_CLOCK_FREQUENCY / 1000);
+    sensor_report();
+}
+#endif
+
+// ============================================
+// === TDMA ===
+// ============================================
+
+static void tdma_start(void)
+{
+    if (!g_lora_ok) {
+        LOG_ERR("LoRa nao inicializado. Rode 'lora_setup' primeiro.");
+        return;
+    }
+    if (g_cfg.node_id == 0) {
+        LOG_ERR("TDMA precisa de um id. Use 'cfg_set node <1-255>'.");
+        return;
+    }
+    tdma_enable(true, g_cfg.node_id);
+    printf("TDMA ligado: no %u aguardando beacon.\n", g_cfg.node_id);
+}
+
+static void tdma_stop(void)
+{
+    tdma_enable(false, g_cfg.node_id);
+    printf("TDMA desligado.\n");
+}
+
+// ============================================
+// === Gateway (LoRa -> UDP) ===
+// ============================================
+#ifdef GATEWAY_AVAILABLE
+
+// "a.b.c.d" -> IPv4 em ordem de host; 0 se inválido.
+static uint32_t parse_ip(const char *str)
+{
+    uint32_t ip = 0;
+    for (int i = 0; i < 4; i++) {
+        char *end;
+        unsigned long b = strtoul(str, &end, 10);
+        if (end == str || b > 255 || (i < 3 && *end != '.')) return 0;
+        ip = (ip << 8) | b;
+        str = end + 1;
+    }
+    return ip;
+}
+
+static void gateway_start_cmd(char *str)
+{
+    char *ip_arg   = get_token(&str);
+    char *port_arg = get_token(&str);
+
+    if (!g_lora_ok) {
+        LOG_ERR("LoRa nao inicializado. Rode 'lora_setup' primeiro.");
+        return;
+    }
+    if (tdma_enabled()) {
+        LOG_ERR("Gateway e TDMA usam o RX do radio 0. Rode 'tdma_stop' primeiro.");
+        return;
+    }
+    if (*ip_arg) g_cfg.gw_host = parse_ip(ip_arg);
+    if (*port_arg) g_cfg.gw_port = (uint16_t)strtoul(port_arg, NULL, 0);
+
+    uint32_t host = g_cfg.gw_host;
+#ifdef REMOTEIP1
+    if (host == 0) host = GATEWAY_IP(REMOTEIP1, REMOTEIP2, REMOTEIP3, REMOTEIP4);
+#endif
+    if (host == 0 || g_cfg.gw_port == 0) {
+        puts("Uso: gateway_start [a.b.c.d] [porta]");
+        return;
+    }
+    if (gateway_start(host, g_cfg.gw_port))
+        gateway_stats();
+}
+#endif
+
+// ============================================
+// === Log no cartão SD ===
+// ============================================
+#ifdef SDLOG_AVAILABLE
+static void sdlog_dump_cmd(char *str)
+{
+    char *seq_arg = get_token(&str);
+    char *n_arg   = get_token(&str);
+    uint32_t n = *n_arg ? strtoul(n_arg, NULL, 0) : 1;
+
+    sdlog_dump(strtoul(seq_arg, NULL, 0), n);
+}
+#endif
+
+// ============================================
+// === Configuração persistente ===
+// ============================================
+
+static void cfg_show(void)
+{
+    printf("autostart: %s (flags 0x%lx)\n",
+           (g_cfg.flags & CFG_AUTOSTART_SAMPLING) ? "sim" : "nao",
+           (unsigned long)g_cfg.flags);
+    printf("period:    %lu ms\n", (unsigned long)g_cfg.sample_period_ms);
+    printf("oversample: %u\n", (unsigned)g_cfg.report_oversample);
+    printf("iir:       %u\n", (unsigned)g_cfg.report_iir_shift);
+    printf("deadband_t: %u (x0.01 C)\n", (unsigned)g_cfg.report_deadband_t);
+    printf("deadband_h: %u (x0.01 %%)\n", (unsigned)g_cfg.report_deadband_h);
+    printf("heartbeat: %lu ms\n", (unsigned long)g_cfg.report_heartbeat_ms);
+    printf("node:      %u\n", g_cfg.node_id);
+    printf("implicit:  %u bytes\n", g_cfg.lora_implicit_len);
+    printf("tdma:      %s\n", (g_cfg.flags & CFG_TDMA) ? "sim" : "nao");
+    printf("trace:     %s\n", (g_cfg.flags & CFG_TRACE) ? "sim" : "nao");
+    printf("crypt:     %s, chave %s, epoca %u\n", (g_cfg.flags & CFG_CRYPT) ? "sim" : "nao",
+           crypt_key_set() ? "definida" : "zerada", g_cfg.crypt_epoch);
+    printf("gateway:   %s, host 0x%08lx porta %u\n", (g_cfg.flags & CFG_GATEWAY) ? "sim" : "nao",
+           (unsigned long)g_cfg.gw_host, g_cfg.gw_port);
+}
+
+static void cfg_set(char *str)
+{
+    char *key = get_token(&str);
+    char *val = get_token(&str);
+    uint32_t v = strtoul(val, NULL, 0);
+
+    if (strcmp(key, "autostart") == 0) {
+        uint32_t all = CFG_AUTOSTART_LORA | CFG_AUTOSTART_SENSOR | CFG_AUTOSTART_SAMPLING;
+        g_cfg.flags = v ? (g_cfg.flags | all) : (g_cfg.flags & ~all);
+    } else if (strcmp(key, "period") == 0 && v > 0) {
+        g_cfg.sample_period_ms = v;
+    } else if (strcmp(key, "oversample") == 0 && v >= 1 && v <= REPORT_OVERSAMPLE_MAX) {
+        g_cfg.report_oversample = (uint8_t)v;
+    } else if (strcmp(key, "iir") == 0 && v <= 8) {
+        g_cfg.report_iir_shift = (uint8_t)v;
+    } else if (strcmp(key, "deadband_t") == 0 && v <= 0xFFFF) {
+        g_cfg.report_deadband_t = (uint16_t)v;
+    } else if (strcmp(key, "deadband_h") == 0 && v <= 0xFFFF) {
+        g_cfg.report_deadband_h = (uint16_t)v;
+    } else if (strcmp(key, "heartbeat") == 0) {
+        g_cfg.report_heartbeat_ms = v;
+    } else if (strcmp(key, "node") == 0 && v <= 255) {
+        g_cfg.node_id = (uint8_t)v;
+        crypt_apply();
+    } else if (strcmp(key, "implicit") == 0 && v <= 255) {
+        g_cfg.lora_implicit_len = (uint8_t)v;
+        lora_apply_header();
+    } else if (strcmp(key, "tdma") == 0) {
+        g_cfg.flags = v ? (g_cfg.flags | CFG_TDMA) : (g_cfg.flags & ~CFG_TDMA);
+    } else if (strcmp(key, "gateway") == 0) {
+        g_cfg.flags = v ? (g_cfg.flags | CFG_GATEWAY) : (g_cfg.flags & ~CFG_GATEWAY);
+    } else if (strcmp(key, "trace") == 0) {
+        g_cfg.flags = v ? (g_cfg.flags | CFG_TRACE) : (g_cfg.flags & ~CFG_TRACE);
+    } else if (strcmp(key, "key") == 0 && parse_key(val, g_cfg.crypt_key)) {
+        crypt_apply();
+    } else if (strcmp(key, "crypt") == 0) {
+        if (v && !crypt_key_set()) {
+            puts("Chave zerada: defina antes com 'cfg_set key <32 digitos hex>'.");
+            return;
+        }
+        g_cfg.flags = v ? (g_cfg.flags | CFG_CRYPT) : (g_cfg.flags & ~CFG_CRYPT);
+        crypt_apply();
+    } else {
+        puts("Uso: cfg_set autostart 0|1 | period <ms> | oversample <1-8> | iir <0-8>");
+        puts("     cfg_set deadband_t|deadband_h <x0.01> | heartbeat <ms> | node <0-255> | tdma 0|1 | gateway 0|1");
+        puts("     cfg_set implicit <bytes> (0 = cabecalho explicito) | trace 0|1");
+        puts("     cfg_set key <32 digitos hex> | crypt 0|1");
+        return;
+    }
+    cfg_show();
+}
+
+static void cfg_save(void)
+{
+    if (config_save(&g_cfg))
+        printf("Configuracao gravada na flash.\n");
+    else
+        printf("Falha: SoC sem escrita na flash SPI.\n");
+}
+
+static void autostart(void)
+{
+    if (!config_load(&g_cfg)) return;
 
-    if (!lora_send_data(t, u)) {
-        printf("ERRO durante envio LoRa.\n");
+    crypt_apply();
+    if (g_cfg.flags & CFG_AUTOSTART_LORA)     lora_setup();
+    if (g_cfg.flags & CFG_AUTOSTART_SENSOR)   sensor_setup();
+    if ((g_cfg.flags & CFG_TDMA) && g_lora_ok && g_cfg.node_id)
+        tdma_enable(true, g_cfg.node_id);
+#ifdef GATEWAY_AVAILABLE
+    if ((g_cfg.flags & CFG_GATEWAY) && g_lora_ok && !tdma_enabled()) {
+        char none[] = "";
+        gateway_start_cmd(none);
     }
+#endif
+    if ((g_cfg.flags & CFG_AUTOSTART_SAMPLING) && g_lora_ok && g_sensor_ok)
+        sample_start(g_cfg.sample_period_ms);
+}
+
+// 4 primeiros caracteres do comando, para o nome da fatia no visualizador.
+static uint32_t trace_tag(const char *s)
+{
+    uint32_t tag = 0;
+    for (unsigned i = 0; i < 4 && s[i]; i++)
+        tag |= (uint32_t)(uint8_t)s[i] << (8 * i);
+    return tag;
 }
 
 static void console_service(void)
@@ -186,6 +876,8 @@ static void console_service(void)
     if(str == NULL) return;
 
     token = get_token(&str);
+    uint32_t tag = trace_tag(token);
+    TRACE_BEGIN(TRACE_EV_CONSOLE, tag);
 
     if(strcmp(token, "help") == 0) {
         help();
@@ -193,40 +885,143 @@ static void console_service(void)
     } else if(strcmp(token, "reboot") == 0) {
         reboot();
 
+    } else if(strcmp(token, "bench") == 0) {
+        bench_run(g_lora_ok, g_sensor_ok && !g_sampling);
+
+    } else if(strcmp(token, "log_level") == 0) {
+        log_level_cmd(str);
+
+    } else if(strcmp(token, "log_stats") == 0) {
+        log_stats();
+
+    } else if(strcmp(token, "trace_dump") == 0) {
+        trace_dump(strtoul(get_token(&str), NULL, 0));
+
+    } else if(strcmp(token, "trace_stats") == 0) {
+        trace_stats();
+
+    } else if(strcmp(token, "trace_clear") == 0) {
+        trace_clear();
+
+#ifdef TSCAP_AVAILABLE
+    } else if(strcmp(token, "tscap") == 0) {
+        tscap_measure(g_lora_ok, g_sensor_ok && !g_sampling);
+#endif
+
     } else if(strcmp(token, "lora_info") == 0) {
         lora_info();
 
+    } else if(strcmp(token, "lora_stats") == 0) {
+        dispatch_stats();
+
     } else if(strcmp(token, "lora_setup") == 0) {
         lora_setup();
 
+    } else if(strcmp(token, "lora_airtime") == 0) {
+        lora_airtime();
+
+    } else if(strcmp(token, "tdma_start") == 0) {
+        tdma_start();
+
+    } else if(strcmp(token, "tdma_stop") == 0) {
+        tdma_stop();
+
+    } else if(strcmp(token, "tdma_stats") == 0) {
+        tdma_stats();
+
+#ifdef GATEWAY_AVAILABLE
+    } else if(strcmp(token, "gateway_start") == 0) {
+        gateway_start_cmd(str);
+
+    } else if(strcmp(token, "gateway_stop") == 0) {
+        gateway_stop();
+
+    } else if(strcmp(token, "gateway_stats") == 0) {
+        gateway_stats();
+#endif
+
     } else if(strcmp(token, "sensor_setup") == 0) {
         sensor_setup();
 
     } else if(strcmp(token, "sensor_send") == 0) {
         sensor_send();
 
+    } else if(strcmp(token, "sample_start") == 0) {
+        sample_start(strtoul(get_token(&str), NULL, 0));
+
+    } else if(strcmp(token, "sample_stop") == 0) {
+        sample_stop();
+
+    } else if(strcmp(token, "report_stats") == 0) {
+        report_stats();
+
+#ifdef SDLOG_AVAILABLE
+    } else if(strcmp(token, "sdlog_stats") == 0) {
+        sdlog_stats();
+
+    } else if(strcmp(token, "sdlog_sync") == 0) {
+        sdlog_sync();
+
+    } else if(strcmp(token, "sdlog_dump") == 0) {
+        sdlog_dump_cmd(str);
+
+#endif
+    } else if(strcmp(token, "cfg_show") == 0) {
+        cfg_show();
+
+    } else if(strcmp(token, "cfg_set") == 0) {
+        cfg_set(str);
+
+    } else if(strcmp(token, "cfg_save") == 0) {
+        cfg_save();
+
     } else {
         puts("Comando desconhecido. Digite 'help'.");
     }
 
+    TRACE_END(TRACE_EV_CONSOLE, tag);
+    log_flush(LOG_RING_SIZE);
     prompt();
 }
 
 // ======= main (estrutura preservada) =======
 int main(void)
 {
+    // Antes de tudo: as funções FASTTEXT só existem na SRAM depois da cópia.
+    fastmem_init();
+
 #ifdef CONFIG_CPU_HAS_INTERRUPT
     irq_setmask(0);
     irq_setie(1);
 #endif
     uart_init();
+    aht10_set_wait_hook(sensor_wait_hook);
 
     printf("Hellorld!\n");
+    LOG_INFO("main() %d ms apos o reset", (int)cycles_to_ms(cycles_now()));
+#ifdef SDLOG_AVAILABLE
+    sdlog_init();
+#endif
+    autostart();
     help();
     prompt();
 
-    while(1)
+    while(1) {
         console_service();
+        sampling_service();
+#ifdef SDLOG_AVAILABLE
+        sdlog_service();
+#endif
+        if (g_lora_ok) {
+            tdma_service();
+#ifdef GATEWAY_AVAILABLE
+            gateway_service();
+#endif
+            dispatch_service();
+            first_packet_check();
+        }
+        log_flush(4);
+    }
 
     return 0;
 }
@@ -0,0 +1,134 @@
+#
+# Acelerador AES-128 (somente cifragem) do SoC da Colorlight.
+#
+# Os modos usados pelo firmware só precisam da cifragem direta: CTR (fluxo de chave sobre o
+# contador) e CMAC (CBC-MAC). O core faz uma rodada por ciclo, com a expansão da chave na mesma
+# cadência: 1 ciclo de carga + 10 rodadas por bloco, 16 S-boxes para SubBytes e 4 para a chave.
+#
+# Interface (CSRs de 32 bits, palavras big-endian como no FIPS-197: o byte 0 do bloco fica nos
+# bits 31:24 de key0/din0/dout0):
+#   key0..3  chave; lida no 'start', pode ser trocada durante a cifragem seguinte;
+#   din0..3  bloco de entrada;
+#   control  start (pulso) e chain: com chain, a entrada é din ^ último resultado, o passo do
+#            CBC-MAC sem a CPU ler e reescrever o estado intermediário;
+#   status   busy;
+#   dout0..3 resultado (válido com busy em 0).
+#
+# Sem mestre Wishbone: os quadros do projeto têm 1 ou 2 blocos, e configurar um DMA (endereços,
+# tamanho, espera) custaria tanto quanto as 4 escritas de CSR por bloco.
+
+from migen import *
+
+from litex.gen import *
+
+from litex.soc.interconnect.csr import *
+
+SBOX = [
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16,
+]
+
+# Bytes de um bloco de 128 bits: o byte 0 (primeiro do FIPS-197) é o mais significativo.
+def _bytes(v):
+    return [v[8*(15 - i):8*(16 - i)] for i in range(16)]
+
+def _from_bytes(b):
+    return Cat(*reversed(b))
+
+# Multiplicação por x em GF(2^8).
+def _xtime(b):
+    return Cat(Constant(0, 1), b[:7]) ^ Mux(b[7], 0x1b, 0)
+
+# Core AES-128 -------------------------------------------------------------------------------------
+
+class AES128(LiteXModule):
+    def __init__(self):
+        for i in range(4):
+            setattr(self, f"_key{i}", CSRStorage(32, name=f"key{i}", description=f"Chave, palavra {i}."))
+        for i in range(4):
+            setattr(self, f"_din{i}", CSRStorage(32, name=f"din{i}", description=f"Bloco de entrada, palavra {i}."))
+        self._control = CSRStorage(fields=[
+            CSRField("start", size=1, offset=0, pulse=True, description="Cifra din com a chave atual."),
+            CSRField("chain", size=1, offset=1, pulse=True, description="Entrada = din ^ último resultado (CBC-MAC)."),
+        ])
+        self._status  = CSRStatus(fields=[
+            CSRField("busy",  size=1, offset=0, description="Cifragem em andamento."),
+        ])
+        for i in range(4):
+            setattr(self, f"_dout{i}", CSRStatus(32, name=f"dout{i}", description=f"Resultado, palavra {i}."))
+
+        # # #
+
+        key = Cat(*[getattr(self, f"_key{i}").storage for i in reversed(range(4))])
+        din = Cat(*[getattr(self, f"_din{i}").storage for i in reversed(range(4))])
+
+        state = Signal(128)     # Estado; com busy em 0, o último resultado.
+        rk    = Signal(128)     # Chave da rodada anterior.
+        rcon  = Signal(8)
+        rnd   = Signal(4)
+        busy  = Signal()
+
+        sbox = Array(Constant(v, 8) for v in SBOX)
+
+        # Rodada: SubBytes, ShiftRows, MixColumns (exceto na última) e AddRoundKey.
+        st = _bytes(state)
+        sb = [Signal(8) for _ in range(16)]
+        self.comb += [sb[i].eq(sbox[st[i]]) for i in range(16)]
+        # ShiftRows: a linha r (i % 4) gira r colunas para a esquerda.
+        sr = [sb[(i + 4*(i % 4)) % 16] for i in range(16)]
+        mc = []
+        for c in range(4):
+            a = sr[4*c:4*c + 4]
+            for r in range(4):
+                a0, a1, a2, a3 = a[r], a[(r + 1) % 4], a[(r + 2) % 4], a[(r + 3) % 4]
+                mc.append(_xtime(a0) ^ _xtime(a1) ^ a1 ^ a2 ^ a3)
+
+        # Próxima chave de rodada: SubWord(RotWord(w3)) ^ rcon e a cadeia de XORs.
+        kb = _bytes(rk)
+        ks = [Signal(8) for _ in range(4)]
+        self.comb += [ks[j].eq(sbox[kb[12 + (j + 1) % 4]]) for j in range(4)]
+        nk = []
+        for i in range(16):
+            prev = (ks[0] ^ rcon) if i == 0 else ks[i] if i < 4 else nk[i - 4]
+            nk.append(kb[i] ^ prev)
+
+        last = Signal()
+        nxt  = Signal(128)
+        self.comb += [
+            last.eq(rnd == 10),
+            nxt.eq(Mux(last, _from_bytes(sr), _from_bytes(mc)) ^ _from_bytes(nk)),
+        ]
+
+        self.sync += [
+            If(self._control.fields.start & ~busy,
+                state.eq(din ^ Mux(self._control.fields.chain, state, 0) ^ key),
+                rk.eq(key),
+                rcon.eq(0x01),
+                rnd.eq(1),
+                busy.eq(1)
+            ).Elif(busy,
+                state.eq(nxt),
+                rk.eq(_from_bytes(nk)),
+                rcon.eq(_xtime(rcon)),
+                rnd.eq(rnd + 1),
+                If(last, busy.eq(0))
+            )
+        ]
+
+        self.comb += self._status.fields.busy.eq(busy)
+        for i in range(4):
+            self.comb += getattr(self, f"_dout{i}").status.eq(state[32*(3 - i):32*(4 - i)])
@@ -0,0 +1,426 @@
+#
+# Amostrador autônomo do AHT10 para o SoC da Colorlight.
+#
+# Substitui o I2CMaster (bitbang) nos mesmos pinos e mantém os CSRs 'w'/'r'
+# compatíveis, então o driver bitbang do firmware continua funcionando quando
+# o amostrador está parado. Com o amostrador habilitado, um sequenciador em
+# hardware, a cada período programado:
+#   1. envia 0xAC 0x33 0x00 (dispara a conversão);
+#   2. espera a conversão e lê os 6 bytes, repetindo enquanto o bit "busy"
+#      estiver ativo;
+#   3. empilha umidade/temperatura brutas (20 bits) e o timestamp (us) do
+#      disparo em um FIFO lido por CSR, gerando uma interrupção.
+
+from migen import *
+from migen.genlib.cdc import MultiReg
+from migen.genlib.fifo import SyncFIFO
+
+from litex.gen import *
+
+from litex.soc.interconnect.csr import *
+from litex.soc.interconnect.csr_eventmanager import *
+
+AHT10_ADDR = 0x38
+
+# Comandos do motor de bytes I2C
+CMD_START = 0
+CMD_STOP  = 1
+CMD_WRITE = 2
+CMD_READ  = 3
+
+# Motor de bytes I2C -------------------------------------------------------------------------------
+
+class _I2CByteEngine(LiteXModule):
+    """Executa START, STOP, escrita ou leitura de um byte, em quartos de período de bit."""
+    def __init__(self, sys_clk_freq, i2c_freq=100e3):
+        self.cmd     = Signal(2)
+        self.go      = Signal()
+        self.tx_data = Signal(8)
+        self.tx_ack  = Signal()     # Leitura: 1 = mestre responde ACK.
+        self.done    = Signal()     # Pulso no fim do comando.
+        self.rx_data = Signal(8)
+        self.rx_ack  = Signal()     # Escrita: 1 = escravo respondeu ACK.
+
+        # Barramento (controlado pelo motor)
+        self.scl     = Signal(reset=1)
+        self.sda_low = Signal()     # Dreno aberto: 1 = força SDA em 0.
+        self.sda_in  = Signal()     # Nível de SDA (já sincronizado).
+
+        # # #
+
+        # Tick a cada 1/4 de bit.
+        div  = max(int(sys_clk_freq/(4*i2c_freq)) - 1, 1)
+        cnt  = Signal(max=div + 1)
+        tick = Signal()
+        self.sync += [
+            tick.eq(0),
+            If(cnt == 0,
+                cnt.eq(div),
+                tick.eq(1)
+            ).Else(
+                cnt.eq(cnt - 1)
+            )
+        ]
+
+        cmd     = Signal(2)
+        quarter = Signal(2)
+        bit     = Signal(4)         # 0..7 dados, 8 = bit de ACK.
+        shift   = Signal(8)
+        ack_out = Signal()
+        last    = Signal()
+
+        self.comb += [
+            self.rx_data.eq(shift),
+            If((cmd == CMD_START) | (cmd == CMD_STOP),
+                last.eq(quarter == 3)
+            ).Else(
+                last.eq((quarter == 3) & (bit == 8))
+            )
+        ]
+
+        self.fsm = fsm = FSM(reset_state="IDLE")
+        fsm.act("IDLE",
+            If(self.go,
+                NextValue(cmd,     self.cmd),
+                NextValue(shift,   self.tx_data),
+                NextValue(ack_out, self.tx_ack),
+                NextValue(quarter, 0),
+                NextValue(bit,     0),
+                NextState("RUN")
+            )
+        )
+        # A cada tick aplica o nível de SCL/SDA do quarto atual e avança.
+        fsm.act("RUN",
+            If(tick,
+                NextValue(quarter, quarter + 1),
+                Case(cmd, {
+                    CMD_START: Case(quarter, {
+                        0: [NextValue(self.scl, 0), NextValue(self.sda_low, 0)],
+                        1: [NextValue(self.scl, 1)],
+                        2: [NextValue(self.sda_low, 1)],        # SDA cai com SCL alto.
+                        3: [NextValue(self.scl, 0)],
+                    }),
+                    CMD_STOP: Case(quarter, {
+                        0: [NextValue(self.scl, 0), NextValue(self.sda_low, 1)],
+                        1: [NextValue(self.scl, 1)],
+                        2: [NextValue(self.sda_low, 0)],        # SDA sobe com SCL alto.
+                        3: [],
+                    }),
+                    CMD_WRITE: Case(quarter, {
+                        0: [NextValue(self.scl, 0),
+                            If(bit == 8,
+                                NextValue(self.sda_low, 0)      # Libera SDA para o ACK.
+                            ).Else(
+                                NextValue(self.sda_low, ~shift[7])
+                            )],
+                        1: [NextValue(self.scl, 1)],
+                        2: [If(bit == 8, NextValue(self.rx_ack, ~self.sda_in))],
+                        3: [NextValue(self.scl, 0),
+                            NextValue(shift, Cat(0, shift[:7])),
+                            NextValue(bit, bit + 1)],
+                    }),
+                    CMD_READ: Case(quarter, {
+                        0: [NextValue(self.scl, 0),
+                            If(bit == 8,
+                                NextValue(self.sda_low, ack_out)
+                            ).Else(
+                                NextValue(self.sda_low, 0)
+                            )],
+                        1: [NextValue(self.scl, 1)],
+                        2: [If(bit != 8, NextValue(shift, Cat(self.sda_in, shift[:7])))],
+                        3: [NextValue(self.scl, 0),
+                            NextValue(bit, bit + 1)],
+                    }),
+                }),
+                If(last, NextState("DONE"))
+            )
+        )
+        fsm.act("DONE",
+            self.done.eq(1),
+            NextState("IDLE")
+        )
+
+# Amostrador AHT10 ---------------------------------------------------------------------------------
+
+class AHT10Sampler(LiteXModule):
+    def __init__(self, pads, sys_clk_freq, fifo_depth=16, i2c_freq=100e3,
+        conv_wait_ms = 80,
+        poll_ms      = 10,
+        max_polls    = 8):
+        # CSRs compatíveis com o I2CMaster (bitbang) ----------------------------------------------
+        self._w = CSRStorage(fields=[
+            CSRField("scl", size=1, offset=0, reset=1),
+            CSRField("oe",  size=1, offset=1),
+            CSRField("sda", size=1, offset=2),
+        ], name="w")
+        self._r = CSRStatus(fields=[
+            CSRField("sda", size=1, offset=0),
+        ], name="r")
+
+        # CSRs do amostrador -----------------------------------------------------------------------
+        self._sampler_control = CSRStorage(fields=[
+            CSRField("enable",  size=1, offset=0, description="Amostragem periódica."),
+            CSRField("trigger", size=1, offset=1, pulse=True, description="Dispara uma amostra agora."),
+            CSRField("init",    size=1, offset=2, pulse=True, description="Envia a calibração (0xE1 0x08 0x00)."),
+            CSRField("clear",   size=1, offset=3, pulse=True, description="Limpa os flags de erro."),
+        ])
+        self._sampler_period = CSRStorage(32, reset=10000, description="Período entre amostras (ms).")
+        self._sampler_status = CSRStatus(fields=[
+            CSRField("level",    size=8, offset=0,  description="Amostras no FIFO."),
+            CSRField("busy",     size=1, offset=8,  description="Sequência I2C em andamento."),
+            CSRField("overflow", size=1, offset=9,  description="Amostra perdida com o FIFO cheio."),
+            CSRField("nack",     size=1, offset=10, description="Sensor não respondeu."),
+            CSRField("timeout",  size=1, offset=11, description="Sensor continuou ocupado."),
+        ])
+        self._sampler_hum  = CSRStatus(20, description="Umidade bruta (20 bits) da amostra na frente do FIFO.")
+        self._sampler_temp = CSRStatus(20, description="Temperatura bruta (20 bits) da amostra na frente do FIFO.")
+        self._sampler_ts   = CSRStatus(32, description="Timestamp (us) do disparo da amostra na frente do FIFO.")
+        self._sampler_pop  = CSR()
+
+        self.ev = EventManager()
+        self.ev.sample = EventSourceLevel(description="Há amostras no FIFO.")
+        self.ev.finalize()
+
+        # # #
+
+        self.engine = engine = _I2CByteEngine(sys_clk_freq, i2c_freq)
+
+        # Pinos: o sequenciador controla o barramento enquanto ativo; senão, o bitbang.
+        active = Signal()
+        scl    = Signal()
+        sda_oe = Signal()
+        sda_o  = Signal()
+        sda_i  = Signal()
+        self.comb += [
+            If(active,
+                scl.eq(engine.scl),
+                sda_oe.eq(engine.sda_low),
+                sda_o.eq(0)
+            ).Else(
+                scl.eq(self._w.fields.scl),
+                sda_oe.eq(self._w.fields.oe),
+                sda_o.eq(self._w.fields.sda)
+            ),
+            pads.scl.eq(scl),
+            self._r.fields.sda.eq(engine.sda_in),
+        ]
+        self.specials += Tristate(pads.sda, sda_o, sda_oe, sda_i)
+        self.specials += MultiReg(sda_i, engine.sda_in)
+
+        # Sinais observáveis (captura de timestamps).
+        self.scl = scl
+        self.sda = engine.sda_in
+
+        # Base de tempo: us e ms ------------------------------------------------------------------
+        us_div   = max(int(sys_clk_freq/1e6) - 1, 1)
+        us_cnt   = Signal(max=us_div + 1)
+        us_tick  = Signal()
+        ms_cnt   = Signal(max=1000)
+        ms_tick  = Signal()
+        self.timestamp = timestamp = Signal(32)
+        self.sync += [
+            us_tick.eq(0),
+            ms_tick.eq(0),
+            If(us_cnt == 0,
+                us_cnt.eq(us_div),
+                us_tick.eq(1),
+                timestamp.eq(timestamp + 1),
+                If(ms_cnt == 999,
+                    ms_cnt.eq(0),
+                    ms_tick.eq(1)
+                ).Else(
+                    ms_cnt.eq(ms_cnt + 1)
+                )
+            ).Else(
+                us_cnt.eq(us_cnt - 1)
+            )
+        ]
+
+        # Período de amostragem -------------------------------------------------------------------
+        control     = self._sampler_control.fields
+        period_cnt  = Signal(32)
+        sample_req  = Signal()
+        init_req    = Signal()
+        start       = Signal()
+        start_init  = Signal()
+        self.sync += [
+            If(~control.enable,
+                period_cnt.eq(0)
+            ).Elif(ms_tick,
+                If(period_cnt == 0,
+                    period_cnt.eq(self._sampler_period.storage - 1),
+                    sample_req.eq(1)
+                ).Else(
+                    period_cnt.eq(period_cnt - 1)
+                )
+            ),
+            If(control.trigger, sample_req.eq(1)),
+            If(control.init,    init_req.eq(1)),
+            If(start,           sample_req.eq(0)),
+            If(start_init,      init_req.eq(0)),
+        ]
+
+        # FIFO de amostras ------------------------------------------------------------------------
+        self.fifo = fifo = SyncFIFO(20 + 20 + 32, fifo_depth)
+        self.comb += [
+            self._sampler_temp.status.eq(fifo.dout[0:20]),
+            self._sampler_hum.status.eq(fifo.dout[20:40]),
+            self._sampler_ts.status.eq(fifo.dout[40:72]),
+            fifo.re.eq(self._sampler_pop.re),
+            self.ev.sample.trigger.eq(fifo.readable),
+            self._sampler_status.fields.level.eq(fifo.level),
+        ]
+
+        # Sequenciador ----------------------------------------------------------------------------
+        is_init   = Signal()
+        idx       = Signal(3)
+        issued    = Signal()
+        raw       = Signal(48)        # 6 bytes lidos, o primeiro nos bits mais altos.
+        ts        = Signal(32)
+        wait_cnt  = Signal(16)
+        polls     = Signal(max=max_polls + 1)
+        overflow  = Signal()
+        nack      = Signal()
+        timeout   = Signal()
+
+        trig_bytes = Array([AHT10_ADDR << 1, 0xAC, 0x33, 0x00])
+        init_bytes = Array([AHT10_ADDR << 1, 0xE1, 0x08, 0x00])
+
+        self.comb += [
+            self._sampler_status.fields.busy.eq(active),
+            self._sampler_status.fields.overflow.eq(overflow),
+            self._sampler_status.fields.nack.eq(nack),
+            self._sampler_status.fields.timeout.eq(timeout),
+        ]
+        self.sync += If(control.clear,
+            overflow.eq(0),
+            nack.eq(0),
+            timeout.eq(0)
+        )
+
+        # Emite um comando ao motor e espera o fim; 'then' roda no ciclo do 'done'.
+        def issue(cmd, tx_data=0, tx_ack=0, then=[]):
+            return [
+                engine.cmd.eq(cmd),
+                engine.tx_data.eq(tx_data),
+                engine.tx_ack.eq(tx_ack),
+                engine.go.eq(~issued),
+                NextValue(issued, 1),
+                If(engine.done,
+                    NextValue(issued, 0),
+                    *then
+                )
+            ]
+
+        self.seq = seq = FSM(reset_state="IDLE")
+        seq.act("IDLE",
+            If(init_req,
+                start_init.eq(1),
+                NextValue(is_init, 1),
+                NextState("W-START")
+            ).Elif(sample_req,
+                start.eq(1),
+                NextValue(is_init, 0),
+                NextValue(ts, timestamp),
+                NextValue(polls, max_polls),
+                NextState("W-START")
+            )
+        )
+        seq.act("W-START",
+            active.eq(1),
+            issue(CMD_START, then=[NextValue(idx, 0), NextState("W-BYTE")])
+        )
+        seq.act("W-BYTE",
+            active.eq(1),
+            issue(CMD_WRITE,
+                tx_data = Mux(is_init, init_bytes[idx], trig_bytes[idx]),
+                then    = [
+                    If(~engine.rx_ack,
+                        NextValue(nack, 1),
+                        NextState("ABORT")
+                    ).Elif(idx == 3,
+                        NextState("W-STOP")
+                    ).Else(
+                        NextValue(idx, idx + 1)
+                    )
+                ])
+        )
+        seq.act("W-STOP",
+            active.eq(1),
+            issue(CMD_STOP, then=[
+                If(is_init,
+                    NextState("IDLE")
+                ).Else(
+                    NextValue(wait_cnt, conv_wait_ms),
+                    NextState("WAIT")
+                )
+            ])
+        )
+        # Barramento livre durante a conversão: SCL/SDA em repouso.
+        seq.act("WAIT",
+            active.eq(1),
+            If(ms_tick,
+                If(wait_cnt == 0,
+                    NextState("R-START")
+                ).Else(
+                    NextValue(wait_cnt, wait_cnt - 1)
+                )
+            )
+        )
+        seq.act("R-START",
+            active.eq(1),
+            issue(CMD_START, then=[NextState("R-ADDR")])
+        )
+        seq.act("R-ADDR",
+            active.eq(1),
+            issue(CMD_WRITE, tx_data=(AHT10_ADDR << 1) | 1, then=[
+                If(~engine.rx_ack,
+                    NextValue(nack, 1),
+                    NextState("ABORT")
+                ).Else(
+                    NextValue(idx, 0),
+                    NextState("R-BYTE")
+                )
+            ])
+        )
+        seq.act("R-BYTE",
+            active.eq(1),
+            issue(CMD_READ, tx_ack=(idx != 5), then=[
+                NextValue(raw, Cat(engine.rx_data, raw[:40])),
+                If(idx == 5,
+                    NextState("R-STOP")
+                ).Else(
+                    NextValue(idx, idx + 1)
+                )
+            ])
+        )
+        seq.act("R-STOP",
+            active.eq(1),
+            issue(CMD_STOP, then=[NextState("CHECK")])
+        )
+        seq.act("CHECK",
+            active.eq(1),
+            If(raw[47],                 # Bit "busy" do byte de status.
+                If(polls == 0,
+                    NextValue(timeout, 1),
+                    NextState("IDLE")
+                ).Else(
+                    NextValue(polls, polls - 1),
+                    NextValue(wait_cnt, poll_ms),
+                    NextState("WAIT")
+                )
+            ).Else(
+                NextState("PUSH")
+            )
+        )
+        seq.act("PUSH",
+            active.eq(1),
+            fifo.we.eq(1),
+            fifo.din.eq(Cat(raw[0:20], raw[20:40], ts)),
+            If(~fifo.writable, NextValue(overflow, 1)),
+            NextState("IDLE")
+        )
+        seq.act("ABORT",
+            active.eq(1),
+            issue(CMD_STOP, then=[NextState("IDLE")])
+        )
@@ -16,6 +16,7 @@ from litex_boards.platforms import colorlight_i5
 
 from litex.soc.cores.clock import *
 from litex.soc.integration.soc_core import *
+from litex.soc.integration.soc import SoCRegion
 from litex.soc.integration.builder import *
 from litex.soc.cores.video import VideoHDMIPHY
 from litex.soc.cores.led import LedChaser
@@ -31,6 +32,11 @@ from litedram.phy import GENSDRPHY, HalfRateGENSDRPHY
 
 from liteeth.phy.ecp5rgmii import LiteEthPHYRGMII
 
+from aht10_sampler import AHT10Sampler
+from rfm95_cores import RFM95DMA, RFM95RegWindow
+from aes_core import AES128
+from tscap_core import TimestampCapture
+
 # CRG ----------------------------------------------------------------------------------------------
 
 class _CRG(LiteXModule):
@@ -95,11 +101,88 @@ class _CRG(LiteXModule):
         sdram_clk = ClockSignal("sys2x_ps" if sdram_rate == "1:2" else "sys_ps")
         self.specials += DDROutput(1, 0, platform.request("sdram_clock"), sdram_clk)
 
+# Rádios LoRa --------------------------------------------------------------------------------------
+
+# Pinos de cada RFM95 (SPI, RESET e DIO0), na ordem dos rádios. O rádio 0 mantém os pinos e os nomes
+# de CSR originais (spi, lora_reset); os demais usam loraN_spi e loraN_reset. O DIO0 só entra com
+# --with-lora-dio0 (lora_dio0 / loraN_dio0): as placas existentes não ligam o DIO0, e sem ele o
+# firmware lê o TxDone/RxDone em REG_IRQ_FLAGS. Os pinos de DIO0 e dos rádios extras são sugestões
+# no conector de expansão: confira com a fiação da placa antes de gerar o bitstream.
+LORA_RADIO_PINS = [
+    dict(clk="G20", mosi="L18", miso="M18", cs_n="N17", reset="L20", dio0="P17"),
+    dict(clk="B19", mosi="A19", miso="B20", cs_n="A18", reset="B18", dio0="C17"),
+    dict(clk="D20", mosi="E19", miso="D19", cs_n="C20", reset="E20", dio0="F19"),
+    dict(clk="D1",  mosi="C1",  miso="C2",  cs_n="E3",  reset="E2",  dio0="D2"),
+]
+
+def assert_pins_free(platform, pins, who):
+    """Falha se algum pino já pertence a um recurso requisitado da plataforma (serial, cpu_reset_n,
+    SDRAM, flash, rádios/barramentos anteriores...)."""
+    claimed = {}
+    for resource, _ in platform.constraint_manager.matched:
+        for item in resource[2:]:
+            for c in (item.constraints if isinstance(item, Subsignal) else [item]):
+                if isinstance(c, Pins):
+                    for pin in c.identifiers:
+                        claimed[pin] = f"{resource[0]}:{resource[1]}"
+    for pin in pins:
+        assert pin not in claimed, f"{who}: pino {pin} já usado por {claimed[pin]}"
+
+# Barramentos I2C (AHT10) --------------------------------------------------------------------------
+
+# Pinos (SCL, SDA) de cada barramento; o 0 é o original. Os demais são sugestões no conector de
+# expansão: confira com a fiação da placa.
+AHT10_BUS_PINS = [
+    ("U17", "U18"),
+    ("P18", "N18"),
+    ("T17", "R18"),
+    ("P20", "N20"),
+    ("M17", "M19"),
+    ("L16", "J16"),
+    ("K16", "H16"),
+    ("E17", "F18"),
+]
+
+# Perfis de CPU ----------------------------------------------------------------------------------
+
+# Selecionados com --profile; cada valor vira o padrão do argumento de mesmo nome, então
+# --cpu-type/--cpu-variant/--l2-size/--sys-clk-freq explícitos continuam valendo. Os perfis só
+# trocam a CPU: L2 (8 KiB) e clock (60 MHz) ficam iguais de propósito, para que a matriz do 'bench'
+# compare as CPUs isoladamente. Cache e clock são variados com --l2-size e --sys-clk-freq.
+SOC_PROFILES = {
+    # RV32I sem MUL/DIV e sem caches: menor área.
+    "picorv32-min"  : dict(cpu_type="picorv32", cpu_variant="minimal", l2_size=8192, sys_clk_freq=60e6),
+    # VexRiscv sem MUL/DIV, caches pequenas.
+    "vexriscv-lite" : dict(cpu_type="vexriscv", cpu_variant="lite",    l2_size=8192, sys_clk_freq=60e6),
+    # VexRiscv com MUL/DIV e I$/D$.
+    "vexriscv-full" : dict(cpu_type="vexriscv", cpu_variant="full",    l2_size=8192, sys_clk_freq=60e6),
+}
+
 # BaseSoC ------------------------------------------------------------------------------------------
 
 class BaseSoC(SoCCore):
+    mem_map = {**SoCCore.mem_map, **{
+        "fast_sram": 0x30000000,
+        "rfm":       0x90000000,
+    }}
+
     def __init__(self, board="i5", revision="7.0", toolchain="trellis", sys_clk_freq=60e6,
         with_led_chaser        = True,
+        profile                = None,
+        fast_sram_size         = 0x2000,
+        with_aht10_sampler     = False,
+        with_lora_dma          = False,
+        with_lora_regs         = False,
+        with_aes               = False,
+        with_tscap             = False,
+        with_lora_dio0         = False,
+        lora_radios            = 1,
+        aht10_buses            = 1,
+        with_ethernet          = False,
+        with_etherbone         = False,
+        local_ip               = "",
+        remote_ip              = "",
+        eth_phy                = 0,
         use_internal_osc       = False,
         sdram_rate             = "1:1",
         with_video_terminal    = False,
@@ -120,8 +203,13 @@ class BaseSoC(SoCCore):
         )
 
         # SoCCore ----------------------------------------------------------------------------------
+        # Contador "uptime" do timer0: base de tempo (em ciclos) dos logs do firmware.
+        kwargs["timer_uptime"] = True
         SoCCore.__init__(self, platform, int(sys_clk_freq), ident = "LiteX SoC on Colorlight " + board.upper(), **kwargs)
 
+        # Perfil usado no build: o firmware o imprime no cabeçalho do 'bench'.
+        self.add_constant("SOC_PROFILE", profile or "custom")
+
         # Leds -------------------------------------------------------------------------------------
         if with_led_chaser:
             ledn = platform.request_all("user_led_n")
@@ -136,6 +224,20 @@ class BaseSoC(SoCCore):
         from litespi.opcodes import SpiNorFlashOpCodes as Codes
         self.add_spi_flash(mode="1x", module=SpiFlashModule(Codes.READ_1_1_1))
 
+        # Boot pela flash: a BIOS procura a imagem .fbi (tamanho + CRC32) em FLASH_BOOT_ADDRESS,
+        # depois do bitstream, e o firmware guarda a configuração no setor de 4 KB anterior.
+        flash_boot_offset = {"i5": 0x100000, "i9": 0x200000}[board]
+        spiflash_origin   = self.bus.regions["spiflash"].origin
+        self.add_constant("FLASH_BOOT_ADDRESS",   spiflash_origin + flash_boot_offset)
+        self.add_constant("FLASH_CONFIG_ADDRESS", spiflash_origin + flash_boot_offset - 0x1000)
+
+        # SRAM rápida ------------------------------------------------------------------------------
+        # Região integrada (block RAM, sem passar pela L2/SDRAM) para as seções .fasttext/.fastdata
+        # do firmware: acesso a registradores/FIFO do RFM95, bitbang I2C (exceto i2c_delay, que só
+        # espera), log_write e o AES em software. Nenhuma ISR e nem o busy_wait_us da BIOS ficam aqui.
+        if fast_sram_size:
+            self.add_ram("fast_sram", origin=self.mem_map["fast_sram"], size=fast_sram_size)
+
         # SDR SDRAM --------------------------------------------------------------------------------
         if not self.integrated_main_ram_size:
             sdrphy_cls = HalfRateGENSDRPHY if sdram_rate == "1:2" else GENSDRPHY
@@ -146,50 +248,154 @@ class BaseSoC(SoCCore):
                 l2_cache_size = kwargs.get("l2_size", 8192)
             )
 
+        # Ethernet / Etherbone ---------------------------------------------------------------------
+        # Com --with-ethernet o firmware pode operar como gateway: encaminha os quadros recebidos pelos
+        # rádios em datagramas UDP (libliteeth) para o host em REMOTEIP, a partir de LOCALIP.
+        if with_ethernet or with_etherbone:
+            self.ethphy = LiteEthPHYRGMII(
+                clock_pads = self.platform.request("eth_clocks", eth_phy),
+                pads       = self.platform.request("eth", eth_phy),
+                tx_delay   = 0e-9)
+            if with_ethernet:
+                self.add_ethernet(phy=self.ethphy, local_ip=local_ip, remote_ip=remote_ip)
+            if with_etherbone:
+                self.add_etherbone(phy=self.ethphy, ip_address=local_ip)
+
         # Configuração dos pinos SPI (para LoRa RFM95) -----------------------------------------------
-        spi_pads = [
-            ("spi", 0,
-                Subsignal("clk",  Pins("G20")),
-                Subsignal("mosi", Pins("L18")),
-                Subsignal("miso", Pins("M18")),
-                Subsignal("cs_n", Pins("N17")),
-                IOStandard("LVCMOS33")
-            ),
-            # RESET separado como GPIO
-            ("lora_reset", 0, Pins("L20"), IOStandard("LVCMOS33"))
-        ]
-
-        platform.add_extension(spi_pads)
-
-        # Adiciona o Core SPI Master e o CSR 'spi'
-        self.spi = SPIMaster(pads=platform.request("spi"), data_width=8, sys_clk_freq=sys_clk_freq, spi_clk_freq=1e6)
-        self.add_csr("spi")
-
-        # Adiciona o Core GPIOOut e o CSR 'lora_reset'
-        self.submodules.lora_reset = GPIOOut(platform.request("lora_reset"))
-        self.add_csr("lora_reset")
+        # Um SPIMaster, um GPIOOut (RESET) e, com with_lora_dio0, um GPIOIn (DIO0) por rádio; o firmware
+        # recebe o total em LORA_RADIOS e monta a tabela de instâncias pelos nomes dos CSRs.
+        assert 1 <= lora_radios <= len(LORA_RADIO_PINS)
+        tscap_radios = []
+        for n in range(lora_radios):
+            pins       = LORA_RADIO_PINS[n]
+            spi_name   = "spi"        if n == 0 else f"lora{n}_spi"
+            reset_name = "lora_reset" if n == 0 else f"lora{n}_reset"
+            dio0_name  = "lora_dio0"  if n == 0 else f"lora{n}_dio0"
+            assert_pins_free(platform, [pins[k] for k in ("clk", "mosi", "miso", "cs_n", "reset")] +
+                ([pins["dio0"]] if with_lora_dio0 else []), spi_name)
+            platform.add_extension([
+                (spi_name, 0,
+                    Subsignal("clk",  Pins(pins["clk"])),
+                    Subsignal("mosi", Pins(pins["mosi"])),
+                    Subsignal("miso", Pins(pins["miso"])),
+                    Subsignal("cs_n", Pins(pins["cs_n"])),
+                    IOStandard("LVCMOS33")
+                ),
+                # RESET separado como GPIO
+                (reset_name, 0, Pins(pins["reset"]), IOStandard("LVCMOS33")),
+            ])
+            spi_pads  = platform.request(spi_name)
+            dio0_pads = None
+            if with_lora_dio0:
+                platform.add_extension([(dio0_name, 0, Pins(pins["dio0"]), IOStandard("LVCMOS33"))])
+                dio0_pads = platform.request(dio0_name)
+            # Pinos reais (depois dos muxes da janela/DMA) para a captura de timestamps.
+            tscap_radios.append((spi_pads.cs_n, dio0_pads))
+
+            # Só o rádio 0 tem janela de registradores e DMA.
+            if n == 0:
+                # Com a janela, os registradores do rádio ficam na região 'rfm' (fora da cache): um
+                # load/store em RFM_BASE + 4*reg vira a transação SPI, com escritas postadas e prefetch.
+                if with_lora_regs:
+                    self.rfm95_regs = RFM95RegWindow(spi_pads, sys_clk_freq)
+                    self.bus.add_slave("rfm", self.rfm95_regs.bus,
+                        SoCRegion(origin=self.mem_map["rfm"], size=0x1000, cached=False))
+                    spi_pads = self.rfm95_regs.down_pads
+                # Com o DMA, o SPIMaster passa pelo mux do 'rfm95_dma', que carrega o FIFO do rádio
+                # direto da memória (mestre Wishbone) e sinaliza o fim por interrupção.
+                if with_lora_dma:
+                    self.rfm95_dma = RFM95DMA(spi_pads, sys_clk_freq)
+                    self.bus.add_master(name="rfm95_dma", master=self.rfm95_dma.bus)
+                    self.irq.add("rfm95_dma", use_loc_if_exists=True)
+                    spi_pads = self.rfm95_dma.cpu_pads
+                    if with_lora_regs:
+                        self.comb += [
+                            self.rfm95_dma.hold.eq(~self.rfm95_regs.idle),
+                            self.rfm95_regs.hold.eq(self.rfm95_dma.active),
+                            self.rfm95_regs.defer.eq(self.rfm95_dma.request),
+                        ]
+
+            # Adiciona o Core SPI Master, o GPIOOut do RESET e o GPIOIn do DIO0
+            self.add_module(name=spi_name, module=SPIMaster(pads=spi_pads, data_width=8,
+                sys_clk_freq=sys_clk_freq, spi_clk_freq=1e6))
+            self.add_module(name=reset_name, module=GPIOOut(platform.request(reset_name)))
+            self.add_csr(spi_name)
+            self.add_csr(reset_name)
+            if dio0_pads is not None:
+                self.add_module(name=dio0_name, module=GPIOIn(dio0_pads))
+                self.add_csr(dio0_name)
+        self.add_constant("LORA_RADIOS", lora_radios)
 
         # Configuração dos pinos I2C (para AHT10) ---------------------------------------------------
-        i2c_pads = [
-            ("i2c", 0,
-                Subsignal("scl", Pins("U17")),
-                Subsignal("sda", Pins("U18")),
-                IOStandard("LVCMOS33")
-            )
-        ]
-
-        platform.add_extension(i2c_pads)
-        
-        # Adiciona o Core I2CMaster (Bitbang) e o CSR 'i2c'
-        self.submodules.i2c = I2CMaster(pads=platform.request("i2c"))
-        self.add_csr("i2c")
-   
+        # O AHT10 tem endereço fixo (0x38): um barramento por sensor. O barramento 0 é o CSR 'i2c'
+        # original; os demais são 'i2cN'. O firmware recebe o total em AHT10_BUSES.
+        assert 1 <= aht10_buses <= len(AHT10_BUS_PINS)
+        # O amostrador só existe no barramento 0, e com ele ligado o firmware não lê os outros.
+        assert not (with_aht10_sampler and aht10_buses > 1), \
+            "--with-aht10-sampler amostra só o barramento 0: use --aht10-buses 1"
+        tscap_buses = []
+        for n in range(aht10_buses):
+            scl, sda = AHT10_BUS_PINS[n]
+            i2c_name = "i2c" if n == 0 else f"i2c{n}"
+            assert_pins_free(platform, [scl, sda], i2c_name)
+            platform.add_extension([
+                (i2c_name, 0,
+                    Subsignal("scl", Pins(scl)),
+                    Subsignal("sda", Pins(sda)),
+                    IOStandard("LVCMOS33")
+                )
+            ])
+
+            # Adiciona o Core I2CMaster (Bitbang) e o CSR 'i2c'
+            # Com o amostrador, o mesmo CSR 'i2c' mantém o bitbang e ganha o sequenciador do AHT10,
+            # o FIFO de amostras (i2c_sampler_*) e a interrupção.
+            if n == 0 and with_aht10_sampler:
+                self.submodules.i2c = AHT10Sampler(pads=platform.request("i2c"), sys_clk_freq=sys_clk_freq)
+                self.add_csr("i2c")
+                self.irq.add("i2c", use_loc_if_exists=True)
+                tscap_buses.append((self.i2c.scl, self.i2c.sda))
+            else:
+                i2c = I2CMaster(pads=platform.request(i2c_name))
+                self.add_module(name=i2c_name, module=i2c)
+                self.add_csr(i2c_name)
+                # Nível que o mestre impõe ao barramento (dreno aberto no SDA): basta para START/STOP.
+                w = i2c._w.fields
+                tscap_buses.append((w.scl, ~w.oe | w.sda))
+        self.add_constant("AHT10_BUSES", aht10_buses)
+
+        # Acelerador AES-128 -----------------------------------------------------------------------
+        # Cifra (CTR) e autenticação (CMAC) dos quadros LoRa pelo firmware (lib/aes.c); sem o core,
+        # o firmware usa a implementação em software.
+        if with_aes:
+            self.add_module(name="aes", module=AES128())
+            self.add_csr("aes")
+
+        # Captura de timestamps --------------------------------------------------------------------
+        # Trava o contador de ciclos nas bordas do DIO0, no CS de cada rádio e no START/STOP de cada
+        # barramento I2C (tempo no ar, custo do SPI e conversão do AHT10; lib/tscap.c). Bits dos
+        # eventos: 3 por rádio (DIO0, CS, fim do CS) e depois 2 por barramento (START, STOP).
+        if with_tscap:
+            self.tscap = TimestampCapture()
+            for n, (cs_n, dio0) in enumerate(tscap_radios):
+                # Sem o pino, o bit do DIO0 fica reservado (nunca dispara) e a numeração não muda.
+                if dio0 is None:
+                    self.tscap.add_rising(f"lora{n}_dio0", Constant(0, 1))
+                else:
+                    self.tscap.add_rising(f"lora{n}_dio0", dio0, async_input=True)
+                self.tscap.add_spi_cs(f"lora{n}_cs", cs_n)
+            for n, (scl, sda) in enumerate(tscap_buses):
+                self.tscap.add_i2c(f"i2c{n}", scl, sda)
+            self.add_csr("tscap")
+            for bit, name in enumerate(self.tscap.names):
+                self.add_constant(f"TSCAP_{name.upper()}", bit)
 
 # Build --------------------------------------------------------------------------------------------
 
 def main():
+    import argparse
     from litex.build.parser import LiteXArgumentParser
     parser = LiteXArgumentParser(platform=colorlight_i5.Platform, description="LiteX SoC on Colorlight I5.")
+    parser.add_target_argument("--profile",          default=None, choices=sorted(SOC_PROFILES), help="Perfil de CPU (veja SOC_PROFILES); L2 e clock ficam em 8 KiB/60 MHz, use --l2-size/--sys-clk-freq para variá-los.")
     parser.add_target_argument("--board",            default="i5",             help="Board type (i5).")
     parser.add_target_argument("--revision",         default="7.0",            help="Board revision (7.0).")
     parser.add_target_argument("--sys-clk-freq",     default=60e6, type=float, help="System clock frequency.")
@@ -210,8 +416,24 @@ def main():
     # Recursos do projeto LoRa/AHT10
     parser.add_target_argument("--with-lora",     action="store_true", help="Habilita SPI para módulo LoRa (RFM96).")
     parser.add_target_argument("--with-aht10",    action="store_true", help="Habilita I2C para sensor AHT10.")
+    parser.add_target_argument("--aht10-buses", default=1, type=int, help="Número de barramentos I2C para AHT10 (1 a 8), um sensor por barramento.")
+    parser.add_target_argument("--with-aht10-sampler", action="store_true", help="Amostragem do AHT10 em hardware (período, FIFO e IRQ).")
+    parser.add_target_argument("--with-lora-dma", action="store_true", help="DMA da memória para o FIFO do RFM95 (mestre Wishbone e IRQ).")
+    parser.add_target_argument("--lora-radios", default=1, type=int, help="Número de rádios RFM95 (1 a 4), cada um com SPI/RESET.")
+    parser.add_target_argument("--with-lora-dio0", action="store_true", help="GPIO do DIO0 de cada rádio (TxDone/RxDone sem polling SPI); só se o pino estiver ligado.")
+    parser.add_target_argument("--with-lora-regs", action="store_true", help="Registradores do RFM95 mapeados em memória (região 'rfm').")
+    parser.add_target_argument("--with-aes", action="store_true", help="Acelerador AES-128 (CTR/CMAC dos quadros cifrados) nos CSRs.")
+    parser.add_target_argument("--with-tscap", action="store_true", help="Captura de timestamps (DIO0, CS do SPI, START/STOP do I2C) em FIFO.")
     parser.add_target_argument("--use-example-pins", action="store_true", help="Carrega arquivo de pinos de exemplo (edite pins_colorlight_i9_ext.py).")
+    parser.add_target_argument("--fast-sram-size", default=0x2000, type=lambda x: int(x, 0), help="Tamanho da SRAM rápida para código/dados críticos do firmware.")
     
+    # O perfil só ajusta os padrões; por isso é lido antes do parse completo.
+    pre = argparse.ArgumentParser(add_help=False)
+    pre.add_argument("--profile", default=None, choices=sorted(SOC_PROFILES))
+    profile = pre.parse_known_args()[0].profile
+    if profile is not None:
+        parser.set_defaults(**SOC_PROFILES[profile])
+
     args = parser.parse_args()
 
     soc = BaseSoC(board=args.board, revision=args.revision,
@@ -228,7 +450,17 @@ def main():
         with_video_framebuffer = args.with_video_framebuffer,
         with_lora_spi          = args.with_lora,
         with_i2c_aht10         = args.with_aht10,
+        with_aht10_sampler     = args.with_aht10_sampler,
+        with_lora_dma          = args.with_lora_dma,
+        with_lora_regs         = args.with_lora_regs,
+        with_aes               = args.with_aes,
+        with_tscap             = args.with_tscap,
+        with_lora_dio0         = args.with_lora_dio0,
+        lora_radios            = args.lora_radios,
+        aht10_buses            = args.aht10_buses,
         use_example_pins       = args.use_example_pins,
+        fast_sram_size         = args.fast_sram_size,
+        profile                = args.profile,
         **parser.soc_argdict
     )
     soc.platform.add_extension(colorlight_i5._sdcard_pmod_io)
@@ -0,0 +1,447 @@
+#
+# Cores de apoio ao rádio RFM95 (LoRa) do SoC da Colorlight.
+#
+# RFM95DMA: motor de pacotes com mestre Wishbone. Dado o endereço e o tamanho de um quadro na
+# memória (SDRAM ou SRAM), ele copia o quadro para um buffer interno e então faz, pelo SPI do
+# rádio:
+#   1. REG_FIFO_ADDR_PTR <- 0x00;
+#   2. carga em rajada do FIFO (REG_FIFO, um único CS);
+#   3. REG_PAYLOAD_LENGTH <- tamanho;
+# e gera uma interrupção no fim. O SPIMaster da CPU continua ligado aos mesmos pinos através de
+# um mux: enquanto o DMA está parado, os pinos seguem o SPIMaster.
+#
+# RFM95RegWindow: escravo Wishbone que expõe os 128 registradores do rádio como uma janela de
+# memória (uma palavra de 32 bits por registrador). Escritas são postadas em um FIFO; leituras
+# esperam o FIFO esvaziar e fazem a transação SPI. Um registrador pode ser pré-lido
+# continuamente (prefetch) para que o polling, p.ex. de REG_IRQ_FLAGS, não espere o SPI.
+#
+# Com os dois cores, a cadeia de pinos é: pads <- janela <- DMA <- SPIMaster da CPU; 'hold' e
+# 'request'/'idle' arbitram o SPI entre a janela e o DMA. O DMA só pede o SPI com o quadro já no
+# buffer: um acesso da CPU à janela, que segura o barramento enquanto o DMA tem o SPI, nunca
+# espera por uma leitura do próprio DMA.
+
+from migen import *
+from migen.genlib.cdc import MultiReg
+from migen.genlib.fifo import SyncFIFO
+
+from litex.gen import *
+
+from litex.soc.interconnect import wishbone
+from litex.soc.interconnect.csr import *
+from litex.soc.interconnect.csr_eventmanager import *
+
+REG_FIFO           = 0x00
+REG_FIFO_ADDR_PTR  = 0x0D
+REG_PAYLOAD_LENGTH = 0x22
+REG_WRITE          = 0x80
+
+_spi_pads_layout = [("clk", 1), ("cs_n", 1), ("mosi", 1), ("miso", 1)]
+
+# Deslocador SPI (modo 0, MSB primeiro) ------------------------------------------------------------
+
+class RFM95SPIShifter(LiteXModule):
+    def __init__(self, sys_clk_freq, spi_clk_freq=4e6):
+        self.start = Signal()
+        self.tx    = Signal(8)
+        self.rx    = Signal(8)
+        self.ready = Signal()
+        self.done  = Signal()       # Pulso no fim do byte.
+
+        self.clk   = Signal()
+        self.mosi  = Signal()
+        self.miso  = Signal()
+
+        # # #
+
+        # Meio período de SCK, arredondado para cima (nunca acima de spi_clk_freq).
+        div   = max(-(-int(sys_clk_freq) // int(2*spi_clk_freq)) - 1, 0)
+        cnt   = Signal(max=div + 1)
+        shift = Signal(8)
+        bit   = Signal(3)
+
+        self.comb += [
+            self.mosi.eq(shift[7]),
+        ]
+
+        self.fsm = fsm = FSM(reset_state="IDLE")
+        fsm.act("IDLE",
+            self.ready.eq(1),
+            If(self.start,
+                NextValue(shift, self.tx),
+                NextValue(bit, 0),
+                NextValue(cnt, div),
+                NextState("LOW")
+            )
+        )
+        # SCK baixo: MOSI estável; na subida amostra MISO.
+        fsm.act("LOW",
+            If(cnt == 0,
+                NextValue(self.clk, 1),
+                NextValue(self.rx, Cat(self.miso, self.rx[:7])),
+                NextValue(cnt, div),
+                NextState("HIGH")
+            ).Else(
+                NextValue(cnt, cnt - 1)
+            )
+        )
+        # SCK alto; na descida troca o bit de MOSI.
+        fsm.act("HIGH",
+            If(cnt == 0,
+                NextValue(self.clk, 0),
+                NextValue(shift, Cat(0, shift[:7])),
+                NextValue(bit, bit + 1),
+                NextValue(cnt, div),
+                If(bit == 7,
+                    NextState("DONE")
+                ).Else(
+                    NextState("LOW")
+                )
+            ).Else(
+                NextValue(cnt, cnt - 1)
+            )
+        )
+        fsm.act("DONE",
+            self.done.eq(1),
+            NextState("IDLE")
+        )
+
+# DMA de pacotes -----------------------------------------------------------------------------------
+
+class RFM95DMA(LiteXModule):
+    def __init__(self, pads, sys_clk_freq, spi_clk_freq=4e6, cs_gap_ns=1000):
+        # Pinos vistos pelo SPIMaster da CPU (ligados a 'pads' pelo mux abaixo).
+        self.cpu_pads = cpu_pads = Record(_spi_pads_layout)
+
+        # Arbitragem com a janela de registradores.
+        self.hold    = Signal()     # Entrada: SPI ocupado por outro core; espera em WAIT-BUS.
+        self.request = Signal()     # Quadro no buffer esperando o SPI.
+        self.active  = Signal()     # Carga em andamento (pinos do DMA; sem acessos ao barramento).
+
+        # Mestre Wishbone para ler o quadro da memória.
+        self.bus = bus = wishbone.Interface(data_width=32)
+
+        self._address = CSRStorage(32, description="Endereço (bytes) do quadro na memória.")
+        self._length  = CSRStorage(8,  description="Tamanho do quadro (1..255 bytes).")
+        self._control = CSRStorage(fields=[
+            CSRField("start", size=1, offset=0, pulse=True, description="Inicia a carga do FIFO."),
+        ])
+        self._status  = CSRStatus(fields=[
+            CSRField("busy",  size=1, offset=0, description="Carga em andamento (SPI da CPU bloqueado)."),
+            CSRField("error", size=1, offset=1, description="Erro no barramento ou tamanho 0 na última carga."),
+        ])
+
+        self.ev = EventManager()
+        self.ev.done = EventSourcePulse(description="Carga do FIFO concluída.")
+        self.ev.finalize()
+
+        # # #
+
+        self.shifter = shifter = RFM95SPIShifter(sys_clk_freq, spi_clk_freq)
+
+        # Mux dos pinos.
+        active = self.active
+        cs     = Signal()
+        self.comb += [
+            If(active,
+                pads.clk.eq(shifter.clk),
+                pads.mosi.eq(shifter.mosi),
+                pads.cs_n.eq(~cs)
+            ).Else(
+                pads.clk.eq(cpu_pads.clk),
+                pads.mosi.eq(cpu_pads.mosi),
+                pads.cs_n.eq(cpu_pads.cs_n)
+            ),
+            cpu_pads.miso.eq(pads.miso),
+        ]
+        self.specials += MultiReg(pads.miso, shifter.miso)
+
+        # Buffer do quadro: até 255 bytes a partir de qualquer byte da primeira palavra.
+        max_words = (3 + 255 + 3)//4
+        buf   = Memory(32, max_words)
+        buf_w = buf.get_port(write_capable=True)
+        buf_r = buf.get_port(async_read=True)
+        self.specials += buf, buf_w, buf_r
+
+        # Estado da carga.
+        address = Signal(32)
+        length  = Signal(8)
+        count   = Signal(8)
+        words   = Signal(max=max_words + 1)
+        widx    = Signal(max=max_words + 1)
+        issued  = Signal()
+        error   = Signal()
+        gap_cycles = max(int(cs_gap_ns*sys_clk_freq/1e9), 1)
+        gap     = Signal(max=gap_cycles + 1)
+
+        byte = Signal(9)
+        lane = Array([buf_r.dat_r[8*i:8*(i + 1)] for i in range(4)])[byte[0:2]]
+
+        self.comb += [
+            byte.eq(address[0:2] + count),
+            buf_r.adr.eq(byte[2:]),
+            buf_w.adr.eq(widx),
+            buf_w.dat_w.eq(bus.dat_r),
+            self._status.fields.error.eq(error),
+        ]
+
+        # Envia um byte e espera o fim; 'then' roda no ciclo do 'done'.
+        def xfer(byte, then):
+            return [
+                cs.eq(1),
+                shifter.tx.eq(byte),
+                shifter.start.eq(~issued),
+                NextValue(issued, 1),
+                If(shifter.done,
+                    NextValue(issued, 0),
+                    *then
+                )
+            ]
+
+        self.fsm = fsm = FSM(reset_state="IDLE")
+
+        # CS alto entre transações (o driver em C espera 2 us).
+        def add_gap(name, next_state):
+            fsm.act(name,
+                If(gap == 0,
+                    NextValue(gap, gap_cycles),
+                    NextState(next_state)
+                ).Else(
+                    NextValue(gap, gap - 1)
+                )
+            )
+
+        # Tamanho 0 não é carregado (o contador de 8 bits daria 256 bytes).
+        fsm.act("IDLE",
+            If(self._control.fields.start,
+                NextValue(address, self._address.storage),
+                NextValue(length,  self._length.storage),
+                NextValue(words,   (self._address.storage[0:2] + self._length.storage + 3) >> 2),
+                NextValue(widx,    0),
+                NextValue(count,   0),
+                NextValue(gap,     gap_cycles),
+                If(self._length.storage == 0,
+                    NextValue(error, 1),
+                    NextState("DONE")
+                ).Else(
+                    NextValue(error, 0),
+                    NextState("FETCH")
+                )
+            )
+        )
+        # Uma leitura Wishbone por palavra, antes de pedir o SPI.
+        fsm.act("FETCH",
+            bus.stb.eq(1),
+            bus.cyc.eq(1),
+            bus.we.eq(0),
+            bus.sel.eq(0xf),
+            bus.adr.eq(address[2:] + widx),
+            If(bus.ack,
+                buf_w.we.eq(1),
+                NextValue(widx, widx + 1),
+                If(widx == (words - 1),
+                    NextState("WAIT-BUS")
+                )
+            ).Elif(bus.err,
+                NextValue(error, 1),
+                NextState("DONE")
+            )
+        )
+        fsm.act("WAIT-BUS",
+            self.request.eq(1),
+            If(~self.hold,
+                NextState("PTR-CMD")
+            )
+        )
+        fsm.act("PTR-CMD",
+            xfer(REG_WRITE | REG_FIFO_ADDR_PTR, then=[NextState("PTR-VAL")])
+        )
+        fsm.act("PTR-VAL",
+            xfer(0x00, then=[NextState("GAP-FIFO")])
+        )
+        add_gap("GAP-FIFO", "FIFO-CMD")
+        fsm.act("FIFO-CMD",
+            xfer(REG_WRITE | REG_FIFO, then=[NextState("FIFO-DATA")])
+        )
+        # Bytes do buffer em ordem little-endian.
+        fsm.act("FIFO-DATA",
+            xfer(lane, then=[
+                NextValue(count, count + 1),
+                If(count == (length - 1),
+                    NextState("GAP-LEN")
+                )
+            ])
+        )
+        add_gap("GAP-LEN", "LEN-CMD")
+        fsm.act("LEN-CMD",
+            xfer(REG_WRITE | REG_PAYLOAD_LENGTH, then=[NextState("LEN-VAL")])
+        )
+        fsm.act("LEN-VAL",
+            xfer(length, then=[NextState("GAP-END")])
+        )
+        add_gap("GAP-END", "DONE")
+        fsm.act("DONE",
+            self.ev.done.trigger.eq(1),
+            NextState("IDLE")
+        )
+        self.comb += [
+            active.eq(~fsm.ongoing("IDLE") & ~fsm.ongoing("FETCH") &
+                      ~fsm.ongoing("WAIT-BUS") & ~fsm.ongoing("DONE")),
+            self._status.fields.busy.eq(~fsm.ongoing("IDLE")),
+        ]
+
+# Janela de registradores ------------------------------------------------------------------------
+
+class RFM95RegWindow(LiteXModule):
+    """Registrador 'reg' do rádio na palavra 'reg' da janela; a palavra 128 configura o prefetch."""
+    def __init__(self, pads, sys_clk_freq, spi_clk_freq=4e6, fifo_depth=8, cs_gap_ns=1000):
+        # Escravo Wishbone (região 'rfm').
+        self.bus = bus = wishbone.Interface(data_width=32)
+
+        # Pinos repassados ao próximo core da cadeia (DMA ou SPIMaster) quando a janela está parada.
+        self.down_pads = down_pads = Record(_spi_pads_layout)
+
+        # Arbitragem com o DMA.
+        self.hold  = Signal()       # Entrada: DMA com o SPI; não inicia transações.
+        self.defer = Signal()       # Entrada: DMA esperando o SPI; sem prefetch.
+        self.idle  = Signal()       # Sem transação nem escrita postada pendente.
+
+        # # #
+
+        self.shifter = shifter = RFM95SPIShifter(sys_clk_freq, spi_clk_freq)
+
+        # Mux dos pinos.
+        active = Signal()
+        cs     = Signal()
+        self.comb += [
+            If(active,
+                pads.clk.eq(shifter.clk),
+                pads.mosi.eq(shifter.mosi),
+                pads.cs_n.eq(~cs)
+            ).Else(
+                pads.clk.eq(down_pads.clk),
+                pads.mosi.eq(down_pads.mosi),
+                pads.cs_n.eq(down_pads.cs_n)
+            ),
+            down_pads.miso.eq(pads.miso),
+        ]
+        self.specials += MultiReg(pads.miso, shifter.miso)
+
+        # Escritas postadas: {reg, valor}.
+        self.wfifo = wfifo = SyncFIFO(7 + 8, fifo_depth)
+
+        # Prefetch.
+        pf_enable = Signal()
+        pf_reg    = Signal(7)
+        pf_valid  = Signal()
+        pf_data   = Signal(8)
+
+        # Transação SPI corrente.
+        READ, WRITE, PREFETCH = range(3)
+        kind   = Signal(2)
+        t_addr = Signal(8)
+        t_data = Signal(8)
+        rdata  = Signal(32)
+        issued = Signal()
+        gap_cycles = max(int(cs_gap_ns*sys_clk_freq/1e9), 1)
+        gap    = Signal(max=gap_cycles + 1)
+
+        req    = bus.cyc & bus.stb
+        reg    = bus.adr[0:7]
+        is_cfg = bus.adr[7]
+
+        self.comb += [
+            bus.dat_r.eq(rdata),
+            wfifo.din.eq(Cat(bus.dat_w[0:8], reg)),
+        ]
+
+        def xfer(byte, then):
+            return [
+                cs.eq(1),
+                shifter.tx.eq(byte),
+                shifter.start.eq(~issued),
+                NextValue(issued, 1),
+                If(shifter.done,
+                    NextValue(issued, 0),
+                    *then
+                )
+            ]
+
+        self.fsm = fsm = FSM(reset_state="IDLE")
+        fsm.act("IDLE",
+            # Escrita: postada no FIFO (ou na configuração do prefetch), ACK sem esperar o SPI.
+            If(req & bus.we & (is_cfg | wfifo.writable),
+                If(is_cfg,
+                    NextValue(pf_enable, bus.dat_w[7]),
+                    NextValue(pf_reg,    bus.dat_w[0:7])
+                ).Else(
+                    wfifo.we.eq(1)
+                ),
+                NextValue(pf_valid, 0),
+                NextState("ACK")
+            # Leitura da configuração.
+            ).Elif(req & ~bus.we & is_cfg,
+                NextValue(rdata, Cat(pf_reg, pf_enable)),
+                NextState("ACK")
+            # Leitura atendida pelo prefetch (só sem escritas pendentes).
+            ).Elif(req & ~bus.we & pf_enable & pf_valid & (reg == pf_reg) & ~wfifo.readable,
+                NextValue(rdata, pf_data),
+                NextState("ACK")
+            # Drena as escritas postadas (em ordem, antes de qualquer leitura).
+            ).Elif(~self.hold & wfifo.readable,
+                wfifo.re.eq(1),
+                NextValue(kind,   WRITE),
+                NextValue(t_addr, REG_WRITE | wfifo.dout[8:15]),
+                NextValue(t_data, wfifo.dout[0:8]),
+                NextState("ADDR")
+            ).Elif(~self.hold & req & ~bus.we,
+                NextValue(kind,   READ),
+                NextValue(t_addr, reg),
+                NextValue(t_data, 0),
+                NextState("ADDR")
+            ).Elif(~self.hold & ~self.defer & pf_enable,
+                NextValue(kind,   PREFETCH),
+                NextValue(t_addr, pf_reg),
+                NextValue(t_data, 0),
+                NextState("ADDR")
+            )
+        )
+        fsm.act("ACK",
+            bus.ack.eq(1),
+            NextState("IDLE")
+        )
+        fsm.act("ADDR",
+            active.eq(1),
+            xfer(t_addr, then=[NextState("DATA")])
+        )
+        fsm.act("DATA",
+            active.eq(1),
+            xfer(t_data, then=[
+                NextValue(gap, gap_cycles),
+                If(kind == READ,
+                    NextValue(rdata, shifter.rx),
+                    NextState("R-ACK")
+                ).Else(
+                    If(kind == PREFETCH,
+                        NextValue(pf_data,  shifter.rx),
+                        NextValue(pf_valid, 1)
+                    ),
+                    NextState("GAP")
+                )
+            ])
+        )
+        fsm.act("R-ACK",
+            active.eq(1),
+            bus.ack.eq(1),
+            NextState("GAP")
+        )
+        # CS alto entre transações.
+        fsm.act("GAP",
+            active.eq(1),
+            If(gap == 0,
+                NextState("IDLE")
+            ).Else(
+                NextValue(gap, gap - 1)
+            )
+        )
+        # Com 'idle' em 1, este ciclo não inicia transação: o DMA pode assumir o SPI.
+        self.comb += self.idle.eq(fsm.ongoing("IDLE") & ~wfifo.readable & ~req)
@@ -0,0 +1,127 @@
+#
+# Captura de timestamps em hardware para o SoC da Colorlight.
+#
+# Os instantes medidos pelo firmware em volta do TX e do TxDone têm o erro do polling (até 1 ms
+# sem DIO0). Este core trava um contador livre de ciclos nas bordas dos sinais do rádio e dos
+# barramentos, com a resolução do clock do sistema:
+#   - DIO0 subindo (TxDone/RxDone);
+#   - CS do SPI do rádio baixando (início da transação) e subindo (fim);
+#   - START (SDA cai com SCL alto) e STOP (SDA sobe com SCL alto) em cada barramento I2C.
+#
+# Cada evento é um bit; o SoC numera os eventos na ordem do add_*() e exporta o bit de cada um
+# como constante (TSCAP_<NOME>). Todos os eventos de um mesmo ciclo entram numa única entrada do
+# FIFO (instante + máscara), então nenhum se perde nem é reordenado.
+#
+# Interface (CSRs de 32 bits):
+#   control  enable e clear (pulso: esvazia o FIFO e limpa o overflow);
+#   mask     eventos capturados (bit = evento);
+#   status   level (entradas no FIFO) e overflow (evento perdido com o FIFO cheio);
+#   ts       ciclo (32 bits baixos do contador) da entrada na frente do FIFO;
+#   events   máscara de eventos da entrada na frente do FIFO;
+#   pop      escrita: descarta a entrada da frente;
+#   now      contador livre (32 bits; dá a volta em 71 s a 60 MHz: use diferenças).
+
+from migen import *
+from migen.genlib.cdc import MultiReg
+from migen.genlib.fifo import SyncFIFO
+
+from litex.gen import *
+
+from litex.soc.interconnect.csr import *
+
+TSCAP_MAX_EVENTS = 32
+
+# Captura de timestamps ----------------------------------------------------------------------------
+
+class TimestampCapture(LiteXModule):
+    def __init__(self, fifo_depth=32):
+        self._control = CSRStorage(fields=[
+            CSRField("enable", size=1, offset=0, description="Captura ligada."),
+            CSRField("clear",  size=1, offset=1, pulse=True, description="Esvazia o FIFO e limpa o overflow."),
+        ])
+        self._mask   = CSRStorage(TSCAP_MAX_EVENTS, reset=2**TSCAP_MAX_EVENTS - 1, description="Eventos capturados.")
+        self._status = CSRStatus(fields=[
+            CSRField("level",    size=8, offset=0, description="Entradas no FIFO."),
+            CSRField("overflow", size=1, offset=8, description="Evento perdido com o FIFO cheio."),
+        ])
+        self._ts     = CSRStatus(32, description="Ciclo da entrada na frente do FIFO.")
+        self._events = CSRStatus(TSCAP_MAX_EVENTS, description="Eventos da entrada na frente do FIFO.")
+        self._pop    = CSR()
+        self._now    = CSRStatus(32, description="Contador livre de ciclos.")
+
+        self.names  = []        # Nome do evento de cada bit
+        self.pulses = []        # Pulso de um ciclo na borda
+
+        self.fifo_depth = fifo_depth
+
+    # Eventos -------------------------------------------------------------------------------------
+
+    def _add(self, name, pulse):
+        assert len(self.names) < TSCAP_MAX_EVENTS
+        self.names.append(name)
+        self.pulses.append(pulse)
+
+    def _edges(self, sig):
+        prev = Signal(reset_less=True)
+        rise = Signal()
+        fall = Signal()
+        self.sync += prev.eq(sig)
+        self.comb += [
+            rise.eq(sig & ~prev),
+            fall.eq(~sig & prev),
+        ]
+        return rise, fall
+
+    def add_rising(self, name, sig, async_input=False):
+        """Borda de subida de 'sig' (ex.: DIO0); 'async_input' passa por um sincronizador."""
+        if async_input:
+            sync = Signal()
+            self.specials += MultiReg(sig, sync)
+            sig = sync
+        rise, _ = self._edges(sig)
+        self._add(name, rise)
+
+    def add_spi_cs(self, name, cs_n):
+        """Início (CS baixa) e fim (CS sobe) das transações: eventos <nome> e <nome>_end."""
+        rise, fall = self._edges(cs_n)
+        self._add(name, fall)
+        self._add(name + "_end", rise)
+
+    def add_i2c(self, name, scl, sda):
+        """START e STOP do barramento: eventos <nome>_start e <nome>_stop."""
+        scl_d = Signal(reset_less=True)
+        self.sync += scl_d.eq(scl)
+        sda_rise, sda_fall = self._edges(sda)
+        self._add(name + "_start", sda_fall & scl & scl_d)
+        self._add(name + "_stop",  sda_rise & scl & scl_d)
+
+    # Contador e FIFO -----------------------------------------------------------------------------
+
+    def do_finalize(self):
+        n      = len(self.names)
+        now    = Signal(32)
+        events = Signal(TSCAP_MAX_EVENTS)
+        control  = self._control.fields
+        overflow = Signal()
+
+        self.fifo = fifo = ResetInserter()(SyncFIFO(32 + TSCAP_MAX_EVENTS, self.fifo_depth))
+        self.comb += [
+            events.eq(Cat(*self.pulses) & self._mask.storage[:n] & Replicate(control.enable, n)),
+            fifo.reset.eq(control.clear),
+            fifo.din.eq(Cat(now, events)),
+            fifo.we.eq(events != 0),
+            fifo.re.eq(self._pop.re),
+            self._ts.status.eq(fifo.dout[:32]),
+            self._events.status.eq(fifo.dout[32:]),
+            self._status.fields.level.eq(fifo.level),
+            self._status.fields.overflow.eq(overflow),
+            self._now.status.eq(now),
+        ]
+        self.sync += [
+            now.eq(now + 1),
+            If(control.clear,
+                overflow.eq(0)
+            ).Elif((events != 0) & ~fifo.writable,
+                overflow.eq(1)
+            )
+        ]
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+#
+# Monta a matriz de benchmarks entre perfis do SoC a partir dos logs do
+# comando 'bench' do firmware (capturados do litex_term, um arquivo por perfil).
+#
+# Uso: python3 bench_matrix.py picorv32.log vexriscv-lite.log vexriscv-full.log
+
+import re
+import sys
+
+SOC_RE   = re.compile(r"BENCH-SOC profile=(\S+) cpu=(.+?) clk=(\d+) l2=(\d+) fastmem=(\d)")
+BENCH_RE = re.compile(r"BENCH (.+?)\s+(\d+) ciclos\s+(\d+) us")
+
+def parse(path):
+    soc, results = None, {}
+    with open(path, errors="replace") as f:
+        for line in f:
+            m = SOC_RE.search(line)
+            if m:
+                profile, cpu, clk, l2, fastmem = m.groups()
+                soc = "{} ({}, {} MHz, L2 {}{})".format(profile, cpu, int(clk)//1000000, l2,
+                    "" if fastmem == "1" else ", FASTMEM=0")
+                continue
+            m = BENCH_RE.search(line)
+            if m:
+                results[m.group(1).strip()] = (int(m.group(2)), int(m.group(3)))
+    return soc or path, results
+
+def main():
+    if len(sys.argv) < 2:
+        print("uso: bench_matrix.py log1 [log2 ...]")
+        sys.exit(1)
+
+    runs  = [parse(p) for p in sys.argv[1:]]
+    names = []
+    for _, results in runs:
+        for name in results:
+            if name not in names:
+                names.append(name)
+
+    print("| Medida | " + " | ".join(soc for soc, _ in runs) + " |")
+    print("|---" * (len(runs) + 1) + "|")
+    for name in names:
+        cells = []
+        for _, results in runs:
+            if name in results:
+                cycles, us = results[name]
+                cells.append("{} ciclos ({} us)".format(cycles, us))
+            else:
+                cells.append("-")
+        print("| {} | {} |".format(name, " | ".join(cells)))
+
+if __name__ == "__main__":
+    main()
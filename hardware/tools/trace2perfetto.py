@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+# Converte o anel de eventos do firmware ('trace_dump', lib/trace.h) para o
+# JSON de trace do Chrome, que abre em ui.perfetto.dev ou chrome://tracing.
+#
+# A entrada é a captura crua da UART com o dump (o formato binário está em
+# lib/trace.c) ou a própria porta serial: com --port o script envia o comando
+# e lê a resposta (precisa do pyserial).
+#
+# Uso: python3 trace2perfetto.py captura.bin -o trace.json
+#      python3 trace2perfetto.py --port /dev/ttyUSB0 [--baud 115200] [-n 5000] -o trace.json
+
+import argparse
+import json
+import re
+import struct
+import sys
+
+BEGIN_RE = re.compile(rb"TRACE-BEGIN (\d+)\r?\n")
+END_MARK = b"TRACE-END"
+
+HDR   = struct.Struct("<4sHHIII")  # 'TRC1', tamanho do evento, n_nomes, clock, n_eventos, perdidos
+NAME  = struct.Struct("<HBB")      # id, formato do arg, tamanho do nome
+EVENT = struct.Struct("<IHHI")     # ts_lo, ts_hi, id, arg
+
+PH_INSTANT = 0x0000
+PH_BEGIN   = 0x4000
+PH_END     = 0x8000
+PH_COUNTER = 0xC000
+ID_MASK    = 0x3FFF
+
+def capture(port, baud, n):
+    import serial   # Só para --port
+
+    with serial.Serial(port, baud, timeout=2) as s:
+        s.reset_input_buffer()
+        s.write("trace_dump {}\n".format(n).encode())
+        data = b""
+        while True:
+            m = BEGIN_RE.search(data)
+            if m and len(data) >= m.end() + int(m.group(1)):
+                return data
+            chunk = s.read(4096)
+            if not chunk:
+                raise IOError("sem resposta do 'trace_dump'")
+            data += chunk
+
+def parse(data):
+    m = BEGIN_RE.search(data)
+    if not m:
+        raise ValueError("marcador TRACE-BEGIN nao encontrado")
+    size, off = int(m.group(1)), m.end()
+    blob = data[off:off + size]
+    if len(blob) < size:
+        raise ValueError("dump truncado: {} de {} bytes".format(len(blob), size))
+    if END_MARK not in data[off + size:off + size + 16]:
+        print("aviso: TRACE-END fora do lugar", file=sys.stderr)
+
+    magic, ev_size, n_names, clock, n_events, lost = HDR.unpack_from(blob)
+    if magic != b"TRC1" or ev_size != EVENT.size:
+        raise ValueError("formato desconhecido ({!r}, evento de {} bytes)".format(magic, ev_size))
+    pos = HDR.size
+
+    names = {}
+    for _ in range(n_names):
+        ev_id, fmt, length = NAME.unpack_from(blob, pos)
+        pos += NAME.size
+        names[ev_id] = (blob[pos:pos + length].decode(), chr(fmt))
+        pos += length
+
+    events = []
+    for _ in range(n_events):
+        ts_lo, ts_hi, ev_id, arg = EVENT.unpack_from(blob, pos)
+        pos += EVENT.size
+        events.append(((ts_hi << 32) | ts_lo, ev_id, arg))
+    return clock, lost, names, events
+
+def convert(clock, names, events):
+    out = [{"ph": "M", "pid": 1, "name": "process_name", "args": {"name": "firmware"}}]
+    tracks = set()
+    open_slices = {}
+    orphans = 0
+    t0 = events[0][0] if events else 0
+
+    for ts, raw_id, arg in events:
+        ev_id, phase = raw_id & ID_MASK, raw_id & ~ID_MASK & 0xFFFF
+        name, fmt = names.get(ev_id, ("ev{}".format(ev_id), "u"))
+        us = (ts - t0) * 1e6 / clock
+
+        # Cada instância (rádio, barramento) numa trilha própria.
+        inst, val = (arg >> 24, arg & 0xFFFFFF) if fmt == "i" else (0, arg)
+        tid = ev_id * 256 + inst
+        if tid not in tracks:
+            tracks.add(tid)
+            label = "{} {}".format(name, inst) if fmt == "i" else name
+            out.append({"ph": "M", "pid": 1, "tid": tid, "name": "thread_name", "args": {"name": label}})
+
+        if fmt == "s":
+            tag = arg.to_bytes(4, "little").rstrip(b"\0").decode(errors="replace")
+            name, args = "{} {}".format(name, tag), {}
+        else:
+            args = {"val": val}
+
+        ev = {"pid": 1, "tid": tid, "ts": us, "name": name}
+        if phase == PH_BEGIN:
+            open_slices[tid] = open_slices.get(tid, 0) + 1
+            ev.update(ph="B", args=args)
+        elif phase == PH_END:
+            # O BEGIN pode ter sido sobrescrito no anel.
+            if not open_slices.get(tid):
+                orphans += 1
+                continue
+            open_slices[tid] -= 1
+            ev.update(ph="E", args=args)
+        elif phase == PH_COUNTER:
+            ev.update(ph="C", args={name: val})
+        else:
+            ev.update(ph="i", s="t", args=args)
+        out.append(ev)
+    return out, orphans
+
+def main():
+    parser = argparse.ArgumentParser(description="Converte o 'trace_dump' do firmware para JSON do Chrome/Perfetto.")
+    parser.add_argument("capture", nargs="?",            help="Captura crua da UART com o dump.")
+    parser.add_argument("--port",                        help="Porta serial: envia 'trace_dump' e lê a resposta.")
+    parser.add_argument("--baud",  type=int, default=115200)
+    parser.add_argument("-n",      type=int, default=0,  help="Eventos mais recentes (0 = todo o anel).")
+    parser.add_argument("-o", "--output",                help="Arquivo JSON (padrão: stdout).")
+    args = parser.parse_args()
+
+    if args.port:
+        data = capture(args.port, args.baud, args.n)
+    elif args.capture:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+    else:
+        parser.error("informe a captura ou --port")
+
+    clock, lost, names, events = parse(data)
+    trace, orphans = convert(clock, names, events)
+
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump({"traceEvents": trace, "displayTimeUnit": "ns"}, out)
+    if args.output:
+        out.close()
+
+    span = (events[-1][0] - events[0][0]) / clock * 1e3 if events else 0
+    print("{} eventos em {:.1f} ms, {} perdidos no anel, {} fins sem inicio descartados".format(
+        len(events), span, lost, orphans), file=sys.stderr)
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,111 @@
+#!/usr/bin/env python3
+#
+# Recebe os datagramas do modo gateway do firmware (gateway_start) e imprime
+# um registro por quadro LoRa. Formato em hardware/firmware/lib/gateway.h.
+#
+# Uso: python3 udp_listener.py [--port 5400] [--csv saida.csv]
+
+import argparse
+import socket
+import struct
+import sys
+import time
+
+HDR = struct.Struct("<2sBBI")      # 'LG', versão, n_registros, seq
+REC = struct.Struct("<BBbbI")      # len, rádio, rssi, snr, t_ms
+
+FRAME_TYPE_SAMPLE = 0x53
+FRAME_TYPE_TRACE  = 0x54
+
+def decode_sample(data):
+    # Quadro de amostra: 4 bytes (sem id), 7 bytes ('S', node_id, sensor, ...)
+    # ou 15 bytes ('T': o de 7 mais os tempos de rastreio, ignorados aqui).
+    # As versões antigas de 6 e 14 bytes não têm o byte do sensor.
+    sensor = 0
+    if len(data) in (15, 7) and data[0] == (FRAME_TYPE_TRACE if len(data) == 15 else FRAME_TYPE_SAMPLE):
+        node, sensor = data[1], data[2]
+        temp, umid = struct.unpack_from("<hh", data, 3)
+    elif len(data) in (14, 6) and data[0] == (FRAME_TYPE_TRACE if len(data) == 14 else FRAME_TYPE_SAMPLE):
+        node = data[1]
+        temp, umid = struct.unpack_from("<hh", data, 2)
+    elif len(data) == 4:
+        node = 0
+        temp, umid = struct.unpack("<hh", data)
+    else:
+        return None
+    return node, sensor, temp / 100, umid / 100
+
+def parse(datagram):
+    if len(datagram) < HDR.size:
+        raise ValueError("datagrama curto")
+    magic, version, count, seq = HDR.unpack_from(datagram)
+    if magic != b"LG" or version != 1:
+        raise ValueError("cabeçalho inválido")
+
+    records, off = [], HDR.size
+    for _ in range(count):
+        length, radio, rssi, snr, t_ms = REC.unpack_from(datagram, off)
+        off += REC.size
+        data = datagram[off:off + length]
+        if len(data) != length:
+            raise ValueError("registro truncado")
+        off += length
+        records.append((radio, rssi, snr, t_ms, data))
+    return seq, records
+
+def main():
+    parser = argparse.ArgumentParser(description="Listener UDP do gateway LoRa (Colorlight).")
+    parser.add_argument("--bind", default="0.0.0.0", help="Endereço local.")
+    parser.add_argument("--port", default=5400, type=int, help="Porta UDP (gateway_start ... <porta>).")
+    parser.add_argument("--csv",  default=None, help="Também grava os registros em CSV.")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    csv = open(args.csv, "a") if args.csv else None
+    print("Escutando em {}:{}".format(args.bind, args.port))
+
+    frames = datagrams = lost = 0
+    last_seq = None
+    t0 = time.time()
+    try:
+        while True:
+            datagram, addr = sock.recvfrom(2048)
+            try:
+                seq, records = parse(datagram)
+            except (ValueError, struct.error) as e:
+                print("{}: {}".format(addr[0], e), file=sys.stderr)
+                continue
+
+            # Lacunas no seq: datagramas perdidos no caminho.
+            if last_seq is not None and seq != (last_seq + 1) & 0xFFFFFFFF:
+                lost += (seq - last_seq - 1) & 0xFFFFFFFF
+            last_seq = seq
+            datagrams += 1
+            frames += len(records)
+
+            for radio, rssi, snr, t_ms, data in records:
+                sample = decode_sample(data)
+                if sample:
+                    node, sensor, temp, umid = sample
+                    desc = "no {} sensor {} temp={:.2f} C umid={:.2f} %".format(node, sensor, temp, umid)
+                else:
+                    desc = data.hex()
+                print("seq {} t={} ms radio {} RSSI {} dBm SNR {} dB: {}".format(
+                    seq, t_ms, radio, rssi, snr, desc))
+                if csv:
+                    csv.write("{},{},{},{},{},{},{}\n".format(
+                        time.time(), seq, t_ms, radio, rssi, snr, data.hex()))
+            if csv:
+                csv.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        dt = max(time.time() - t0, 1e-9)
+        print("\n{} quadros em {} datagramas ({:.1f} quadros/s), {} datagramas perdidos".format(
+            frames, datagrams, frames / dt, lost))
+        if csv:
+            csv.close()
+
+if __name__ == "__main__":
+    main()
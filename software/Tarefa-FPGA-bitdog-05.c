@@ -5,6 +5,11 @@
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "rfm96.h"
+#include "flashlog.h"
+#include "latency.h"
+#include "rollstats.h"
+#include "oled_graph.h"
+#include "cifra.h"
 #include "ssd1306.h"
 
 
@@ -16,7 +21,39 @@
 #define PIN_DIO0 8   
 
 #define LORA_FREQUENCY 915E6
+// Canal escutado por este receptor no plano de canais (um receptor por rádio
+// do nó FPGA: o canal N recebe os quadros do rádio N).
+#define LORA_RX_CHANNEL 0
 #define SEND_INTERVAL_MS 10000
+// Cabeçalho implícito: tamanho do quadro combinado com os nós (0 = explícito,
+// 4 = amostra sem id, 7 = amostra com id e sensor); igual ao 'cfg_set implicit'.
+#define LORA_IMPLICIT_LEN 0
+// RX_VERBOSE em 1 ecoa cada quadro na USB (tamanho, RSSI e a amostra do
+// nó); desligado, o laço de recepção não paga os printf por quadro.
+#define RX_VERBOSE 0
+
+// TDMA: com TDMA_BEACON em 1, o receptor transmite um beacon por superquadro
+// com o dono de cada slot (formato em hardware/firmware/lib/frame.h). Cada
+// slot precisa caber o maior quadro do nó (TDMA_MAX_FRAME_LEN: rastreio
+// cifrado, ~2,1 s em SF12/125 kHz) mais a janela de 50 ms em que o nó pode
+// começar o TX; o nó recusa quadros que passariam do fim do slot. O
+// superquadro tem TDMA_NUM_SLOTS + 1 slots (o primeiro é do beacon).
+#define TDMA_BEACON      0
+#define TDMA_SLOT_MS     2300
+#define TDMA_MAX_FRAME_LEN (FRAME_TRACE_LEN + CIFRA_OVERHEAD)
+#define TDMA_TX_WINDOW_MS  50
+#define TDMA_NUM_SLOTS   4
+#define FRAME_TYPE_SAMPLE 0x53
+#define FRAME_TYPE_BEACON 0xBE
+#define FRAME_TYPE_TRACE  0x54
+#define FRAME_SAMPLE_LEN  7     // Amostra com id e sensor (hardware/firmware/lib/frame.h)
+#define FRAME_TRACE_LEN   15    // Amostra com os tempos medidos no nó
+
+// Quadros cifrados ('cfg_set crypt 1' no nó, formato em inc/cifra.h): a chave
+// é a mesma do 'cfg_set key' dos nós. A zerada é só o padrão de fábrica: com
+// ela, os dois lados recusam a cifra. Quadros sem cifra de um nó que já mandou
+// quadros cifrados são recusados.
+#define LORA_CHAVE { 0 }
 
 #define SDA_PIN 14
 #define SCL_PIN 15
@@ -24,6 +61,12 @@
 #define OLED_ADDR 0x3C
 #define OLED_WIDTH 128
 #define OLED_HEIGHT 64
+// Página 0: texto nas páginas 0..1 do display, gráfico de temperatura nas 2..7.
+#define GRAFICO_PAGINA_INI 2
+#define GRAFICO_PAGINA_FIM 7
+
+// Botão A da BitDogLab (ativo em 0): troca a página do display.
+#define BOTAO_A 5
 
 typedef struct {
     int16_t temperatura;
@@ -33,10 +76,29 @@ typedef struct {
 struct repeating_timer timer;
 int cont = 0;
 bool start = true;
+volatile bool animar = false;   // Sinalizado pelo timer, desenhado no laço
 
 uint8_t ssd[ssd1306_buffer_length];
 ssd1306_t disp;
 struct render_area frame_area;
+struct render_area texto_area;      // Páginas 0..1 (início de 'ssd')
+
+static const lora_channel_plan_t channel_plan = LORA_CHANNEL_PLAN_DEFAULT;
+// Dono (node_id) de cada slot do superquadro.
+static const uint8_t tdma_slots[TDMA_NUM_SLOTS] = { 1, 2, 3, 4 };
+static bool     lora_ok = false;
+static uint32_t rx_ready_us = 0;    // Do reset até o rádio em RX contínuo
+
+// Página 0: última amostra; 1..RS_NUM_JANELAS: janelas do sensor (nó e
+// barramento AHT10) da última amostra.
+static uint8_t pagina = 0;
+static aht10   ultima;
+static uint8_t ultimo_no, ultimo_sensor;
+
+// Tendência da temperatura do primeiro sensor que aparecer (nó << 8 | sensor;
+// -1 = nenhum ainda).
+static oled_graph_t grafico;
+static int          grafico_fonte = -1;
 
 
 void limpar_display() {
@@ -52,37 +114,64 @@ void mostrar_texto(int x, int y, const char *texto) {
 
 // ----------------------------------------------------------
 
-// Callback para timer repetitivo mostrando "Aguardando..."
+// O timer só sinaliza: escrever no display (I2C, ~1 KB) dentro da interrupção
+// atrasaria o tratamento do DIO0 e a leitura do FIFO.
 bool repeating_timer_callback(struct repeating_timer *t) {
+    (void)t;
+    animar = true;
+    return true;
+}
+
+// Tela "Aguardando", com o canal e o tempo até o RX ficar pronto.
+void desenhar_aguardando() {
     char msg[32];
     int dots = cont % 4;
+
+    memset(ssd, 0, ssd1306_buffer_length);
     sprintf(msg, "Aguardando %.*s", dots, "...");
-    limpar_display();
     ssd1306_draw_string(ssd, 0, 8, msg);
     ssd1306_draw_string(ssd, 0, 24, "dados...");
+    sprintf(msg, "Freq: %.1f MHz", channel_plan.frequency[LORA_RX_CHANNEL] / 1e6);
+    ssd1306_draw_string(ssd, 0, 40, msg);
+    sprintf(msg, "RX em %lu ms", (unsigned long)(rx_ready_us / 1000));
+    ssd1306_draw_string(ssd, 0, 56, msg);
     render_on_display(ssd, &frame_area);
     cont++;
-    return true;
 }
 
 // ----------------------------------------------------------
 
-// Função para exibir a tela "Aguardando"
+// Liga a animação; não bloqueia (o rádio já está escutando).
 void aguardar() {
-    limpar_display();
-    ssd1306_draw_string(ssd, 0, 8, "Aguardando");
-    ssd1306_draw_string(ssd, 0, 24, "dados...");
-    render_on_display(ssd, &frame_area);
+    desenhar_aguardando();
     add_repeating_timer_ms(400, repeating_timer_callback, NULL, &timer);
-    sleep_ms(10000);
 }
 
 // ----------------------------------------------------------
 
-void iniciar() {
-    stdio_init_all();
+// Primeiro o rádio: em poucos ms ele já está em RX contínuo e o FIFO guarda
+// o primeiro quadro enquanto o display ainda é inicializado.
+void iniciar_radio() {
+    rfm96_config_t lora_cfg = {
+        .spi_instance = spi0,
+        .pin_miso = PIN_MISO,
+        .pin_cs   = PIN_CS,
+        .pin_sck  = PIN_SCK,
+        .pin_mosi = PIN_MOSI,
+        .pin_rst  = PIN_RST,
+        .pin_dio0 = PIN_DIO0,
+        .frequency = LORA_FREQUENCY
+    };
 
+    lora_ok = lora_init(lora_cfg) && lora_use_channel(&channel_plan, LORA_RX_CHANNEL);
+    if (!lora_ok) return;
 
+    lora_set_implicit(LORA_IMPLICIT_LEN);
+    lora_start_rx_continuous();
+    rx_ready_us = (uint32_t)to_us_since_boot(get_absolute_time());
+}
+
+void iniciar_display() {
     i2c_init(I2C_PORT, 400 * 1000);
     gpio_set_function(SDA_PIN, GPIO_FUNC_I2C);
     gpio_set_function(SCL_PIN, GPIO_FUNC_I2C);
@@ -101,53 +190,49 @@ void iniciar() {
 
     calculate_render_area_buffer_length(&frame_area);
 
+    texto_area = frame_area;
+    texto_area.end_page = GRAFICO_PAGINA_INI - 1;
+    calculate_render_area_buffer_length(&texto_area);
+    oled_graph_init(&grafico, GRAFICO_PAGINA_INI, GRAFICO_PAGINA_FIM, 1500, 3500);
+
     // Limpa display
     memset(ssd, 0, ssd1306_buffer_length);
     render_on_display(ssd, &frame_area);
+}
 
-
-    ssd1306_draw_string(ssd, 0, 0, "Inic. LoRa...");
-    render_on_display(ssd, &frame_area);
-    sleep_ms(500);
-
-
-    rfm96_config_t lora_cfg = {
-        .spi_instance = spi0,
-        .pin_miso = PIN_MISO,
-        .pin_cs   = PIN_CS,
-        .pin_sck  = PIN_SCK,
-        .pin_mosi = PIN_MOSI,
-        .pin_rst  = PIN_RST,
-        .pin_dio0 = PIN_DIO0,
-        .frequency = LORA_FREQUENCY
-    };
-
-    if (!lora_init(lora_cfg)) {
-        memset(ssd, 0, ssd1306_buffer_length);
+void iniciar() {
+    iniciar_radio();
+    stdio_init_all();
+    iniciar_display();
+    flashlog_init();
+    static const uint8_t chave[16] = LORA_CHAVE;
+    cifra_init(chave);
+    gpio_init(BOTAO_A);
+    gpio_set_dir(BOTAO_A, GPIO_IN);
+    gpio_pull_up(BOTAO_A);
+
+    if (!lora_ok) {
         ssd1306_draw_string(ssd, 0, 8, "ERRO: LoRa");
         render_on_display(ssd, &frame_area);
         while (1);
     }
-
-    char freq_msg[32];
-    sprintf(freq_msg, "Freq: %.1f MHz", LORA_FREQUENCY / 1e6);
-    memset(ssd, 0, ssd1306_buffer_length);
-    ssd1306_draw_string(ssd, 0, 8, "LoRa OK");
-    ssd1306_draw_string(ssd, 0, 24, freq_msg);
-    render_on_display(ssd, &frame_area);
-    sleep_ms(1000);
-
-    // Limpa display e inicia recepção LoRa contínua
-    memset(ssd, 0, ssd1306_buffer_length);
-    render_on_display(ssd, &frame_area);
-    lora_start_rx_continuous();
+    printf("RX pronto %lu us apos o reset\n", (unsigned long)rx_ready_us);
+    printf("Airtime do quadro de %d bytes: %lu us explicito, %lu us implicito\n", FRAME_SAMPLE_LEN,
+           (unsigned long)lora_airtime_us(FRAME_SAMPLE_LEN, false),
+           (unsigned long)lora_airtime_us(FRAME_SAMPLE_LEN, true));
+#if TDMA_BEACON
+    uint32_t maior_ms = lora_airtime_us(TDMA_MAX_FRAME_LEN, false) / 1000 + TDMA_TX_WINDOW_MS;
+    if (maior_ms > TDMA_SLOT_MS)
+        printf("TDMA: slot de %d ms menor que o quadro de %d bytes (%lu ms)\n", TDMA_SLOT_MS,
+               TDMA_MAX_FRAME_LEN, (unsigned long)maior_ms);
+#endif
 }
 
 
 // ----------------------------------------------------------
 
-// Mostra temperatura e umidade no display
-void imprimedisplay(float temp, float umid) {
+// Escreve temperatura e umidade nas páginas de texto do buffer (sem enviar).
+static void desenhar_texto(float temp, float umid) {
     int temp_int = (int)temp;
     int temp_frac = (int)((fabsf(temp) - abs(temp_int)) * 100 + 0.5f);
 
@@ -160,31 +245,327 @@ void imprimedisplay(float temp, float umid) {
     sprintf(temp_str, "Temp: %d.%02dC", temp_int, temp_frac);
     sprintf(umid_str,  "Umid: %d.%02d%%", umid_int, umid_frac);
 
-    limpar_display();
-    ssd1306_draw_string(ssd, 0, 8, temp_str);
-    ssd1306_draw_string(ssd, 0, 24, umid_str);
+    memset(ssd, 0, texto_area.buffer_length);
+    ssd1306_draw_string(ssd, 0, 0, temp_str);
+    ssd1306_draw_string(ssd, 0, 8, umid_str);
+}
+
+// Mostra temperatura e umidade no display: só as páginas de texto (256 bytes),
+// o gráfico é atualizado à parte, coluna a coluna.
+void imprimedisplay(float temp, float umid) {
+    desenhar_texto(temp, umid);
+    render_on_display(ssd, &texto_area);
+}
+
+// Valor x100 com sinal, como "-3.05"
+static void fmt_x100(char *s, size_t n, int v) {
+    snprintf(s, n, "%s%d.%02d", v < 0 ? "-" : "", abs(v) / 100, abs(v) % 100);
+}
+
+// Sensor fora das estatísticas (tabela cheia): avisa uma vez por sensor, não
+// a cada quadro. Os avisados ficam numa lista curta; cheia, não avisa mais.
+static void avisar_fora(uint8_t node, uint8_t sensor) {
+    static uint16_t avisados[ROLLSTATS_MAX_SENSORES];
+    static unsigned n_avisados;
+    uint16_t fonte = (uint16_t)(node << 8 | sensor);
+
+    for (unsigned i = 0; i < n_avisados; i++)
+        if (avisados[i] == fonte) return;
+    if (n_avisados == ROLLSTATS_MAX_SENSORES) return;
+    avisados[n_avisados++] = fonte;
+    printf("No %u.%u fora das estatisticas (maximo de %d sensores)\n", node, sensor,
+           ROLLSTATS_MAX_SENSORES);
+}
+
+// Janela do sensor: média, mínimo/máximo e desvio de cada grandeza (16 colunas).
+static void imprime_janela(uint8_t node, uint8_t sensor, rs_janela_t janela) {
+    static const char letra[RS_NUM_GRANDEZAS] = { 'T', 'U' };
+    uint64_t agora_ms = time_us_64() / 1000;
+    char linha[40], a[16], b[16];
+    rs_resultado_t r;
+
+    memset(ssd, 0, ssd1306_buffer_length);
+    for (unsigned g = 0; g < RS_NUM_GRANDEZAS; g++) {
+        int y = 16 + 24 * g;
+        if (!rollstats_get(node, sensor, janela, (rs_grandeza_t)g, agora_ms, &r)) {
+            snprintf(linha, sizeof(linha), "%c sem dados", letra[g]);
+            ssd1306_draw_string(ssd, 0, y, linha);
+            continue;
+        }
+        if (g == 0) {
+            snprintf(linha, sizeof(linha), "No %u.%u %s n%lu", node, sensor, rollstats_nome(janela), (unsigned long)r.n);
+            ssd1306_draw_string(ssd, 0, 0, linha);
+        }
+        fmt_x100(a, sizeof(a), (int)lroundf(r.media));
+        snprintf(linha, sizeof(linha), "%c med %s", letra[g], a);
+        ssd1306_draw_string(ssd, 0, y, linha);
+        fmt_x100(a, sizeof(a), r.min);
+        fmt_x100(b, sizeof(b), r.max);
+        snprintf(linha, sizeof(linha), " %s %s", a, b);
+        ssd1306_draw_string(ssd, 0, y + 8, linha);
+        fmt_x100(a, sizeof(a), (int)lroundf(r.desvio));
+        snprintf(linha, sizeof(linha), " desv %s", a);
+        ssd1306_draw_string(ssd, 0, y + 16, linha);
+    }
     render_on_display(ssd, &frame_area);
 }
 
+// 'completa': redesenha e envia o quadro inteiro (troca de página, primeira
+// amostra, faixa do gráfico mudou); senão a página 0 envia só o texto.
+static void mostrar_pagina(bool completa) {
+    if (pagina != 0) {
+        imprime_janela(ultimo_no, ultimo_sensor, (rs_janela_t)(pagina - 1));
+    } else if (completa) {
+        memset(ssd, 0, ssd1306_buffer_length);
+        oled_graph_render(&grafico, ssd);
+        desenhar_texto(ultima.temperatura / 100.0f, ultima.umidade / 100.0f);
+        render_on_display(ssd, &frame_area);
+    } else {
+        imprimedisplay(ultima.temperatura / 100.0f, ultima.umidade / 100.0f);
+    }
+}
+
+// Borda de descida do botão A, com 50 ms de debounce.
+static void botao_service(void) {
+    static bool antes = true;
+    static absolute_time_t ultima_borda;
+    bool agora = gpio_get(BOTAO_A);
+
+    if (agora == antes) return;
+    if (absolute_time_diff_us(ultima_borda, get_absolute_time()) < 50 * 1000) return;
+    antes = agora;
+    ultima_borda = get_absolute_time();
+    if (agora) return;
+
+    pagina = (uint8_t)((pagina + 1) % (1 + RS_NUM_JANELAS));
+    if (!start) mostrar_pagina(true);
+}
+
+// ----------------------------------------------------------
+
+// Quadros de amostra do nó FPGA, lidos direto do buffer do pool:
+//   4 bytes: int16 LE de temperatura e umidade (x100), sem id;
+//   7 bytes: FRAME_TYPE_SAMPLE, node_id, sensor (barramento AHT10 do nó) e
+//            os mesmos dois int16;
+//  15 bytes: FRAME_TYPE_TRACE, como o de 7 bytes mais os tempos medidos no nó
+//            (uint32 LE: amostra -> início do TX e duração do TX anterior).
+// As versões de 6 e 14 bytes, sem o byte do sensor, são do sensor 0.
+// Os quadros cifrados chegam aqui já decifrados por abrir_quadro().
+typedef struct {
+    bool     ok;
+    uint32_t age_us;
+    uint32_t prev_tx_us;    // 0 = primeiro TX do rádio
+} rastreio_t;
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool parse_amostra(const uint8_t *p, uint8_t len, aht10 *out, uint8_t *node, uint8_t *sensor,
+                          rastreio_t *tr) {
+    tr->ok  = false;
+    *sensor = 0;
+    if ((len == FRAME_TRACE_LEN || len == FRAME_TRACE_LEN - 1) && p[0] == FRAME_TYPE_TRACE) {
+        unsigned h = len - 12;              // Cabeçalho: tipo, nó e sensor (se houver)
+        *node = p[1];
+        if (h == 3) *sensor = p[2];
+        tr->ok = true;
+        tr->age_us     = get_u32(&p[h + 4]);
+        tr->prev_tx_us = get_u32(&p[h + 8]);
+        p += h;
+    } else if ((len == FRAME_SAMPLE_LEN || len == FRAME_SAMPLE_LEN - 1) && p[0] == FRAME_TYPE_SAMPLE) {
+        *node = p[1];
+        if (len == FRAME_SAMPLE_LEN) *sensor = p[2];
+        p += len - 4;
+    } else if (len == 4) {
+        *node = 0;
+    } else {
+        return false;
+    }
+    out->temperatura = (int16_t)(p[0] | (p[1] << 8));
+    out->umidade     = (int16_t)(p[2] | (p[3] << 8));
+    return true;
+}
+
+// Quadro cifrado: confere o tag e a sequência e decifra em 'claro'; o id do
+// nó passa a ser o autenticado. Os demais passam direto, menos os com o id de
+// um nó que já mandou quadros cifrados (cifra_claro()).
+static bool abrir_quadro(const lora_packet_t *pkt, uint8_t *claro, const uint8_t **dados,
+                         uint8_t *len, int *no_cifra) {
+    *dados    = pkt->data;
+    *len      = (uint8_t)pkt->len;
+    *no_cifra = -1;
+    if (pkt->len > 0 && pkt->data[0] == CIFRA_FRAME_TYPE) {
+        uint8_t no;
+        cifra_status_t st = cifra_abrir(pkt->data, (uint8_t)pkt->len, claro, len, &no);
+        if (st != CIFRA_OK) {
+            printf("Quadro cifrado recusado: %s\n", cifra_nome(st));
+            return false;
+        }
+        *dados    = claro;
+        *no_cifra = no;
+        return true;
+    }
+    if (pkt->len >= 2 && (pkt->data[0] == FRAME_TYPE_SAMPLE || pkt->data[0] == FRAME_TYPE_TRACE) &&
+        cifra_claro(pkt->data[1]) != CIFRA_OK) {
+        printf("Quadro sem cifra do no %u recusado\n", pkt->data[1]);
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------
+
+#if TDMA_BEACON
+// Transmite o beacon e volta ao RX. O TX bloqueia pelo airtime do beacon,
+// que ocupa o slot 0 do superquadro: nenhum nó transmite nesse intervalo.
+static void enviar_beacon(uint8_t seq) {
+    uint8_t buf[5 + TDMA_NUM_SLOTS];
+
+    buf[0] = FRAME_TYPE_BEACON;
+    buf[1] = seq;
+    buf[2] = (uint8_t)(TDMA_SLOT_MS & 0xFF);
+    buf[3] = (uint8_t)(TDMA_SLOT_MS >> 8);
+    buf[4] = TDMA_NUM_SLOTS;
+    memcpy(&buf[5], tdma_slots, TDMA_NUM_SLOTS);
+
+    if (!lora_send_bytes(buf, sizeof(buf)))
+        printf("Beacon %u: timeout de TX\n", seq);
+    lora_start_rx_continuous();
+}
+#endif
+
+// ----------------------------------------------------------
+
+// Comandos pela USB, lidos sem bloquear (uma linha por vez):
+//   dump [n]  exporta em CSV os n setores mais recentes do flashlog (padrão: todos)
+//   stats     contadores do flashlog
+//   lat       p50/p99 de cada etapa do sensor ao display ('lat reset' zera)
+//   janelas   mín/máx/média/desvio de 1 min, 1 h e 24 h de cada nó
+//   cifra     quadros cifrados aceitos/recusados e última sequência por nó
+static void console_service(void) {
+    static char linha[32];
+    static unsigned n;
+    int c;
+
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c != '\r' && c != '\n') {
+            if (n < sizeof(linha) - 1) linha[n++] = (char)c;
+            continue;
+        }
+        linha[n] = '\0';
+        if (n == 0) continue;
+        n = 0;
+
+        if (strncmp(linha, "dump", 4) == 0) {
+            // Grava o setor parcial para a exportação sair completa.
+            flashlog_commit();
+            flashlog_export((unsigned)strtoul(linha + 4, NULL, 10));
+        } else if (strcmp(linha, "stats") == 0) {
+            flashlog_stats();
+        } else if (strcmp(linha, "lat") == 0) {
+            lat_report();
+        } else if (strcmp(linha, "lat reset") == 0) {
+            lat_reset();
+        } else if (strcmp(linha, "janelas") == 0) {
+            rollstats_report(time_us_64() / 1000);
+        } else if (strcmp(linha, "cifra") == 0) {
+            cifra_report();
+        } else {
+            printf("Comandos: dump [n], stats, lat, lat reset, janelas, cifra\n");
+        }
+    }
+}
+
 // ----------------------------------------------------------
 
 int main() {
     aht10 recebido;
+    uint8_t no, sensor;
+    rastreio_t tr;
+    uint8_t claro[LORA_PACKET_SIZE];
+    const uint8_t *dados;
+    uint8_t len;
+    int no_cifra;
+#if TDMA_BEACON
+    uint8_t beacon_seq = 0;
+    absolute_time_t proximo_beacon;
+#endif
 
     iniciar();
     aguardar();
+#if TDMA_BEACON
+    proximo_beacon = get_absolute_time();
+#endif
 
     while (true) {
-        int len = lora_receive_bytes((uint8_t *)&recebido, sizeof(recebido));
-        if (len == sizeof(recebido)) {
+#if TDMA_BEACON
+        if (time_reached(proximo_beacon)) {
+            // Agenda pelo instante previsto, não pelo atual: o período não acumula atraso.
+            proximo_beacon = delayed_by_ms(proximo_beacon, (TDMA_NUM_SLOTS + 1) * TDMA_SLOT_MS);
+            enviar_beacon(beacon_seq++);
+        }
+#endif
+        lora_packet_t *pkt = lora_receive_packet();
+        if (!pkt) {
+            // Flash e console só com o laço ocioso: o quadro seguinte espera no FIFO.
+            flashlog_service();
+            cifra_service();
+            console_service();
+            botao_service();
+            if (start && animar) {
+                animar = false;
+                desenhar_aguardando();
+            }
+            continue;
+        }
+
+#if RX_VERBOSE
+        printf("RX %u bytes, RSSI %d dBm\n", pkt->len, pkt->rssi);
+#endif
+        flashlog_append(pkt->data, pkt->len, pkt->rssi);
+        if (abrir_quadro(pkt, claro, &dados, &len, &no_cifra) &&
+            parse_amostra(dados, len, &recebido, &no, &sensor, &tr)) {
+            if (no_cifra >= 0) no = (uint8_t)no_cifra;
+            if (!rollstats_add(no, sensor, recebido.temperatura, recebido.umidade, time_us_64() / 1000))
+                avisar_fora(no, sensor);
+            uint64_t t_decod = time_us_64();
+
+            bool completa = false;
             if (start) {
                 cancel_repeating_timer(&timer);
-                limpar_display();
                 start = false;
+                completa = true;
+            }
+            ultima        = recebido;
+            ultimo_no     = no;
+            ultimo_sensor = sensor;
+            int fonte = no << 8 | sensor;
+            if (grafico_fonte < 0) grafico_fonte = fonte;
+            if (fonte == grafico_fonte)
+                completa |= oled_graph_push(&grafico, recebido.temperatura, ssd,
+                                            pagina == 0 && !completa);
+            mostrar_pagina(completa);
+            uint64_t t_oled = time_us_64();
+
+            lat_record(LAT_IRQ_FIFO, (uint32_t)(pkt->t_fetch_us - pkt->t_irq_us));
+            lat_record(LAT_DECODE,   (uint32_t)(t_decod - pkt->t_fetch_us));
+            lat_record(LAT_DISPLAY,  (uint32_t)(t_oled - t_decod));
+            lat_record(LAT_RECEIVER, (uint32_t)(t_oled - pkt->t_irq_us));
+            if (tr.ok) {
+                // O airtime do quadro atual é o teórico: o nó só mede o TX depois do TxDone.
+                lat_record(LAT_NODE_QUEUE, tr.age_us);
+                if (tr.prev_tx_us) lat_record(LAT_NODE_AIRTIME, tr.prev_tx_us);
+                lat_record(LAT_END_TO_END, tr.age_us + lora_airtime_us(pkt->len, pkt->len == LORA_IMPLICIT_LEN) +
+                                           (uint32_t)(t_oled - pkt->t_irq_us));
             }
-            imprimedisplay(recebido.temperatura / 100.0f, recebido.umidade / 100.0f);
+#if RX_VERBOSE
+            // Fora das medidas: o printf na USB não conta como decodificação nem display.
+            if (no || sensor) printf("No %u.%u: %d / %d\n", no, sensor, recebido.temperatura, recebido.umidade);
+#endif
         }
+        lora_packet_release(pkt);
     }
 
     return 0;
-}
\ No newline at end of file
+}
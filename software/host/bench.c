@@ -0,0 +1,338 @@
+// Microbenchmarks do receptor no host: decodificação de quadros (SPI do
+// SX1276 emulado + pool + parse_amostra), bytes por atualização do display,
+// ns por glifo, bytes por ponto do gráfico, custo das estatísticas em janela
+// e dos quadros cifrados. O programa do receptor entra inteiro (com as funções
+// static) e o main() dele vira receptor_main().
+//
+// Uso: bench [quadros.txt]
+//   quadros.txt: um quadro em hex por linha, ou o CSV do 'dump' do flashlog
+//   (a última coluna é usada). Sem arquivo, usa um conjunto sintético de
+//   quadros de 4, 6 e 14 bytes.
+
+#define main receptor_main
+#include "../Tarefa-FPGA-bitdog-05.c"
+#undef main
+
+#include <ctype.h>
+#include <time.h>
+#include "host_sim.h"
+#include "aes.h"
+
+#define MAX_QUADROS     4096
+#define ITER_DECODE     200000
+#define ITER_DISPLAY    2000
+#define ITER_GLIFO      200000
+#define ITER_JANELAS    1000000
+#define PONTOS_GRAFICO  1000
+#define ITER_CIFRA      100000
+
+typedef struct {
+    uint8_t data[255];
+    uint8_t len;
+    int16_t rssi;
+} quadro_t;
+
+static quadro_t quadros[MAX_QUADROS];
+static unsigned n_quadros;
+
+static uint64_t agora_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int hex_val(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c = tolower(c);
+    return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+// Última coluna da linha, em hex; linhas que não são hex (cabeçalho) ficam de fora.
+static bool ler_linha(const char *linha, quadro_t *q) {
+    const char *p = strrchr(linha, ',');
+    p = p ? p + 1 : linha;
+    while (isspace((unsigned char)*p)) p++;
+
+    q->len  = 0;
+    q->rssi = -80;
+    while (hex_val(p[0]) >= 0 && hex_val(p[1]) >= 0 && q->len < sizeof(q->data)) {
+        q->data[q->len++] = (uint8_t)(hex_val(p[0]) << 4 | hex_val(p[1]));
+        p += 2;
+    }
+    return q->len > 0 && (*p == '\0' || isspace((unsigned char)*p));
+}
+
+static void carregar_arquivo(const char *caminho) {
+    char linha[1024];
+    FILE *f = fopen(caminho, "r");
+
+    if (!f) {
+        perror(caminho);
+        exit(1);
+    }
+    while (n_quadros < MAX_QUADROS && fgets(linha, sizeof(linha), f))
+        if (ler_linha(linha, &quadros[n_quadros])) n_quadros++;
+    fclose(f);
+}
+
+static void put_i16(uint8_t *p, int16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)((uint16_t)v >> 8);
+}
+
+static void carregar_sinteticos(void) {
+    for (unsigned i = 0; i < 64; i++) {
+        quadro_t *q = &quadros[n_quadros++];
+        int16_t t = (int16_t)(2000 + i * 7), h = (int16_t)(5500 - i * 11);
+        uint8_t *p = q->data;
+
+        q->rssi = (int16_t)(-60 - (int)(i % 40));
+        switch (i % 3) {
+        case 0:
+            put_i16(&p[0], t); put_i16(&p[2], h);
+            q->len = 4;
+            break;
+        case 1:
+            p[0] = FRAME_TYPE_SAMPLE; p[1] = (uint8_t)(1 + i % 4); p[2] = (uint8_t)(i % 2);
+            put_i16(&p[3], t); put_i16(&p[5], h);
+            q->len = 7;
+            break;
+        default:
+            p[0] = FRAME_TYPE_TRACE; p[1] = (uint8_t)(1 + i % 4); p[2] = (uint8_t)(i % 2);
+            put_i16(&p[3], t); put_i16(&p[5], h);
+            memset(&p[7], 0, 8);
+            q->len = 15;
+            break;
+        }
+    }
+}
+
+// ----------------------------------------------------------
+
+static void bench_decode(void) {
+    aht10 a;
+    uint8_t no, sensor;
+    rastreio_t tr;
+    unsigned validos = 0;
+    uint64_t spi0_bytes = host_radio_spi_bytes();
+
+    uint64_t t0 = agora_ns();
+    for (unsigned i = 0; i < ITER_DECODE; i++) {
+        const quadro_t *q = &quadros[i % n_quadros];
+        host_radio_rx(q->data, q->len, q->rssi);
+        lora_packet_t *pkt = lora_receive_packet();
+        if (!pkt) continue;
+        if (parse_amostra(pkt->data, (uint8_t)pkt->len, &a, &no, &sensor, &tr)) validos++;
+        lora_packet_release(pkt);
+    }
+    uint64_t dt = agora_ns() - t0;
+
+    printf("Decodificacao (IRQ + FIFO + pool + parse): %.0f quadros/s, %.0f ns/quadro\n",
+           ITER_DECODE * 1e9 / dt, (double)dt / ITER_DECODE);
+    printf("  %u de %u quadros com amostra, %.1f bytes de SPI por quadro\n",
+           validos, ITER_DECODE, (double)(host_radio_spi_bytes() - spi0_bytes) / ITER_DECODE);
+
+    // Só o parse, sobre um pacote já no pool.
+    lora_packet_t pkt = { 0 };
+    t0 = agora_ns();
+    validos = 0;
+    for (unsigned i = 0; i < ITER_DECODE; i++) {
+        const quadro_t *q = &quadros[i % n_quadros];
+        memcpy(pkt.data, q->data, q->len);
+        pkt.len = q->len;
+        if (parse_amostra(pkt.data, (uint8_t)pkt.len, &a, &no, &sensor, &tr)) validos++;
+    }
+    dt = agora_ns() - t0;
+    printf("Somente parse_amostra: %.0f quadros/s (%u validos)\n", ITER_DECODE * 1e9 / dt, validos);
+}
+
+static void bench_display(void) {
+    host_i2c_reset_stats();
+
+    uint64_t t0 = agora_ns();
+    for (unsigned i = 0; i < ITER_DISPLAY; i++)
+        imprimedisplay((2000 + (int)(i % 500)) / 100.0f, (5000 - (int)(i % 300)) / 100.0f);
+    uint64_t dt = agora_ns() - t0;
+
+    host_i2c_stats_t s = host_i2c_stats();
+    double bytes = (double)s.bytes / ITER_DISPLAY;
+    // No fio: cada transação leva ainda o byte de endereço; 9 bits por byte (ACK).
+    double fio_us = ((double)s.bytes + s.writes) / ITER_DISPLAY * 9 / 400e3 * 1e6;
+
+    printf("Display (imprimedisplay): %.0f bytes I2C por atualizacao (%.0f de GDDRAM, %.0f de comando), "
+           "%.1f transacoes\n", bytes, (double)s.data_bytes / ITER_DISPLAY,
+           (double)s.cmd_bytes / ITER_DISPLAY, (double)s.writes / ITER_DISPLAY);
+    printf("  %.0f ns de CPU no host por atualizacao; ~%.0f us no barramento a 400 kHz\n",
+           (double)dt / ITER_DISPLAY, fio_us);
+    printf("  GDDRAM capturada %s o buffer do receptor\n",
+           memcmp(host_oled_gddram(), ssd, sizeof(ssd)) == 0 ? "confere com" : "DIFERE d");
+}
+
+static void bench_glifo(void) {
+    static uint8_t buf[ssd1306_buffer_length];
+    char texto[] = "Temp: 23.45C";
+    size_t n = strlen(texto);
+
+    uint64_t t0 = agora_ns();
+    for (unsigned i = 0; i < ITER_GLIFO; i++)
+        ssd1306_draw_string(buf, 0, (int16_t)(8 * (i % 8)), texto);
+    uint64_t dt = agora_ns() - t0;
+
+    printf("Glifos (ssd1306_draw_string): %.1f ns por glifo\n", (double)dt / ((double)ITER_GLIFO * n));
+}
+
+// Pontos do gráfico com a página 0 visível, como no laço do receptor.
+static void bench_grafico(void) {
+    mostrar_pagina(true);
+    host_i2c_reset_stats();
+
+    uint64_t t0 = agora_ns();
+    for (unsigned i = 0; i < PONTOS_GRAFICO; i++) {
+        // Senoide grosseira de 20 a 30 C, sem sair da faixa inicial.
+        int fase = (int)(i % 64) - 32;
+        int16_t t = (int16_t)(2500 + (32 * 32 - fase * fase) * 500 / (32 * 32) * (i % 128 < 64 ? 1 : -1));
+        oled_graph_push(&grafico, t, ssd, true);
+    }
+    uint64_t dt = agora_ns() - t0;
+
+    host_i2c_stats_t s = host_i2c_stats();
+    printf("Grafico (%s): %.1f bytes I2C por ponto em %.1f transacoes, %.0f ns de CPU por ponto\n",
+           OLED_GRAPH_CONTENT_SCROLL ? "content scroll 2Dh" : "varredura",
+           (double)s.bytes / PONTOS_GRAFICO, (double)s.writes / PONTOS_GRAFICO,
+           (double)dt / PONTOS_GRAFICO);
+    printf("  GDDRAM capturada %s o buffer do receptor\n",
+           memcmp(host_oled_gddram(), ssd, sizeof(ssd)) == 0 ? "confere com" : "DIFERE d");
+
+    // O redesenho completo tem que dar o mesmo gráfico que os passos incrementais.
+    static uint8_t ref[ssd1306_buffer_length];
+    memcpy(ref, ssd, sizeof(ref));
+    oled_graph_render(&grafico, ref);
+    printf("  Redesenho completo %s os passos incrementais\n",
+           memcmp(ref, ssd, sizeof(ref)) == 0 ? "confere com" : "DIFERE d");
+}
+
+// Uma amostra a cada 2 s, em rodízio por ROLLSTATS_MAX_SENSORES sensores: as três
+// janelas andam e expiram baldes o tempo todo.
+static void bench_janelas(void) {
+    uint64_t t0 = agora_ns();
+    for (unsigned i = 0; i < ITER_JANELAS; i++)
+        rollstats_add((uint8_t)(1 + i % ROLLSTATS_MAX_SENSORES), 0, (int16_t)(2000 + i % 777),
+                      (int16_t)(6000 - i % 555), 1000 + (uint64_t)i * 2000);
+    uint64_t dt = agora_ns() - t0;
+
+    printf("Estatisticas (rollstats_add, 3 janelas x 2 grandezas): %.1f ns por amostra\n",
+           (double)dt / ITER_JANELAS);
+}
+
+// Lado do nó (frame_seal() em hardware/firmware/lib/frame.c), para gerar
+// quadros cifrados com sequências novas.
+static const uint8_t chave_bench[16] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+};
+
+static uint8_t selar(uint8_t *buf, const uint8_t *interno, uint8_t n, uint8_t node, uint32_t seq) {
+    static aes_key_t enc, mac;
+    static bool derivadas = false;
+    uint8_t ctr[AES_BLOCK_LEN] = {0}, tag[AES_BLOCK_LEN];
+
+    if (!derivadas) {
+        aes_key_t mestra;
+        uint8_t blk[AES_BLOCK_LEN] = {0}, sub[AES_KEY_LEN];
+        aes_set_key(&mestra, chave_bench);
+        blk[0] = 0x01; aes_encrypt_block(&mestra, blk, sub); aes_set_key(&enc, sub);
+        blk[0] = 0x02; aes_encrypt_block(&mestra, blk, sub); aes_set_key(&mac, sub);
+        derivadas = true;
+    }
+    buf[0] = CIFRA_FRAME_TYPE;
+    buf[1] = node;
+    for (unsigned i = 0; i < 4; i++) buf[2 + i] = (uint8_t)(seq >> (8 * i));
+    memcpy(&buf[CIFRA_HDR_LEN], interno, n);
+    ctr[0] = 0x01; ctr[1] = node; memcpy(&ctr[2], &buf[2], 4); ctr[15] = 1;
+    aes_ctr(&enc, ctr, &buf[CIFRA_HDR_LEN], n);
+    aes_cmac(&mac, buf, CIFRA_HDR_LEN + n, tag);
+    memcpy(&buf[CIFRA_HDR_LEN + n], tag, CIFRA_TAG_LEN);
+    return (uint8_t)(n + CIFRA_OVERHEAD);
+}
+
+static void bench_cifra(void) {
+    // Quadro de rastreio cifrado pelo firmware do nó (chave_bench, nó 7,
+    // sensor 2, época 3, quadro 1): 25,12 C, 60,34 %, 1234 us de fila, TX
+    // anterior de 56789 us.
+    static const uint8_t do_no[] = {
+        0x45, 0x07, 0x01, 0x00, 0x03, 0x00, 0xb4, 0x12, 0x05, 0xb7, 0x17, 0x86,
+        0x62, 0x09, 0x9f, 0x4e, 0xb2, 0x38, 0x90, 0xaf, 0x0e, 0xf3, 0x64, 0x3f,
+        0xab,
+    };
+    uint8_t claro[LORA_PACKET_SIZE], buf[64], len, no;
+    aht10 a;
+    uint8_t no_interno, sensor;
+    rastreio_t tr;
+
+    cifra_init(chave_bench);
+    cifra_status_t st = cifra_abrir(do_no, sizeof(do_no), claro, &len, &no);
+    bool confere = st == CIFRA_OK && parse_amostra(claro, len, &a, &no_interno, &sensor, &tr) &&
+                   no == 7 && sensor == 2 && a.temperatura == 2512 && a.umidade == 6034 &&
+                   tr.ok && tr.age_us == 1234 && tr.prev_tx_us == 56789;
+    printf("Quadro cifrado do firmware: %s\n", confere ? "confere" : "DIFERE");
+    printf("  Repetido: %s\n", cifra_nome(cifra_abrir(do_no, sizeof(do_no), claro, &len, &no)));
+    cifra_init(chave_bench);    // Reset: os limites voltam da flash
+    printf("  Repetido apos reset: %s\n", cifra_nome(cifra_abrir(do_no, sizeof(do_no), claro, &len, &no)));
+
+    // Um bit trocado no texto cifrado tem que derrubar o tag.
+    memcpy(buf, do_no, sizeof(do_no));
+    buf[8] ^= 0x01;
+    buf[3]  = 0x7F;     // seq nova: a recusa tem que vir do tag, não do replay
+    printf("  Alterado: %s\n", cifra_nome(cifra_abrir(buf, sizeof(do_no), claro, &len, &no)));
+
+    // Sem cifra, com o id do nó 7 (já mandou cifrados): tem que ser recusado.
+    lora_packet_t claro_7 = { .len = 6, .data = { FRAME_TYPE_SAMPLE, 7, 0xD0, 0x09, 0x94, 0x17 } };
+    const uint8_t *dados;
+    int no_cifra;
+    printf("  Sem cifra do mesmo no: %s\n",
+           abrir_quadro(&claro_7, claro, &dados, &len, &no_cifra) ? "aceito" : "recusado");
+
+    // Verificação + decifragem por quadro (15 bytes internos = 2 blocos de CMAC + 1 de CTR).
+    static uint8_t selados[256][32];
+    uint8_t interno[15] = { FRAME_TYPE_TRACE, 9 };
+    uint8_t tam = 0;
+    unsigned aceitos = 0;
+    uint64_t t_total = 0;
+    for (unsigned base = 0; base < ITER_CIFRA; base += 256) {
+        for (unsigned i = 0; i < 256; i++)
+            tam = selar(selados[i], interno, sizeof(interno), 9, 0x10000u + base + i);
+        uint64_t t0 = agora_ns();
+        for (unsigned i = 0; i < 256; i++)
+            aceitos += cifra_abrir(selados[i], tam, claro, &len, &no) == CIFRA_OK;
+        t_total += agora_ns() - t0;
+        cifra_service();        // Laço ocioso do receptor: compactação fora do tempo medido
+    }
+    unsigned n = (ITER_CIFRA + 255) / 256 * 256;
+    printf("Quadros cifrados (CMAC + CTR + replay): %.0f ns por quadro de %u bytes (%u de %u aceitos)\n",
+           (double)t_total / n, tam, aceitos, n);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) carregar_arquivo(argv[1]);
+    else          carregar_sinteticos();
+    if (n_quadros == 0) {
+        fprintf(stderr, "Nenhum quadro em %s\n", argv[1]);
+        return 1;
+    }
+    printf("%u quadros %s\n", n_quadros, argc > 1 ? "gravados" : "sinteticos");
+
+    iniciar_radio();
+    iniciar_display();
+    start = false;      // Como depois da primeira amostra: página 0 com gráfico
+    if (!lora_ok) {
+        fprintf(stderr, "SX1276 emulado nao respondeu\n");
+        return 1;
+    }
+
+    bench_decode();
+    bench_display();
+    bench_glifo();
+    bench_grafico();
+    bench_janelas();
+    bench_cifra();
+    return 0;
+}
@@ -0,0 +1,16 @@
+#ifndef HOST_HARDWARE_SPI_H
+#define HOST_HARDWARE_SPI_H
+
+#include "pico/stdlib.h"
+
+// O spi0 do host fala com um SX1276 emulado (host_sim.h).
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t *const spi0;
+extern spi_inst_t *const spi1;
+
+uint spi_init(spi_inst_t *spi, uint baudrate);
+int  spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int  spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+int  spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len);
+
+#endif
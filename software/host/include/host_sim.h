@@ -0,0 +1,39 @@
+#ifndef HOST_SIM_H
+#define HOST_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Controle dos substitutos do pico-sdk no build de host (pico_host.c).
+//
+// SPI: um SX1276 emulado (registradores, FIFO de 256 bytes e flags de IRQ
+// com escrita de 1 para limpar). host_radio_rx() coloca um quadro no FIFO,
+// marca RxDone e chama o callback do DIO0 como o IRQ do GPIO faria.
+//
+// I2C: cada escrita para o SSD1306 é contada e interpretada (comandos de
+// endereço de coluna/página, scroll, start line) sobre uma cópia da GDDRAM,
+// para conferir o que de fato chegou ao display.
+
+// ---------------- Rádio ----------------
+void     host_radio_rx(const uint8_t *data, uint8_t len, int16_t rssi);
+uint32_t host_radio_tx_count(void);     // Quadros que entraram em MODE_TX
+uint64_t host_radio_spi_bytes(void);    // Bytes trocados pelo SPI
+
+// ---------------- Display ----------------
+#define HOST_OLED_WIDTH  128
+#define HOST_OLED_PAGES  8
+
+typedef struct {
+    uint32_t writes;        // Transações I2C
+    uint64_t bytes;         // Payload de todas as transações (sem o byte de endereço)
+    uint64_t data_bytes;    // Bytes gravados na GDDRAM
+    uint64_t cmd_bytes;     // Bytes de comando (inclui argumentos)
+} host_i2c_stats_t;
+
+host_i2c_stats_t host_i2c_stats(void);
+void             host_i2c_reset_stats(void);
+const uint8_t   *host_oled_gddram(void);    // HOST_OLED_PAGES x HOST_OLED_WIDTH
+bool             host_oled_scrolling(void);
+uint8_t          host_oled_start_line(void);
+
+#endif
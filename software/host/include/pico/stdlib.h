@@ -0,0 +1,59 @@
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+// Substituto mínimo do pico/stdlib.h para o build no Linux (software/host):
+// só o que o receptor usa. Implementação em pico_host.c.
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+
+#define _u(x) x ## u
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+
+#define PICO_OK             0
+#define PICO_ERROR_TIMEOUT  (-1)
+
+// ---------------- Tempo (us desde o início do processo) ----------------
+typedef uint64_t absolute_time_t;
+
+uint64_t time_us_64(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+static inline absolute_time_t get_absolute_time(void) { return time_us_64(); }
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return (uint32_t)(t / 1000); }
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + (uint64_t)ms * 1000; }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) { return (int64_t)(to - from); }
+static inline bool time_reached(absolute_time_t t) { return time_us_64() >= t; }
+static inline void tight_loop_contents(void) {}
+
+// Os timers não disparam no host: o callback é guardado e nunca chamado.
+struct repeating_timer {
+    int64_t delay_us;
+    bool  (*callback)(struct repeating_timer *);
+    void   *user_data;
+};
+typedef bool (*repeating_timer_callback_t)(struct repeating_timer *);
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback,
+                            void *user_data, struct repeating_timer *out);
+bool cancel_repeating_timer(struct repeating_timer *timer);
+
+// ---------------- stdio ----------------
+bool stdio_init_all(void);
+int  getchar_timeout_us(uint32_t timeout_us);
+
+// ---------------- Flash XIP (RAM no host) ----------------
+#define PICO_FLASH_SIZE_BYTES (2 * 1024 * 1024)
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)host_flash)
+
+#include "hardware/gpio.h"
+
+#endif
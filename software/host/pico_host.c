@@ -0,0 +1,398 @@
+// Substitutos do pico-sdk para o build de host: tempo, GPIO, SPI (SX1276
+// emulado), I2C (SSD1306 capturado), flash e stdio. Só o comportamento que o
+// receptor observa; nada de temporização de barramento.
+
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "host_sim.h"
+
+// ============================================
+// === Tempo ===
+// ============================================
+static uint64_t mono_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+uint64_t time_us_64(void) {
+    static uint64_t boot;
+    uint64_t now = mono_us();
+
+    if (!boot) boot = now - 1;
+    return now - boot;
+}
+
+void sleep_us(uint64_t us) {
+    struct timespec ts = { (time_t)(us / 1000000u), (long)(us % 1000000u) * 1000 };
+    nanosleep(&ts, NULL);
+}
+
+void sleep_ms(uint32_t ms) {
+    sleep_us((uint64_t)ms * 1000);
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback,
+                            void *user_data, struct repeating_timer *out) {
+    out->delay_us  = (int64_t)delay_ms * 1000;
+    out->callback  = callback;
+    out->user_data = user_data;
+    return true;
+}
+
+bool cancel_repeating_timer(struct repeating_timer *timer) {
+    timer->callback = NULL;
+    return true;
+}
+
+// ============================================
+// === stdio ===
+// ============================================
+bool stdio_init_all(void) {
+    return true;
+}
+
+// Sem console no host: nenhuma tecla chega.
+int getchar_timeout_us(uint32_t timeout_us) {
+    (void)timeout_us;
+    return PICO_ERROR_TIMEOUT;
+}
+
+// ============================================
+// === GPIO ===
+// ============================================
+#define NUM_GPIO 30
+
+static bool gpio_level[NUM_GPIO];
+static gpio_irq_callback_t gpio_callback;
+static uint32_t gpio_irq_mask[NUM_GPIO];
+
+static void radio_cs_high(void);
+
+void gpio_init(uint gpio)                          { (void)gpio; }
+void gpio_set_dir(uint gpio, bool out)             { (void)gpio; (void)out; }
+// Entrada com pull-up e nada ligado: lê 1 (botão solto).
+void gpio_pull_up(uint gpio) {
+    if (gpio < NUM_GPIO) gpio_level[gpio] = true;
+}
+void gpio_pull_down(uint gpio)                     { (void)gpio; }
+void gpio_set_function(uint gpio, enum gpio_function fn) { (void)gpio; (void)fn; }
+
+// O SX1276 só vê o fim da transação: qualquer saída em nível alto (CS, ou o
+// RESET fora de transação) encerra o comando em andamento.
+void gpio_put(uint gpio, bool value) {
+    if (gpio < NUM_GPIO) gpio_level[gpio] = value;
+    if (value) radio_cs_high();
+}
+
+bool gpio_get(uint gpio) {
+    return gpio < NUM_GPIO && gpio_level[gpio];
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled,
+                                        gpio_irq_callback_t callback) {
+    if (gpio < NUM_GPIO) gpio_irq_mask[gpio] = enabled ? events : 0;
+    gpio_callback = callback;
+}
+
+// Pulso no DIO0: o único GPIO com IRQ no receptor.
+static void dio0_pulse(void) {
+    for (uint gpio = 0; gpio < NUM_GPIO; gpio++) {
+        if ((gpio_irq_mask[gpio] & GPIO_IRQ_EDGE_RISE) && gpio_callback) {
+            gpio_callback(gpio, GPIO_IRQ_EDGE_RISE);
+            return;
+        }
+    }
+}
+
+// ============================================
+// === Interrupções e flash ===
+// ============================================
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+uint32_t save_and_disable_interrupts(void) {
+    return 1;
+}
+
+void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count) {
+    assert(flash_offs % FLASH_SECTOR_SIZE == 0 && count % FLASH_SECTOR_SIZE == 0);
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    memset(&host_flash[flash_offs], 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count) {
+    assert(flash_offs % FLASH_PAGE_SIZE == 0 && count % FLASH_PAGE_SIZE == 0);
+    assert(flash_offs + count <= PICO_FLASH_SIZE_BYTES);
+    for (size_t i = 0; i < count; i++) host_flash[flash_offs + i] &= data[i];
+}
+
+// ============================================
+// === SPI: SX1276 emulado ===
+// ============================================
+#define SX_REG_FIFO              0x00
+#define SX_REG_OP_MODE           0x01
+#define SX_REG_FIFO_ADDR_PTR     0x0D
+#define SX_REG_FIFO_RX_BASE_ADDR 0x0F
+#define SX_REG_FIFO_RX_CURRENT   0x10
+#define SX_REG_IRQ_FLAGS         0x12
+#define SX_REG_RX_NB_BYTES       0x13
+#define SX_REG_PKT_RSSI_VALUE    0x1A
+#define SX_REG_DIO_MAPPING_1     0x40
+#define SX_REG_VERSION           0x42
+
+#define SX_MODE_TX               0x03
+#define SX_IRQ_TX_DONE           0x08
+#define SX_IRQ_RX_DONE           0x40
+
+struct spi_inst { int unused; };
+static struct spi_inst spi_insts[2];
+spi_inst_t *const spi0 = &spi_insts[0];
+spi_inst_t *const spi1 = &spi_insts[1];
+
+static struct {
+    uint8_t  regs[128];
+    uint8_t  fifo[256];
+    bool     in_cmd;        // Byte de endereço já recebido
+    bool     write;
+    uint8_t  addr;
+    uint32_t tx_count;
+    uint64_t spi_bytes;
+} sx = { .regs = { [SX_REG_VERSION] = 0x12 } };
+
+static void radio_cs_high(void) {
+    sx.in_cmd = false;
+}
+
+static void sx_write_reg(uint8_t addr, uint8_t v) {
+    switch (addr) {
+    case SX_REG_IRQ_FLAGS:
+        sx.regs[addr] &= (uint8_t)~v;       // Escrita de 1 limpa
+        break;
+    case SX_REG_OP_MODE:
+        sx.regs[addr] = v;
+        // O TX termina na hora: TxDone e, com DIO0 = TxDone, o pulso.
+        if ((v & 0x07) == SX_MODE_TX) {
+            sx.tx_count++;
+            sx.regs[SX_REG_IRQ_FLAGS] |= SX_IRQ_TX_DONE;
+            if ((sx.regs[SX_REG_DIO_MAPPING_1] & 0xC0) == 0x40) dio0_pulse();
+        }
+        break;
+    case SX_REG_VERSION:
+        break;
+    default:
+        sx.regs[addr] = v;
+    }
+}
+
+static uint8_t sx_byte(uint8_t mosi) {
+    uint8_t miso = 0;
+
+    sx.spi_bytes++;
+    if (!sx.in_cmd) {
+        sx.in_cmd = true;
+        sx.write  = (mosi & 0x80) != 0;
+        sx.addr   = mosi & 0x7F;
+        return 0;
+    }
+
+    if (sx.addr == SX_REG_FIFO) {
+        // O FIFO não avança o endereço: avança o FIFO_ADDR_PTR.
+        uint8_t ptr = sx.regs[SX_REG_FIFO_ADDR_PTR]++;
+        if (sx.write) sx.fifo[ptr] = mosi;
+        else          miso = sx.fifo[ptr];
+        return miso;
+    }
+
+    if (sx.write) sx_write_reg(sx.addr, mosi);
+    else          miso = sx.regs[sx.addr];
+    sx.addr = (sx.addr + 1) & 0x7F;     // Rajada
+    return miso;
+}
+
+uint spi_init(spi_inst_t *spi, uint baudrate) {
+    (void)spi;
+    return baudrate;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) sx_byte(src[i]);
+    return (int)len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) dst[i] = sx_byte(repeated_tx_data);
+    return (int)len;
+}
+
+int spi_write_read_blocking(spi_inst_t *spi, const uint8_t *src, uint8_t *dst, size_t len) {
+    (void)spi;
+    for (size_t i = 0; i < len; i++) dst[i] = sx_byte(src[i]);
+    return (int)len;
+}
+
+void host_radio_rx(const uint8_t *data, uint8_t len, int16_t rssi) {
+    uint8_t base = sx.regs[SX_REG_FIFO_RX_BASE_ADDR];
+
+    for (unsigned i = 0; i < len; i++) sx.fifo[(uint8_t)(base + i)] = data[i];
+    sx.regs[SX_REG_FIFO_RX_CURRENT] = base;
+    sx.regs[SX_REG_RX_NB_BYTES]     = len;
+    sx.regs[SX_REG_PKT_RSSI_VALUE]  = (uint8_t)(rssi + 157);
+    sx.regs[SX_REG_IRQ_FLAGS]      |= SX_IRQ_RX_DONE;
+    if ((sx.regs[SX_REG_DIO_MAPPING_1] & 0xC0) == 0x00) dio0_pulse();
+}
+
+uint32_t host_radio_tx_count(void) {
+    return sx.tx_count;
+}
+
+uint64_t host_radio_spi_bytes(void) {
+    return sx.spi_bytes;
+}
+
+// ============================================
+// === I2C: SSD1306 capturado ===
+// ============================================
+struct i2c_inst { int unused; };
+static struct i2c_inst i2c_insts[2];
+i2c_inst_t *const i2c0 = &i2c_insts[0];
+i2c_inst_t *const i2c1 = &i2c_insts[1];
+
+static struct {
+    uint8_t gddram[HOST_OLED_PAGES][HOST_OLED_WIDTH];
+    uint8_t col_start, col_end, page_start, page_end;
+    uint8_t col, page;
+    uint8_t start_line;
+    bool    scrolling;
+    uint8_t cmd[8];         // Comando em andamento e seus argumentos
+    uint8_t cmd_len, cmd_need;
+    host_i2c_stats_t stats;
+} oled = { .col_end = HOST_OLED_WIDTH - 1, .page_end = HOST_OLED_PAGES - 1 };
+
+// Número de argumentos de cada comando do SSD1306.
+static uint8_t oled_cmd_args(uint8_t c) {
+    switch (c) {
+    case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+    case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+        return 1;
+    case 0x21: case 0x22: case 0xA3:
+        return 2;
+    case 0x29: case 0x2A:
+        return 5;
+    case 0x26: case 0x27: case 0x2C: case 0x2D:
+        return 6;
+    default:
+        return 0;
+    }
+}
+
+static void oled_exec(void) {
+    const uint8_t *c = oled.cmd;
+
+    switch (c[0]) {
+    case 0x21:
+        oled.col_start = oled.col = c[1] & 0x7F;
+        oled.col_end   = c[2] & 0x7F;
+        break;
+    case 0x22:
+        oled.page_start = oled.page = c[1] & 0x07;
+        oled.page_end   = c[2] & 0x07;
+        break;
+    case 0x2C: case 0x2D: {
+        // Content scroll: um passo de uma coluna nas páginas c[2]..c[4],
+        // colunas c[5]..c[6]; a coluna que entra fica apagada.
+        uint8_t x0 = c[5] & 0x7F, x1 = c[6] & 0x7F;
+        for (int p = c[2] & 0x07; p <= (c[4] & 0x07) && x0 < x1; p++) {
+            uint8_t *row = oled.gddram[p];
+            if (c[0] == 0x2D) {
+                memmove(&row[x0], &row[x0 + 1], x1 - x0);
+                row[x1] = 0;
+            } else {
+                memmove(&row[x0 + 1], &row[x0], x1 - x0);
+                row[x0] = 0;
+            }
+        }
+        break;
+    }
+    case 0x2E: oled.scrolling = false; break;
+    case 0x2F: oled.scrolling = true;  break;
+    default:
+        if (c[0] >= 0x40 && c[0] <= 0x7F) oled.start_line = c[0] & 0x3F;
+        break;
+    }
+}
+
+static void oled_command(uint8_t b) {
+    oled.stats.cmd_bytes++;
+    if (oled.cmd_len == 0) oled.cmd_need = oled_cmd_args(b);
+    oled.cmd[oled.cmd_len++] = b;
+    if (oled.cmd_len > oled.cmd_need) {
+        oled_exec();
+        oled.cmd_len = 0;
+    }
+}
+
+// Modo de endereçamento horizontal (o único que o driver usa).
+static void oled_data(uint8_t b) {
+    oled.stats.data_bytes++;
+    oled.gddram[oled.page][oled.col] = b;
+    if (oled.col++ < oled.col_end) return;
+    oled.col = oled.col_start;
+    oled.page = oled.page < oled.page_end ? oled.page + 1 : oled.page_start;
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate) {
+    (void)i2c;
+    return baudrate;
+}
+
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    (void)i2c; (void)nostop;
+    if (addr != 0x3C || len == 0) return (int)len;
+
+    oled.stats.writes++;
+    oled.stats.bytes += len;
+    // Byte de controle: Co (bit 7) = só um byte a seguir, D/C (bit 6) = dados.
+    for (size_t i = 1; i < len; i++) {
+        if (src[0] & 0x40) oled_data(src[i]);
+        else               oled_command(src[i]);
+        if (src[0] & 0x80) break;
+    }
+    return (int)len;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    (void)i2c; (void)addr; (void)nostop;
+    memset(dst, 0, len);
+    return (int)len;
+}
+
+host_i2c_stats_t host_i2c_stats(void) {
+    return oled.stats;
+}
+
+void host_i2c_reset_stats(void) {
+    memset(&oled.stats, 0, sizeof(oled.stats));
+}
+
+const uint8_t *host_oled_gddram(void) {
+    return &oled.gddram[0][0];
+}
+
+bool host_oled_scrolling(void) {
+    return oled.scrolling;
+}
+
+uint8_t host_oled_start_line(void) {
+    return oled.start_line;
+}
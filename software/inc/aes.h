@@ -0,0 +1,31 @@
+#ifndef AES_H_
+#define AES_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// AES-128 em software, orientado a bytes: cifragem de bloco, CTR e CMAC
+// (RFC 4493). É a mesma implementação do nó FPGA (hardware/firmware/lib/aes.c,
+// sem o core do gateware); o receptor só precisa da cifragem direta.
+
+#define AES_BLOCK_LEN 16
+#define AES_KEY_LEN   16
+
+typedef struct {
+    uint8_t rk[176];            // Chaves das 11 rodadas (rk[0..15] = chave)
+    uint8_t k1[AES_BLOCK_LEN];  // Subchaves do CMAC
+    uint8_t k2[AES_BLOCK_LEN];
+} aes_key_t;
+
+void aes_set_key(aes_key_t *k, const uint8_t key[AES_KEY_LEN]);
+
+// 'in' e 'out' podem ser o mesmo buffer.
+void aes_encrypt_block(const aes_key_t *k, const uint8_t in[AES_BLOCK_LEN], uint8_t out[AES_BLOCK_LEN]);
+
+// Aplica o fluxo de chave E(ctr), E(ctr + 1), ... sobre 'data' (cifra e
+// decifra). O contador é o último byte do bloco.
+void aes_ctr(const aes_key_t *k, uint8_t ctr[AES_BLOCK_LEN], uint8_t *data, size_t len);
+
+void aes_cmac(const aes_key_t *k, const uint8_t *data, size_t len, uint8_t tag[AES_BLOCK_LEN]);
+
+#endif
@@ -0,0 +1,291 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "cifra.h"
+#include "aes.h"
+#include "flashlog.h"
+
+static aes_key_t chave_enc;         // E_K(0x01 || 0^15)
+static aes_key_t chave_mac;         // E_K(0x02 || 0^15)
+static bool      com_chave = false;
+static uint32_t  ultimo_seq[256];   // 0 = nenhum quadro aceito do nó
+static uint32_t  contagem[CIFRA_NUM_STATUS];
+
+static uint32_t get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ----------------------------------------------------------
+// Limites de sequência na flash
+// ----------------------------------------------------------
+// Dois setores em alternância. Cada um tem um retrato da tabela (cabeçalho
+// com geração e CRC32) e um diário de entradas {nó, limite} gravadas uma a
+// uma, programando só a página da entrada (bits em 1 não mudam). Com o diário
+// cheio, a tabela vai inteira para o outro setor com a geração seguinte; o
+// cabeçalho é a última página gravada, então um corte no meio deixa valendo
+// o setor anterior. Entradas cortadas não passam na conferência e são puladas.
+// O erase do outro setor para no laço ocioso (cifra_service()): a compactação
+// é pedida com CIFRA_FOLGA entradas ainda livres, que seguem valendo no RX.
+#define CIFRA_MAGIC      0x41524943u     // "CIRA"
+#define CIFRA_OFFSET     (PICO_FLASH_SIZE_BYTES - FLASHLOG_SIZE - 2 * FLASH_SECTOR_SIZE)
+#define CIFRA_TAB_BYTES  (16 + 256 * 4)
+#define CIFRA_ENTRADAS   ((FLASH_SECTOR_SIZE - CIFRA_TAB_BYTES) / sizeof(cifra_entrada_t))
+#define CIFRA_FOLGA      32
+
+typedef struct {
+    uint32_t limite;
+    uint8_t  no;
+    uint8_t  no_inv;        // ~no
+    uint16_t confere;       // ~(limite + limite >> 16 + no)
+} cifra_entrada_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t geracao;
+    uint32_t crc;           // crc32 de 'limite'
+    uint32_t reservado;
+    uint32_t limite[256];
+} cifra_tabela_t;
+
+typedef struct {
+    cifra_tabela_t  tab;
+    cifra_entrada_t ent[CIFRA_ENTRADAS];
+} cifra_setor_t;
+
+_Static_assert(sizeof(cifra_entrada_t) == 8, "entrada do diario");
+_Static_assert(sizeof(cifra_tabela_t) == CIFRA_TAB_BYTES, "tabela da cifra");
+_Static_assert(sizeof(cifra_setor_t) <= FLASH_SECTOR_SIZE, "setor da cifra");
+_Static_assert(CIFRA_TAB_BYTES % 8 == 0, "diario alinhado");
+
+static uint32_t limite[256];        // Gravado na flash: aceitos <= limite
+static unsigned setor_ativo;        // 0 ou 1
+static uint32_t geracao;
+static unsigned n_entradas;         // Próxima entrada livre do diário
+static uint32_t gravacoes;
+static bool     compactar_pendente;
+static uint32_t compactacoes_rx;    // Diário cheio antes do laço ocioso: erase no RX
+
+static uint32_t crc32(const uint8_t *p, size_t n) {
+    uint32_t crc = 0xFFFFFFFFu;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static inline uint32_t setor_offset(unsigned s) {
+    return CIFRA_OFFSET + s * FLASH_SECTOR_SIZE;
+}
+
+static inline const cifra_setor_t *setor_xip(unsigned s) {
+    return (const cifra_setor_t *)(uintptr_t)(XIP_BASE + setor_offset(s));
+}
+
+static bool setor_valido(const cifra_setor_t *setor) {
+    const cifra_tabela_t *s = &setor->tab;
+    return s->magic == CIFRA_MAGIC &&
+           s->crc == crc32((const uint8_t *)s->limite, sizeof(s->limite));
+}
+
+static uint16_t confere_entrada(uint32_t lim, uint8_t no) {
+    return (uint16_t)~(lim + (lim >> 16) + no);
+}
+
+static bool entrada_valida(const cifra_entrada_t *e) {
+    return (uint8_t)(e->no ^ e->no_inv) == 0xFF && e->confere == confere_entrada(e->limite, e->no);
+}
+
+static bool entrada_livre(const cifra_entrada_t *e) {
+    static const uint8_t livre[sizeof(cifra_entrada_t)] = {
+        0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    };
+    return memcmp(e, livre, sizeof(livre)) == 0;
+}
+
+static void programar(uint32_t offset, const uint8_t *pagina, size_t len) {
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_program(offset, pagina, len);
+    restore_interrupts(ints);
+}
+
+// Retrato da tabela no outro setor; o cabeçalho (página 0) por último.
+static void compactar(void) {
+    static union {
+        cifra_tabela_t tab;
+        uint8_t        b[(CIFRA_TAB_BYTES + FLASH_PAGE_SIZE - 1) / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE];
+    } paginas;
+    cifra_tabela_t *s = &paginas.tab;
+    unsigned destino = setor_ativo ^ 1;
+
+    memset(paginas.b, 0xFF, sizeof(paginas.b));
+    s->magic     = CIFRA_MAGIC;
+    s->geracao   = geracao + 1;
+    s->reservado = 0;
+    memcpy(s->limite, limite, sizeof(limite));
+    s->crc       = crc32((const uint8_t *)s->limite, sizeof(s->limite));
+
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(setor_offset(destino), FLASH_SECTOR_SIZE);
+    restore_interrupts(ints);
+    programar(setor_offset(destino) + FLASH_PAGE_SIZE, paginas.b + FLASH_PAGE_SIZE,
+              sizeof(paginas.b) - FLASH_PAGE_SIZE);
+    programar(setor_offset(destino), paginas.b, FLASH_PAGE_SIZE);
+
+    setor_ativo = destino;
+    geracao++;
+    n_entradas = 0;
+    gravacoes++;
+    compactar_pendente = false;
+}
+
+static void carregar_limites(void) {
+    const cifra_setor_t *a = setor_xip(0), *b = setor_xip(1), *s = NULL;
+
+    if (setor_valido(a)) s = a;
+    if (setor_valido(b) && (!s || (int32_t)(b->tab.geracao - a->tab.geracao) > 0)) s = b;
+    if (!s) {
+        // Flash nova (ou os dois cortados): começa do zero.
+        memset(limite, 0, sizeof(limite));
+        geracao     = 0;
+        setor_ativo = 1;
+        compactar();
+        return;
+    }
+
+    setor_ativo = s == b;
+    geracao     = s->tab.geracao;
+    memcpy(limite, s->tab.limite, sizeof(limite));
+    n_entradas = 0;
+    for (unsigned i = 0; i < CIFRA_ENTRADAS; i++) {
+        const cifra_entrada_t *e = &s->ent[i];
+        if (entrada_livre(e)) continue;
+        n_entradas = i + 1;
+        if (entrada_valida(e) && e->limite > limite[e->no]) limite[e->no] = e->limite;
+    }
+    compactar_pendente = n_entradas >= CIFRA_ENTRADAS - CIFRA_FOLGA;
+}
+
+// Grava 'lim' como limite do nó antes de aceitar qualquer quadro acima do atual.
+// Só programa uma página; o erase da compactação fica para o cifra_service(),
+// a não ser que a folga inteira tenha acabado sem um laço ocioso.
+static void gravar_limite(uint8_t no, uint32_t lim) {
+    if (n_entradas == CIFRA_ENTRADAS) {
+        limite[no] = lim;
+        compactar();
+        compactacoes_rx++;
+        return;
+    }
+
+    uint8_t pagina[FLASH_PAGE_SIZE];
+    uint32_t pos = offsetof(cifra_setor_t, ent) + n_entradas * sizeof(cifra_entrada_t);
+    cifra_entrada_t e = { lim, no, (uint8_t)~no, confere_entrada(lim, no) };
+
+    memset(pagina, 0xFF, sizeof(pagina));
+    memcpy(&pagina[pos % FLASH_PAGE_SIZE], &e, sizeof(e));
+    programar(setor_offset(setor_ativo) + pos / FLASH_PAGE_SIZE * FLASH_PAGE_SIZE,
+              pagina, sizeof(pagina));
+    limite[no] = lim;
+    n_entradas++;
+    gravacoes++;
+    if (n_entradas >= CIFRA_ENTRADAS - CIFRA_FOLGA) compactar_pendente = true;
+}
+
+void cifra_service(void) {
+    if (compactar_pendente) compactar();
+}
+
+void cifra_init(const uint8_t chave[16]) {
+    aes_key_t mestra;
+    uint8_t blk[AES_BLOCK_LEN] = {0};
+    uint8_t sub[AES_KEY_LEN];
+
+    aes_set_key(&mestra, chave);
+    blk[0] = 0x01;
+    aes_encrypt_block(&mestra, blk, sub);
+    aes_set_key(&chave_enc, sub);
+    blk[0] = 0x02;
+    aes_encrypt_block(&mestra, blk, sub);
+    aes_set_key(&chave_mac, sub);
+
+    // A chave zerada é a de fábrica (o nó recusa 'cfg_set crypt 1' com ela):
+    // sem chave, todo quadro cifrado é recusado.
+    com_chave = false;
+    for (unsigned i = 0; i < AES_KEY_LEN; i++) com_chave |= chave[i] != 0;
+    if (!com_chave) printf("Cifra: LORA_CHAVE zerada, quadros cifrados recusados\n");
+
+    // Depois de um reset, tudo até o limite gravado já pode ter sido aceito.
+    carregar_limites();
+    memcpy(ultimo_seq, limite, sizeof(limite));
+}
+
+static cifra_status_t contar(cifra_status_t st) {
+    contagem[st]++;
+    return st;
+}
+
+cifra_status_t cifra_abrir(const uint8_t *quadro, uint8_t len, uint8_t *claro,
+                           uint8_t *claro_len, uint8_t *node) {
+    uint8_t tag[AES_BLOCK_LEN];
+    uint8_t ctr[AES_BLOCK_LEN] = {0};
+
+    if (!com_chave || len <= CIFRA_OVERHEAD || quadro[0] != CIFRA_FRAME_TYPE)
+        return contar(CIFRA_FORMATO);
+
+    // Encrypt-then-MAC: o tag vem antes de qualquer uso do conteúdo. A
+    // comparação percorre os 4 bytes sempre (tempo constante).
+    uint8_t n = len - CIFRA_OVERHEAD, dif = 0;
+    aes_cmac(&chave_mac, quadro, CIFRA_HDR_LEN + n, tag);
+    for (unsigned i = 0; i < CIFRA_TAG_LEN; i++)
+        dif |= tag[i] ^ quadro[CIFRA_HDR_LEN + n + i];
+    if (dif) return contar(CIFRA_TAG);
+
+    uint8_t  no  = quadro[1];
+    uint32_t seq = get_u32(&quadro[2]);
+    if (seq <= ultimo_seq[no]) return contar(CIFRA_REPLAY);
+    if (seq > limite[no])
+        gravar_limite(no, seq > UINT32_MAX - CIFRA_RESERVA ? UINT32_MAX : seq + CIFRA_RESERVA);
+    ultimo_seq[no] = seq;
+
+    ctr[0] = 0x01;
+    ctr[1] = no;
+    memcpy(&ctr[2], &quadro[2], 4);
+    ctr[AES_BLOCK_LEN - 1] = 1;
+    memcpy(claro, &quadro[CIFRA_HDR_LEN], n);
+    aes_ctr(&chave_enc, ctr, claro, n);
+
+    *claro_len = n;
+    *node      = no;
+    return contar(CIFRA_OK);
+}
+
+cifra_status_t cifra_claro(uint8_t node) {
+    // limite[] só sai de 0 com um quadro cifrado aceito, e vem da flash.
+    return limite[node] ? contar(CIFRA_CLARO) : CIFRA_OK;
+}
+
+const char *cifra_nome(cifra_status_t st) {
+    static const char *const nomes[CIFRA_NUM_STATUS] = {
+        "ok", "formato", "tag invalido", "replay", "sem cifra",
+    };
+    return st < CIFRA_NUM_STATUS ? nomes[st] : "?";
+}
+
+void cifra_report(void) {
+    printf("Quadros cifrados:");
+    for (unsigned i = 0; i < CIFRA_NUM_STATUS; i++)
+        printf(" %s %lu%s", cifra_nome((cifra_status_t)i), (unsigned long)contagem[i],
+               i + 1 < CIFRA_NUM_STATUS ? "," : "\n");
+    for (unsigned no = 0; no < 256; no++)
+        if (ultimo_seq[no])
+            printf("  No %u: epoca %lu, quadro %lu (limite na flash: quadro %lu da epoca %lu)\n", no,
+                   (unsigned long)(ultimo_seq[no] >> 16), (unsigned long)(ultimo_seq[no] & 0xFFFF),
+                   (unsigned long)(limite[no] & 0xFFFF), (unsigned long)(limite[no] >> 16));
+    printf("  Limites: setor %u, geracao %lu, diario %u de %u, %lu gravacoes, %lu compactacoes no RX\n",
+           setor_ativo, (unsigned long)geracao, n_entradas, (unsigned)CIFRA_ENTRADAS,
+           (unsigned long)gravacoes, (unsigned long)compactacoes_rx);
+}
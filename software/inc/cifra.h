@@ -0,0 +1,65 @@
+#ifndef CIFRA_H_
+#define CIFRA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Quadros cifrados e autenticados do nó FPGA ('cfg_set crypt 1'; formato em
+// hardware/firmware/lib/frame.h):
+//   [0]        CIFRA_FRAME_TYPE
+//   [1]        node_id
+//   [2..5]     seq (uint32 LE): época << 16 | quadro na época
+//   [6..n+5]   quadro interno cifrado (AES-128-CTR)
+//   [n+6..n+9] 4 primeiros bytes do AES-CMAC de [0..n+5]
+// O tag é conferido antes de decifrar, e a sequência de cada nó só pode
+// crescer: um quadro gravado e retransmitido (replay) é recusado.
+//
+// O limite de cada nó também fica na flash, em dois setores logo abaixo do
+// flashlog, para o replay continuar recusado depois de um reset do receptor.
+// Gravar a cada quadro gastaria a flash: o limite gravado vai CIFRA_RESERVA
+// sequências à frente do último aceito, e só é regravado quando um quadro o
+// alcança (uma entrada de 8 bytes no diário do setor, a cada CIFRA_RESERVA
+// quadros do nó). Depois de um reset, o nó perde no máximo essa reserva de
+// quadros, ou até começar uma época nova (boot do nó).
+#define CIFRA_RESERVA    64
+
+#define CIFRA_FRAME_TYPE 0x45   // 'E'
+#define CIFRA_HDR_LEN    6
+#define CIFRA_TAG_LEN    4
+#define CIFRA_OVERHEAD   (CIFRA_HDR_LEN + CIFRA_TAG_LEN)
+
+typedef enum {
+    CIFRA_OK = 0,
+    CIFRA_FORMATO,          // Curto demais ou sem chave
+    CIFRA_TAG,              // Tag não confere (chave errada ou quadro alterado)
+    CIFRA_REPLAY,           // seq <= último aceito do nó
+    CIFRA_CLARO,            // Quadro sem cifra de um nó que já mandou cifrados
+    CIFRA_NUM_STATUS
+} cifra_status_t;
+
+// Deriva as chaves de cifra e de MAC da chave do nó (a do 'cfg_set key') e
+// carrega da flash os limites de sequência.
+void cifra_init(const uint8_t chave[16]);
+
+// Confere e decifra um quadro CIFRA_FRAME_TYPE de 'len' bytes. Com CIFRA_OK,
+// 'claro' recebe o quadro interno (len - CIFRA_OVERHEAD bytes, em
+// *claro_len) e *node o id autenticado.
+cifra_status_t cifra_abrir(const uint8_t *quadro, uint8_t len, uint8_t *claro,
+                           uint8_t *claro_len, uint8_t *node);
+
+// Quadro sem cifra com o id 'node': CIFRA_CLARO se o nó já teve um quadro
+// cifrado aceito (também antes de um reset), senão CIFRA_OK. Assim o receptor
+// aceita nós sem cifra, mas ninguém se passa por um nó cifrado mandando claro.
+cifra_status_t cifra_claro(uint8_t node);
+
+const char *cifra_nome(cifra_status_t st);
+
+// Chamada no laço ocioso: com o diário perto do fim, copia a tabela para o
+// outro setor (erase de setor, com as interrupções desligadas) fora do RX.
+void cifra_service(void);
+
+// Imprime os contadores por resultado, a última sequência e o limite gravado
+// de cada nó.
+void cifra_report(void);
+
+#endif
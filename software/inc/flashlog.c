@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "flashlog.h"
+#include "cifra.h"
+
+#define FLASHLOG_MAGIC    0x32474f4cu     // "LOG2"
+#define FLASHLOG_OFFSET   (PICO_FLASH_SIZE_BYTES - FLASHLOG_SIZE)
+#define FLASHLOG_SECTORS  (FLASHLOG_SIZE / FLASH_SECTOR_SIZE)
+#define FLASHLOG_RECS     (FLASH_SECTOR_SIZE / sizeof(flashlog_rec_t) - 1)
+#define FLASHLOG_PER_PAGE (FLASH_PAGE_SIZE / sizeof(flashlog_rec_t))
+
+// Ocupa o lugar do registro 0 do setor.
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t boot;
+    uint16_t reserved;
+    uint32_t crc;           // crc32 dos campos acima
+    uint8_t  pad[16];
+} flashlog_hdr_t;
+
+typedef struct {
+    flashlog_hdr_t hdr;
+    flashlog_rec_t rec[FLASHLOG_RECS];
+} flashlog_sector_t;
+
+_Static_assert(sizeof(flashlog_rec_t) == 32, "registro do flashlog");
+_Static_assert(sizeof(flashlog_hdr_t) == sizeof(flashlog_rec_t), "cabecalho do flashlog");
+_Static_assert(sizeof(flashlog_sector_t) == FLASH_SECTOR_SIZE, "setor do flashlog");
+_Static_assert(FLASHLOG_DATA_MAX >= 15 + CIFRA_OVERHEAD, "quadro de rastreio cifrado");
+
+static union { flashlog_sector_t s; uint8_t raw[FLASH_SECTOR_SIZE]; } stage;
+
+static uint32_t cur_seq;        // seq do setor em 'stage'
+static uint16_t n_recs;         // Registros no setor (RAM)
+static uint16_t n_prog;         // Dos quais já gravados na flash
+static uint32_t n_valid;        // setores válidos no anel
+static bool     erased;         // slot de cur_seq já apagado
+static bool     full;           // Setor cheio: gravar e passar ao próximo
+static absolute_time_t first_rec;   // Mais antigo ainda só na RAM
+static uint16_t boot_id;
+static uint32_t pages, inline_erases, dropped;
+
+static uint32_t crc32(const uint8_t *p, size_t n) {
+    uint32_t crc = 0xFFFFFFFFu;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++)
+            crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1));
+    }
+    return ~crc;
+}
+
+static uint8_t crc8(const uint8_t *p, size_t n) {
+    uint8_t crc = 0;
+    while (n--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++)
+            crc = (uint8_t)((crc << 1) ^ ((crc & 0x80) ? 0x07 : 0));
+    }
+    return crc;
+}
+
+static uint8_t rec_crc(const flashlog_rec_t *r) {
+    unsigned n = r->len < FLASHLOG_DATA_MAX ? r->len : FLASHLOG_DATA_MAX;
+    return crc8((const uint8_t *)r, offsetof(flashlog_rec_t, crc)) ^ crc8(r->data, n);
+}
+
+// Lugar ainda apagado (um uptime de 0xFFFFFFFF ms não acontece).
+static bool rec_free(const flashlog_rec_t *r) {
+    return r->t_ms == 0xFFFFFFFFu && r->len == 0xFF;
+}
+
+static inline uint32_t slot_offset(uint32_t seq) {
+    return FLASHLOG_OFFSET + (seq % FLASHLOG_SECTORS) * FLASH_SECTOR_SIZE;
+}
+
+static inline const flashlog_sector_t *slot_xip(uint32_t seq) {
+    return (const flashlog_sector_t *)(uintptr_t)(XIP_BASE + slot_offset(seq));
+}
+
+static bool sector_valid(const flashlog_sector_t *s) {
+    return s->hdr.magic == FLASHLOG_MAGIC &&
+           s->hdr.crc == crc32((const uint8_t *)&s->hdr, offsetof(flashlog_hdr_t, crc));
+}
+
+static void stage_reset(uint32_t seq) {
+    memset(&stage, 0xFF, sizeof(stage));
+    stage.s.hdr.magic    = FLASHLOG_MAGIC;
+    stage.s.hdr.seq      = seq;
+    stage.s.hdr.boot     = boot_id;
+    stage.s.hdr.reserved = 0;
+    stage.s.hdr.crc      = crc32((const uint8_t *)&stage.s.hdr, offsetof(flashlog_hdr_t, crc));
+    cur_seq = seq;
+    n_recs  = 0;
+    n_prog  = 0;
+    erased  = false;
+    full    = false;
+}
+
+void flashlog_init(void) {
+    const flashlog_sector_t *newest = NULL;
+
+    // Leitura direta pelo XIP: 128 cabeçalhos, menos de 1 ms.
+    n_valid = 0;
+    for (uint32_t i = 0; i < FLASHLOG_SECTORS; i++) {
+        const flashlog_sector_t *s = slot_xip(i);
+        if (!sector_valid(s)) continue;
+        n_valid++;
+        if (!newest || (int32_t)(s->hdr.seq - newest->hdr.seq) > 0) newest = s;
+    }
+
+    boot_id = newest ? (uint16_t)(newest->hdr.boot + 1) : 0;
+    stage_reset(newest ? newest->hdr.seq + 1 : 0);
+}
+
+void flashlog_append(const uint8_t *data, uint8_t len, int16_t rssi) {
+    // Setor cheio ainda não gravado: não há onde guardar.
+    if (full) {
+        dropped++;
+        return;
+    }
+
+    flashlog_rec_t *r = &stage.s.rec[n_recs];
+    memset(r, 0, sizeof(*r));
+    r->t_ms     = to_ms_since_boot(get_absolute_time());
+    r->rssi_neg = rssi > 0 ? 0 : (rssi < -255 ? 255 : (uint8_t)-rssi);
+    r->len      = len;
+    memcpy(r->data, data, len < FLASHLOG_DATA_MAX ? len : FLASHLOG_DATA_MAX);
+    r->crc      = rec_crc(r);
+
+    if (n_recs++ == n_prog) first_rec = get_absolute_time();
+    if (n_recs == FLASHLOG_RECS) full = true;
+}
+
+// O setor mais antigo sai do anel aqui, antes de ser sobrescrito.
+static void erase_slot(void) {
+    if (sector_valid(slot_xip(cur_seq))) n_valid--;
+
+    uint32_t ints = save_and_disable_interrupts();
+    flash_range_erase(slot_offset(cur_seq), FLASH_SECTOR_SIZE);
+    restore_interrupts(ints);
+    erased = true;
+}
+
+// Grava as páginas com registros novos; os já gravados vão como 0xFF.
+void flashlog_commit(void) {
+    static uint8_t page[FLASH_PAGE_SIZE];
+
+    if (n_recs == n_prog) return;
+    if (!erased) {
+        erase_slot();
+        inline_erases++;
+    }
+
+    // Lugares [from, to) do setor; o cabeçalho ocupa o lugar 0 e vai junto
+    // com o primeiro registro.
+    unsigned from = n_prog ? n_prog + 1 : 0, to = n_recs + 1;
+    for (unsigned p = from / FLASHLOG_PER_PAGE; p * FLASHLOG_PER_PAGE < to; p++) {
+        unsigned first = p * FLASHLOG_PER_PAGE;
+        memcpy(page, &stage.raw[first * sizeof(flashlog_rec_t)], FLASH_PAGE_SIZE);
+        if (first < from) memset(page, 0xFF, (from - first) * sizeof(flashlog_rec_t));
+
+        uint32_t ints = save_and_disable_interrupts();
+        flash_range_program(slot_offset(cur_seq) + p * FLASH_PAGE_SIZE, page, FLASH_PAGE_SIZE);
+        restore_interrupts(ints);
+        pages++;
+    }
+    if (n_prog == 0) n_valid++;         // O cabeçalho acabou de ir
+    n_prog = n_recs;
+
+    if (full) stage_reset(cur_seq + 1);
+}
+
+void flashlog_service(void) {
+    // Erase antecipado do slot corrente: fica fora do caminho do RX.
+    if (!erased) {
+        erase_slot();
+        return;
+    }
+    // Página cheia, setor cheio ou registro velho demais só na RAM.
+    bool page_full = (n_recs + 1) / FLASHLOG_PER_PAGE != (n_prog + 1) / FLASHLOG_PER_PAGE;
+    if (full || page_full ||
+        (n_recs > n_prog && absolute_time_diff_us(first_rec, get_absolute_time()) >=
+                            (int64_t)FLASHLOG_COMMIT_MS * 1000))
+        flashlog_commit();
+}
+
+void flashlog_export(unsigned sectors) {
+    uint32_t n = n_valid;
+
+    if (sectors && sectors < n) n = sectors;
+    printf("seq,boot,t_ms,rssi,len,dados\n");
+    // Do mais antigo para o mais novo, até o corrente; slots inválidos
+    // (apagados) são pulados, e cada setor vai até o primeiro registro livre.
+    for (uint32_t seq = cur_seq - n; seq != cur_seq + 1; seq++) {
+        const flashlog_sector_t *s = slot_xip(seq);
+        if (!sector_valid(s) || s->hdr.seq != seq) continue;
+        for (unsigned i = 0; i < FLASHLOG_RECS && !rec_free(&s->rec[i]); i++) {
+            const flashlog_rec_t *r = &s->rec[i];
+            if (r->crc != rec_crc(r)) {
+                printf("# registro %lu/%u corrompido\n", (unsigned long)seq, i);
+                continue;
+            }
+            printf("%lu,%u,%lu,%d,%u,", (unsigned long)seq, s->hdr.boot,
+                   (unsigned long)r->t_ms, -(int)r->rssi_neg, r->len);
+            for (unsigned j = 0; j < r->len && j < FLASHLOG_DATA_MAX; j++)
+                printf("%02x", r->data[j]);
+            printf("\n");
+        }
+    }
+}
+
+void flashlog_stats(void) {
+    printf("flashlog: %lu setores validos de %u, setor %lu com %u de %u registros (%u na flash), boot %u\n",
+           (unsigned long)n_valid, (unsigned)FLASHLOG_SECTORS, (unsigned long)cur_seq,
+           n_recs, (unsigned)FLASHLOG_RECS, n_prog, boot_id);
+    printf("paginas gravadas %lu, erases na gravacao %lu, descartados %lu\n",
+           (unsigned long)pages, (unsigned long)inline_erases, (unsigned long)dropped);
+}
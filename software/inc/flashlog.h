@@ -0,0 +1,60 @@
+#ifndef FLASHLOG_H_
+#define FLASHLOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Log em anel dos quadros recebidos, na parte alta da flash XIP (fora da
+// imagem do programa). O setor corrente é apagado antes de receber o primeiro
+// registro, e os registros entram nele página a página (256 bytes, 8
+// registros): quando a página enche, ou FLASHLOG_COMMIT_MS depois do registro
+// mais antigo ainda só na RAM. Uma página parcial é completada depois, na
+// mesma página (a flash só zera bits, e os registros já gravados vão como
+// 0xFF). Cada setor é apagado uma vez por volta do anel, então o desgaste não
+// depende do intervalo de gravação.
+//
+// O primeiro registro de cada setor é o cabeçalho (seq, boot e CRC32). Cada
+// registro tem o seu CRC8, então uma gravação cortada perde só os registros
+// da página em gravação. O boot começa um setor novo depois do maior seq
+// válido.
+//
+// Capacidade: 128 setores x 127 registros = 16256 quadros, ~11 dias a um
+// quadro por minuto (o setor mais antigo sai inteiro quando o anel gira).
+//
+// Apagar e programar a flash para o XIP (e as interrupções): por isso o
+// append só copia para a RAM, e flashlog_service() faz o erase antecipado e a
+// gravação no laço principal, quando não há pacote para tratar. Um erase
+// (< 400 ms no pior caso) é mais curto que o menor quadro em SF12 (~1 s), e o
+// quadro que chegar nesse meio-tempo espera no FIFO do rádio.
+
+#define FLASHLOG_SIZE        (512 * 1024)   // 128 setores
+#define FLASHLOG_COMMIT_MS   (60 * 1000)    // Grava a página parcial depois disso
+#define FLASHLOG_DATA_MAX    25             // Quadro de rastreio cifrado: 15 + CIFRA_OVERHEAD
+
+typedef struct {
+    uint32_t t_ms;          // Desde o boot do setor
+    uint8_t  rssi_neg;      // -RSSI em dBm
+    uint8_t  len;           // Tamanho original (só FLASHLOG_DATA_MAX bytes guardados); 0xFF = livre
+    uint8_t  crc;           // crc8 dos campos acima e dos bytes guardados
+    uint8_t  data[FLASHLOG_DATA_MAX];
+} flashlog_rec_t;
+
+// Procura o último setor válido e prepara o próximo.
+void flashlog_init(void);
+
+// Copia o quadro para o setor em RAM (não toca na flash).
+void flashlog_append(const uint8_t *data, uint8_t len, int16_t rssi);
+
+// Erase antecipado e gravação dos setores cheios; chamar quando o laço está ocioso.
+void flashlog_service(void);
+
+// Grava já a página parcial (ex.: antes de exportar).
+void flashlog_commit(void);
+
+// Exporta em CSV os 'sectors' setores mais recentes (0 = todos).
+void flashlog_export(unsigned sectors);
+
+void flashlog_stats(void);
+
+#endif
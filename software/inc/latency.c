@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <string.h>
+#include "latency.h"
+
+#define LAT_SUB_BITS  3
+#define LAT_SUB       (1u << LAT_SUB_BITS)
+#define LAT_BUCKETS   ((32 - LAT_SUB_BITS + 1) * LAT_SUB)
+
+typedef struct {
+    uint32_t count[LAT_BUCKETS];
+    uint32_t n;
+    uint32_t min, max;
+} lat_hist_t;
+
+static lat_hist_t hist[LAT_NUM_STAGES];
+
+static const char *const stage_name[LAT_NUM_STAGES] = {
+    [LAT_NODE_QUEUE]   = "no: amostra->TX",
+    [LAT_NODE_AIRTIME] = "no: TX->TxDone",
+    [LAT_IRQ_FIFO]     = "rx: DIO0->FIFO",
+    [LAT_DECODE]       = "rx: FIFO->decod.",
+    [LAT_DISPLAY]      = "rx: decod.->OLED",
+    [LAT_RECEIVER]     = "rx: DIO0->OLED",
+    [LAT_END_TO_END]   = "fim a fim",
+};
+
+// Faixas 0..7 são exatas; acima disso, oitava do bit mais alto e os 3 bits seguintes.
+static unsigned bucket_of(uint32_t us) {
+    if (us < LAT_SUB) return us;
+    unsigned msb = 31 - __builtin_clz(us);
+    return (msb - LAT_SUB_BITS + 1) * LAT_SUB + ((us >> (msb - LAT_SUB_BITS)) & (LAT_SUB - 1));
+}
+
+// Meio da faixa: o erro fica em metade da largura.
+static uint32_t bucket_value(unsigned b) {
+    if (b < LAT_SUB) return b;
+    unsigned shift = b / LAT_SUB - 1;
+    uint32_t lo = (uint32_t)(LAT_SUB + b % LAT_SUB) << shift;
+    return lo + ((1u << shift) >> 1);
+}
+
+static uint32_t percentile(const lat_hist_t *h, unsigned pct) {
+    // Posição (1..n) da amostra do percentil, arredondando para cima.
+    uint32_t rank = (uint32_t)(((uint64_t)h->n * pct + 99) / 100);
+    uint32_t acc = 0;
+
+    if (rank == 0) rank = 1;
+    for (unsigned b = 0; b < LAT_BUCKETS; b++) {
+        acc += h->count[b];
+        if (acc >= rank) {
+            uint32_t v = bucket_value(b);
+            // O meio da faixa pode cair fora do que foi observado.
+            if (v < h->min) v = h->min;
+            if (v > h->max) v = h->max;
+            return v;
+        }
+    }
+    return h->max;
+}
+
+void lat_record(lat_stage_t stage, uint32_t us) {
+    lat_hist_t *h = &hist[stage];
+
+    h->count[bucket_of(us)]++;
+    if (h->n == 0 || us < h->min) h->min = us;
+    if (us > h->max) h->max = us;
+    h->n++;
+}
+
+void lat_report(void) {
+    printf("%-18s %8s %10s %10s %10s %10s (us)\n", "etapa", "n", "min", "p50", "p99", "max");
+    for (unsigned i = 0; i < LAT_NUM_STAGES; i++) {
+        const lat_hist_t *h = &hist[i];
+        if (h->n == 0) {
+            printf("%-18s %8u\n", stage_name[i], 0u);
+            continue;
+        }
+        printf("%-18s %8lu %10lu %10lu %10lu %10lu\n", stage_name[i], (unsigned long)h->n,
+               (unsigned long)h->min, (unsigned long)percentile(h, 50),
+               (unsigned long)percentile(h, 99), (unsigned long)h->max);
+    }
+}
+
+void lat_reset(void) {
+    memset(hist, 0, sizeof(hist));
+}
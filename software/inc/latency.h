@@ -0,0 +1,33 @@
+#ifndef LATENCY_H_
+#define LATENCY_H_
+
+#include <stdint.h>
+
+// Histogramas de latência por etapa, do sensor no nó FPGA até o display.
+// As duas primeiras etapas vêm no quadro de rastreio ('T', cfg_set trace 1
+// no nó), medidas no relógio do nó; as demais são medidas aqui com
+// time_us_64(). O TX termina junto com o RxDone (a menos do tempo de voo),
+// então o trecho entre os dois relógios é o próprio airtime.
+//
+// Cada histograma tem 8 faixas por oitava (erro de até ~6% no percentil) de 1 us
+// a ~71 minutos, em 240 contadores.
+
+typedef enum {
+    LAT_NODE_QUEUE = 0,     // Amostra pronta na CPU do nó -> início do TX (fila + slot TDMA)
+    LAT_NODE_AIRTIME,       // Início do TX -> TxDone, medido no nó (quadro anterior)
+    LAT_IRQ_FIFO,           // IRQ do DIO0 -> FIFO drenado (inclui a espera do laço)
+    LAT_DECODE,             // FIFO drenado -> amostra decodificada
+    LAT_DISPLAY,            // Decodificada -> display atualizado (I2C)
+    LAT_RECEIVER,           // IRQ do DIO0 -> display atualizado
+    LAT_END_TO_END,         // Amostra no nó -> display (fila + airtime teórico + receptor)
+    LAT_NUM_STAGES
+} lat_stage_t;
+
+void lat_record(lat_stage_t stage, uint32_t us);
+
+// Imprime amostras, mínimo, p50, p99 e máximo de cada etapa.
+void lat_report(void);
+
+void lat_reset(void);
+
+#endif
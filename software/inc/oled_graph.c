@@ -0,0 +1,112 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "ssd1306.h"
+#include "oled_graph.h"
+
+// Pontos visíveis: na varredura, uma coluna fica para o cursor.
+#if OLED_GRAPH_CONTENT_SCROLL
+#define VISIVEIS OLED_GRAPH_WIDTH
+#else
+#define VISIVEIS (OLED_GRAPH_WIDTH - 1)
+#endif
+
+void oled_graph_init(oled_graph_t *g, uint8_t page_start, uint8_t page_end, int16_t vmin, int16_t vmax) {
+    memset(g, 0, sizeof(*g));
+    g->page_start = page_start;
+    g->page_end   = page_end;
+    g->vmin = vmin;
+    g->vmax = vmax;
+}
+
+static inline int16_t amostra(const oled_graph_t *g, uint32_t i) {
+    return g->hist[i % OLED_GRAPH_WIDTH];
+}
+
+// Valor -> linha do display (vmax no topo da área).
+static int linha(const oled_graph_t *g, int16_t v) {
+    int topo  = g->page_start * 8;
+    int altura = (g->page_end - g->page_start + 1) * 8 - 1;
+    int32_t faixa = (int32_t)g->vmax - g->vmin;
+
+    if (faixa <= 0) return topo + altura / 2;
+    return topo + altura - (int)(((int32_t)(v - g->vmin) * altura + faixa / 2) / faixa);
+}
+
+// Coluna x com o ponto i ligado ao anterior (se ele existe): um trecho vertical.
+static void desenha_coluna(const oled_graph_t *g, uint8_t *ssd, int x, uint32_t i) {
+    int y   = linha(g, amostra(g, i));
+    int ant = i > 0 ? linha(g, amostra(g, i - 1)) : y;
+
+    ssd1306_draw_vspan(ssd, x, g->page_start * 8, g->page_end * 8 + 7, false);
+    ssd1306_draw_vspan(ssd, x, ant, y, true);
+}
+
+static void apaga_coluna(const oled_graph_t *g, uint8_t *ssd, int x) {
+    ssd1306_draw_vspan(ssd, x, g->page_start * 8, g->page_end * 8 + 7, false);
+}
+
+// Coluna do ponto i na tela.
+static int coluna(const oled_graph_t *g, uint32_t i) {
+#if OLED_GRAPH_CONTENT_SCROLL
+    return OLED_GRAPH_WIDTH - 1 - (int)(g->n - 1 - i);
+#else
+    (void)g;
+    return (int)(i % OLED_GRAPH_WIDTH);
+#endif
+}
+
+void oled_graph_render(const oled_graph_t *g, uint8_t *ssd) {
+    uint32_t primeiro = g->n > VISIVEIS ? g->n - VISIVEIS : 0;
+
+    for (int x = 0; x < OLED_GRAPH_WIDTH; x++) apaga_coluna(g, ssd, x);
+    for (uint32_t i = primeiro; i < g->n; i++) desenha_coluna(g, ssd, coluna(g, i), i);
+}
+
+// Abre a faixa com 1/8 de folga para o valor caber; raro, e custa um redesenho.
+static bool ajusta_faixa(oled_graph_t *g, int16_t v) {
+    int32_t folga;
+
+    if (v >= g->vmin && v <= g->vmax) return false;
+    folga = ((int32_t)g->vmax - g->vmin) / 8 + 1;
+    if (v < g->vmin) g->vmin = (int16_t)(v - folga < INT16_MIN ? INT16_MIN : v - folga);
+    if (v > g->vmax) g->vmax = (int16_t)(v + folga > INT16_MAX ? INT16_MAX : v + folga);
+    return true;
+}
+
+bool oled_graph_push(oled_graph_t *g, int16_t v, uint8_t *ssd, bool enviar) {
+    uint32_t i = g->n++;
+
+    g->hist[i % OLED_GRAPH_WIDTH] = v;
+    if (ajusta_faixa(g, v)) {
+        oled_graph_render(g, ssd);
+        return true;
+    }
+
+#if OLED_GRAPH_CONTENT_SCROLL
+    // O controlador desloca; só a coluna da direita é desenhada e enviada.
+    if (enviar)
+        ssd1306_scroll_content_left(ssd, 0, OLED_GRAPH_WIDTH - 1, g->page_start, g->page_end);
+    else
+        for (int p = g->page_start; p <= g->page_end; p++)
+            memmove(&ssd[p * OLED_GRAPH_WIDTH], &ssd[p * OLED_GRAPH_WIDTH + 1], OLED_GRAPH_WIDTH - 1);
+    desenha_coluna(g, ssd, OLED_GRAPH_WIDTH - 1, i);
+    if (enviar)
+        ssd1306_write_columns(ssd, OLED_GRAPH_WIDTH - 1, OLED_GRAPH_WIDTH - 1, g->page_start, g->page_end);
+#else
+    // Ponto novo e cursor apagado à frente; na última coluna, o cursor volta à 0.
+    int x = coluna(g, i);
+    int cursor = (x + 1) % OLED_GRAPH_WIDTH;
+
+    desenha_coluna(g, ssd, x, i);
+    apaga_coluna(g, ssd, cursor);
+    if (enviar) {
+        if (cursor > x) {
+            ssd1306_write_columns(ssd, x, cursor, g->page_start, g->page_end);
+        } else {
+            ssd1306_write_columns(ssd, x, x, g->page_start, g->page_end);
+            ssd1306_write_columns(ssd, cursor, cursor, g->page_start, g->page_end);
+        }
+    }
+#endif
+    return false;
+}
@@ -0,0 +1,50 @@
+#ifndef OLED_GRAPH_H_
+#define OLED_GRAPH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Gráfico de tendência que cresce uma coluna por amostra, nas páginas
+// page_start..page_end do display e na largura toda. Cada ponto novo vira
+// uma escrita de poucas colunas (endereçamento por coluna), não o quadro de
+// 1 KB:
+//
+// - OLED_GRAPH_CONTENT_SCROLL = 1: o controlador desloca o gráfico uma coluna
+//   para a esquerda (content scroll, 2Dh) e só a coluna da direita é enviada.
+//   Precisa de um controlador com 2Dh (SSD1306B, SSD1309, SSD1315).
+// - 0 (padrão, qualquer SSD1306): varredura, como num osciloscópio. O ponto
+//   novo entra na coluna seguinte, com uma coluna apagada à frente como
+//   cursor (2 colunas por ponto). O scroll contínuo (26h/27h) não serve aqui:
+//   ele anda no ritmo dos quadros do display, não um passo por comando, e
+//   estraga a RAM ao parar.
+//
+// O buffer 'ssd' do chamador é mantido igual à GDDRAM, então um redesenho
+// completo (troca de página) sai de oled_graph_render().
+
+#ifndef OLED_GRAPH_CONTENT_SCROLL
+#define OLED_GRAPH_CONTENT_SCROLL 0
+#endif
+
+#define OLED_GRAPH_WIDTH 128
+
+typedef struct {
+    uint8_t  page_start, page_end;
+    int16_t  vmin, vmax;                // Faixa do eixo y; cresce se uma amostra sair dela
+    int16_t  hist[OLED_GRAPH_WIDTH];    // Anel das últimas amostras
+    uint32_t n;                         // Amostras desde o início
+} oled_graph_t;
+
+void oled_graph_init(oled_graph_t *g, uint8_t page_start, uint8_t page_end, int16_t vmin, int16_t vmax);
+
+/**
+ * Acrescenta uma amostra e desenha a coluna nova em 'ssd'. Com 'enviar', manda
+ * ao display só o que mudou.
+ * @return true se a faixa do eixo y cresceu: o gráfico foi redesenhado em
+ * 'ssd' (oled_graph_render) e precisa ser enviado inteiro.
+ */
+bool oled_graph_push(oled_graph_t *g, int16_t v, uint8_t *ssd, bool enviar);
+
+// Redesenha todo o gráfico em 'ssd' (sem enviar).
+void oled_graph_render(const oled_graph_t *g, uint8_t *ssd);
+
+#endif
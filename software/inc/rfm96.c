@@ -40,11 +40,22 @@
 #define REG_PKT_RSSI_VALUE       0x1A 
 
 static rfm96_config_t lora;
-volatile static bool tx_done = false;
-volatile static bool rx_done = false;
-volatile static bool dio0_event = false;
+static volatile bool tx_done = false;
+static volatile bool rx_done = false;
+static volatile bool dio0_event = false;
+static volatile uint64_t dio0_at_us = 0;  // Instante do último IRQ do DIO0
+
+static uint8_t implicit_len = 0;
+
+static const uint32_t bw_table[] = {
+    7800, 10400, 15600, 20800, 31250, 41700, 62500, 125000, 250000, 500000
+};
+
+static lora_packet_t packet_pool[LORA_PACKET_POOL_LEN];
+static uint32_t packet_dropped = 0;
 
 static void lora_reset();
+static uint8_t lora_rx_fetch(uint8_t *data);
 static void lora_write_reg(uint8_t reg, uint8_t value);
 static uint8_t lora_read_reg(uint8_t reg);
 static void lora_write_fifo(const uint8_t *data, uint8_t len);
@@ -56,8 +67,19 @@ static void dio0_irq_handler(uint gpio, uint32_t events);
 static void handle_dio0_events();
 
 
+static uint8_t modem_config_1(bool implicit) {
+    uint8_t bw = 7;
+    for (uint8_t i = 0; i < sizeof(bw_table) / sizeof(bw_table[0]); i++)
+        if (bw_table[i] == lora.bw_hz) bw = i;
+    return (uint8_t)((bw << 4) | (lora.cr << 1) | (implicit ? 1 : 0));
+}
+
 bool lora_init(rfm96_config_t config) {
     lora = config; 
+    if (!lora.sf)       lora.sf       = 12;
+    if (!lora.bw_hz)    lora.bw_hz    = 125000;
+    if (!lora.cr)       lora.cr       = 4;
+    if (!lora.preamble) lora.preamble = 12;
     spi_init(lora.spi_instance, 5E6);
     gpio_set_function(lora.pin_miso, GPIO_FUNC_SPI);
     gpio_set_function(lora.pin_mosi, GPIO_FUNC_SPI);
@@ -71,17 +93,15 @@ bool lora_init(rfm96_config_t config) {
     lora_set_mode(MODE_SLEEP);
     lora_set_mode(MODE_STDBY);
     lora_write_reg(REG_IRQ_FLAGS, 0xFF);   
-    uint64_t frf = ((uint64_t)lora.frequency << 19) / 32000000;
-    lora_write_reg(REG_FRF_MSB, (uint8_t)(frf >> 16));
-    lora_write_reg(REG_FRF_MID, (uint8_t)(frf >> 8));
-    lora_write_reg(REG_FRF_LSB, (uint8_t)(frf >> 0));
+    lora_set_frequency(lora.frequency);
     lora_write_reg(REG_PA_CONFIG, 0xFF); 
     lora_write_reg(REG_PA_DAC, 0x87); 
-    lora_write_reg(REG_MODEM_CONFIG_1, 0x78); 
-    lora_write_reg(REG_MODEM_CONFIG_2, 0xC4); 
-    lora_write_reg(REG_MODEM_CONFIG_3, 0x0C); 
-    lora_write_reg(REG_PREAMBLE_MSB, 0x00);
-    lora_write_reg(REG_PREAMBLE_LSB, 0x0C);
+    lora_write_reg(REG_MODEM_CONFIG_1, modem_config_1(false)); 
+    lora_write_reg(REG_MODEM_CONFIG_2, (uint8_t)((lora.sf << 4) | 0x04));   // CRC ligado
+    lora_write_reg(REG_MODEM_CONFIG_3,
+                   (uint8_t)((lora_ldro_required(lora.sf, lora.bw_hz) ? 0x08 : 0) | 0x04)); 
+    lora_write_reg(REG_PREAMBLE_MSB, (uint8_t)(lora.preamble >> 8));
+    lora_write_reg(REG_PREAMBLE_LSB, (uint8_t)lora.preamble);
     lora_write_reg(0x0B, 0x37); 
     lora_write_reg(0x39, 0x12);
     lora_write_reg(REG_FIFO_TX_BASE_ADDR, 0x00);
@@ -95,12 +115,17 @@ bool lora_init(rfm96_config_t config) {
 }
 
 bool lora_send(const char *msg) {
-    if (strlen(msg) > 255) return false;
+    return lora_send_bytes((const uint8_t *)msg, strlen(msg));
+}
+
+bool lora_send_bytes(const uint8_t *data, size_t len) {
+    if (len == 0 || len > 255) return false;
 
     lora_set_mode(MODE_STDBY); 
+    lora_write_reg(REG_MODEM_CONFIG_1, modem_config_1(false));
     lora_write_reg(REG_FIFO_ADDR_PTR, 0x00);
-    lora_write_fifo((const uint8_t*)msg, strlen(msg));
-    lora_write_reg(REG_PAYLOAD_LENGTH, strlen(msg));
+    lora_write_fifo(data, (uint8_t)len);
+    lora_write_reg(REG_PAYLOAD_LENGTH, (uint8_t)len);
 
     lora_write_reg(REG_IRQ_FLAGS, 0xFF);
     lora_write_reg(REG_DIO_MAPPING_1, 0x40); 
@@ -122,43 +147,100 @@ bool lora_send(const char *msg) {
     return true;
 }
 
-int lora_receive(char *buf, size_t maxlen) {
-    handle_dio0_events();
-    if (!rx_done) return 0;
-    rx_done = false;
-
+// Copia o pacote do FIFO para 'data' (pelo menos 255 bytes) e devolve o tamanho.
+static uint8_t lora_rx_fetch(uint8_t *data) {
     uint8_t len = lora_read_reg(REG_RX_NB_BYTES);
 
     uint8_t fifo_addr = lora_read_reg(REG_FIFO_RX_CURRENT_ADDR);
     lora_write_reg(REG_FIFO_ADDR_PTR, fifo_addr);
 
-    lora_read_fifo((uint8_t*)buf, len);
-    buf[len] = '\0';
+    lora_read_fifo(data, len);
+    return len;
+}
 
+// Os wrappers com buffer do chamador passam pelo pool: nada é truncado, e um
+// quadro que não cabe em 'maxlen' é descartado com retorno -1.
+int lora_receive(char *buf, size_t maxlen) {
+    lora_packet_t *pkt = lora_receive_packet();
+    if (!pkt) return 0;
+
+    int len = pkt->len;
+    if (maxlen == 0 || (size_t)len >= maxlen) {
+        printf("Dados de %d bytes para %u.\n", len, (unsigned)maxlen);
+        len = -1;
+    } else {
+        memcpy(buf, pkt->data, len);
+        buf[len] = '\0';
+    }
+    lora_packet_release(pkt);
     return len;
 }
 
 
 int lora_receive_bytes(uint8_t *buf, size_t maxlen) {
+    lora_packet_t *pkt = lora_receive_packet();
+    if (!pkt) return 0;
+
+    int len = pkt->len;
+    if ((size_t)len > maxlen) {
+        printf("Dados de %d bytes para %u.\n", len, (unsigned)maxlen);
+        len = -1;
+    } else {
+        memcpy(buf, pkt->data, len);
+    }
+    lora_packet_release(pkt);
+    return len;
+}
+
+
+lora_packet_t *lora_receive_packet(void) {
     handle_dio0_events();
-    if (!rx_done) return 0;
+    if (!rx_done) return NULL;
     rx_done = false;
 
-    uint8_t len = lora_read_reg(REG_RX_NB_BYTES);
-    if (len > maxlen) {
-        printf("Dados de %u bytes para %u.\n", len, (unsigned)maxlen);
-        len = (uint8_t)maxlen;
+    lora_packet_t *pkt = NULL;
+    for (unsigned i = 0; i < LORA_PACKET_POOL_LEN; i++) {
+        if (packet_pool[i].refs == 0) { pkt = &packet_pool[i]; break; }
+    }
+    if (!pkt) {
+        packet_dropped++;
+        return NULL;
     }
 
-    uint8_t fifo_addr = lora_read_reg(REG_FIFO_RX_CURRENT_ADDR);
-    lora_write_reg(REG_FIFO_ADDR_PTR, fifo_addr);
+    // Em RX contínuo o DIO0 só volta a subir no próximo RxDone.
+    pkt->t_irq_us   = dio0_at_us;
+    pkt->len  = lora_rx_fetch(pkt->data);
+    pkt->data[pkt->len] = '\0';
+    pkt->rssi = (int16_t)lora_get_rssi();
+    pkt->t_fetch_us = time_us_64();
+    pkt->refs = 1;
+    return pkt;
+}
 
-    lora_read_fifo(buf, len); 
-    return len;
+void lora_packet_retain(lora_packet_t *pkt) {
+    if (pkt && pkt->refs < UINT8_MAX) pkt->refs++;
+}
+
+void lora_packet_release(lora_packet_t *pkt) {
+    if (pkt && pkt->refs > 0) pkt->refs--;
+}
+
+unsigned lora_packet_free(void) {
+    unsigned n = 0;
+    for (unsigned i = 0; i < LORA_PACKET_POOL_LEN; i++)
+        if (packet_pool[i].refs == 0) n++;
+    return n;
+}
+
+uint32_t lora_packet_dropped(void) {
+    return packet_dropped;
 }
 
 
 void lora_start_rx_continuous(void) {
+    // Sem cabeçalho o rádio só sabe o tamanho pelo PAYLOAD_LENGTH.
+    lora_write_reg(REG_MODEM_CONFIG_1, modem_config_1(implicit_len != 0));
+    if (implicit_len) lora_write_reg(REG_PAYLOAD_LENGTH, implicit_len);
     lora_write_reg(REG_IRQ_FLAGS, 0xFF);
     lora_write_reg(REG_DIO_MAPPING_1, 0x00); 
     lora_write_reg(REG_FIFO_ADDR_PTR, 0x00);
@@ -169,11 +251,12 @@ void lora_start_rx_continuous(void) {
 static void cs_select() { gpio_put(lora.pin_cs, 0); }
 static void cs_deselect() { gpio_put(lora.pin_cs, 1); }
 
+// Datasheet do SX1276: pulso de reset > 100 us e 5 ms até o chip aceitar SPI.
 static void lora_reset() {
     gpio_put(lora.pin_rst, 0); 
-    sleep_ms(10);
+    sleep_us(100);
     gpio_put(lora.pin_rst, 1); 
-    sleep_ms(10);
+    sleep_ms(5);
 }
 
 static void lora_write_reg(uint8_t reg, uint8_t value) {
@@ -215,6 +298,7 @@ static void lora_set_mode(uint8_t mode) {
 static void dio0_irq_handler(uint gpio, uint32_t events) {
     (void)gpio; 
     (void)events;
+    dio0_at_us = time_us_64();
     dio0_event = true;
 }
 
@@ -236,7 +320,54 @@ static void handle_dio0_events() {
 
 
 
+// Ajusta a portadora. Em RX contínuo, o rádio passa por standby e volta a
+// escutar já no novo canal.
+void lora_set_frequency(long frequency) {
+    uint8_t op_mode = lora_read_reg(REG_OP_MODE);
+    bool rx = (op_mode & 0x07) == MODE_RX_CONTINUOUS;
+
+    if (rx) lora_set_mode(MODE_STDBY);
+    lora.frequency = frequency;
+    uint64_t frf = ((uint64_t)frequency << 19) / 32000000;
+    lora_write_reg(REG_FRF_MSB, (uint8_t)(frf >> 16));
+    lora_write_reg(REG_FRF_MID, (uint8_t)(frf >> 8));
+    lora_write_reg(REG_FRF_LSB, (uint8_t)(frf >> 0));
+    if (rx) lora_start_rx_continuous();
+}
+
+bool lora_use_channel(const lora_channel_plan_t *plan, uint8_t channel) {
+    if (channel >= plan->count || channel >= LORA_MAX_CHANNELS) return false;
+    lora_set_frequency(plan->frequency[channel]);
+    return true;
+}
+
 int lora_get_rssi(void) {
     uint8_t rssi_raw = lora_read_reg(REG_PKT_RSSI_VALUE);
     return rssi_raw - 157;
-}
\ No newline at end of file
+}
+
+void lora_set_implicit(uint8_t len) {
+    uint8_t op_mode = lora_read_reg(REG_OP_MODE);
+
+    implicit_len = len;
+    if ((op_mode & 0x07) == MODE_RX_CONTINUOUS) {
+        lora_set_mode(MODE_STDBY);
+        lora_start_rx_continuous();
+    }
+}
+
+// Tsym = 2^SF / BW > 16 ms
+bool lora_ldro_required(uint8_t sf, uint32_t bw_hz) {
+    return (1000u << sf) > 16u * bw_hz;
+}
+
+// Fórmula do datasheet do SX1276, com CRC.
+uint32_t lora_airtime_us(size_t len, bool implicit) {
+    uint32_t tsym = (uint32_t)(((uint64_t)1000000 << lora.sf) / lora.bw_hz);
+    int de  = lora_ldro_required(lora.sf, lora.bw_hz) ? 1 : 0;
+    int num = 8 * (int)len - 4 * lora.sf + 28 + 16 - (implicit ? 20 : 0);
+    int den = 4 * (lora.sf - 2 * de);
+    int n   = num > 0 ? ((num + den - 1) / den) * (lora.cr + 4) : 0;
+
+    return ((4u * lora.preamble + 17u) * tsym) / 4u + (uint32_t)(8 + n) * tsym;
+}
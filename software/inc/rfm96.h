@@ -9,6 +9,40 @@
 
 #define TX_TIMEOUT_MS       5000   // tempo máximo esperando TxDone
 
+// Plano de canais: o mesmo do nó FPGA (hardware/firmware/lib/lora_dispatch.h),
+// onde o rádio N transmite no canal N. Cada receptor escuta um canal.
+#define LORA_MAX_CHANNELS   8
+#define LORA_CHANNEL_BASE_HZ 915000000L
+#define LORA_CHANNEL_STEP_HZ 200000L
+
+typedef struct {
+    uint8_t count;
+    long    frequency[LORA_MAX_CHANNELS];   // Hz
+} lora_channel_plan_t;
+
+// Plano padrão: 4 canais a partir de 915 MHz, passo de 200 kHz.
+#define LORA_CHANNEL_PLAN_DEFAULT { 4, { \
+    LORA_CHANNEL_BASE_HZ + 0 * LORA_CHANNEL_STEP_HZ, \
+    LORA_CHANNEL_BASE_HZ + 1 * LORA_CHANNEL_STEP_HZ, \
+    LORA_CHANNEL_BASE_HZ + 2 * LORA_CHANNEL_STEP_HZ, \
+    LORA_CHANNEL_BASE_HZ + 3 * LORA_CHANNEL_STEP_HZ } }
+
+
+// Pool de pacotes recebidos: cada buffer comporta o maior quadro LoRa (255
+// bytes) e ainda um '\0', e é preenchido direto do FIFO do rádio. Quem
+// recebe o pacote pode repassá-lo (parser, USB, log) com lora_packet_retain()
+// sem copiar; o buffer volta ao pool no último lora_packet_release().
+#define LORA_PACKET_SIZE     256
+#define LORA_PACKET_POOL_LEN 4
+
+typedef struct {
+    uint8_t data[LORA_PACKET_SIZE];
+    uint8_t len;        // 0..255
+    int16_t rssi;       // dBm, lido junto com o pacote
+    uint8_t refs;       // 0 = livre no pool
+    uint64_t t_irq_us;  // time_us_64() no IRQ do DIO0 (RxDone)
+    uint64_t t_fetch_us;// time_us_64() com o FIFO drenado
+} lora_packet_t;
 
 typedef struct {
     spi_inst_t *spi_instance;
@@ -19,6 +53,12 @@ typedef struct {
     uint pin_rst;
     uint pin_dio0;
     long frequency; // Frequência em Hz (ex: 915E6)
+    // Modulação (0 = padrão: SF12, 125 kHz, CR 4/8, preâmbulo 12). O LDRO é
+    // derivado do tempo de símbolo.
+    uint8_t  sf;
+    uint32_t bw_hz;
+    uint8_t  cr;        // 1..4 = 4/5..4/8
+    uint16_t preamble;
 } rfm96_config_t;
 
 bool lora_init(rfm96_config_t config);
@@ -27,6 +67,23 @@ int lora_receive(char *buf, size_t maxlen);
 void lora_start_rx_continuous(void);
 bool lora_send_bytes(const uint8_t *data, size_t len);
 int lora_receive_bytes(uint8_t *buf, size_t maxlen);
+
+// Retorna o próximo pacote recebido (refs = 1) ou NULL. Se o pool estiver
+// esgotado, o pacote é descartado e contado em lora_packet_dropped().
+lora_packet_t *lora_receive_packet(void);
+void lora_packet_retain(lora_packet_t *pkt);
+void lora_packet_release(lora_packet_t *pkt);
+unsigned lora_packet_free(void);
+uint32_t lora_packet_dropped(void);
 int lora_get_rssi(void);
+void lora_set_frequency(long frequency);
+bool lora_use_channel(const lora_channel_plan_t *plan, uint8_t channel);
+
+// Cabeçalho implícito: com len != 0 o RX espera quadros de 'len' bytes sem
+// cabeçalho (tamanho e CRC combinados com o nó, cfg_set implicit no FPGA).
+// O TX (beacons, tamanho variável) continua com cabeçalho explícito.
+void lora_set_implicit(uint8_t len);
+bool lora_ldro_required(uint8_t sf, uint32_t bw_hz);
+uint32_t lora_airtime_us(size_t len, bool implicit);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "rollstats.h"
+
+// Baldes de cada janela: largura x quantidade = duração.
+#define BALDES_1MIN  60     // 1 s
+#define BALDES_1H    60     // 1 min
+#define BALDES_24H   48     // 30 min
+#define BALDES_MAX   60
+
+// Só os 16 bits baixos do balde: as entradas ficam sempre dentro da janela
+// (no máximo BALDES_MAX baldes atrás), então a diferença cabe em int16.
+typedef struct {
+    uint16_t seq;           // Balde da amostra (agora / largura)
+    int16_t  v;
+} rs_entrada_t;
+
+// Fila circular de no máximo 'baldes' entradas: uma por balde, no máximo.
+typedef struct {
+    rs_entrada_t e[BALDES_MAX];
+    uint8_t head, len;
+} rs_fila_t;
+
+typedef struct {
+    uint16_t n[BALDES_MAX];
+    int32_t  soma[BALDES_MAX];
+    int64_t  soma2[BALDES_MAX];
+    uint32_t n_tot;
+    int64_t  soma_tot, soma2_tot;
+    rs_fila_t fmin, fmax;
+} rs_serie_t;
+
+typedef struct {
+    uint32_t   seq;         // Balde corrente
+    bool       iniciada;
+    rs_serie_t serie[RS_NUM_GRANDEZAS];
+} rs_janela_estado_t;
+
+typedef struct {
+    bool    usado;
+    uint8_t node;
+    uint8_t sensor;         // Barramento AHT10 do nó
+    uint64_t ultimo_ms;     // Última amostra
+    rs_janela_estado_t jan[RS_NUM_JANELAS];
+} rs_no_t;
+
+static const struct {
+    uint32_t largura_ms;
+    uint8_t  baldes;
+    const char *nome;
+} janelas[RS_NUM_JANELAS] = {
+    [RS_JANELA_1MIN] = { 1000,           BALDES_1MIN, "1min" },
+    [RS_JANELA_1H]   = { 60 * 1000,      BALDES_1H,   "1h"   },
+    [RS_JANELA_24H]  = { 30 * 60 * 1000, BALDES_24H,  "24h"  },
+};
+
+static rs_no_t nos[ROLLSTATS_MAX_SENSORES];
+static uint32_t recusadas;  // Amostras fora com a tabela cheia
+
+// ----------------------------------------------------------
+// Filas monotônicas: 'menor' = true mantém o mínimo na frente.
+
+static inline rs_entrada_t *fila_at(rs_fila_t *f, unsigned i) {
+    return &f->e[(f->head + i) % BALDES_MAX];
+}
+
+static void fila_push(rs_fila_t *f, uint32_t seq, int16_t v, bool menor) {
+    while (f->len) {
+        rs_entrada_t *b = fila_at(f, f->len - 1);
+        // O balde corrente já tem um valor melhor: nada muda.
+        if (b->seq == (uint16_t)seq && (menor ? b->v <= v : b->v >= v)) return;
+        if (menor ? b->v < v : b->v > v) break;
+        f->len--;
+    }
+    rs_entrada_t *n = fila_at(f, f->len++);
+    n->seq = (uint16_t)seq;
+    n->v   = v;
+}
+
+// Remove da frente os baldes que saíram da janela (seq < primeiro).
+static void fila_expira(rs_fila_t *f, uint32_t primeiro) {
+    while (f->len && (int16_t)(f->e[f->head].seq - (uint16_t)primeiro) < 0) {
+        f->head = (f->head + 1) % BALDES_MAX;
+        f->len--;
+    }
+}
+
+// ----------------------------------------------------------
+
+// Leva a janela até o balde de 'agora_ms', tirando das somas os baldes que
+// saíram. Um salto maior que a janela zera tudo em no máximo 'baldes' passos.
+static void janela_avanca(rs_janela_estado_t *j, rs_janela_t id, uint64_t agora_ms) {
+    uint32_t seq = (uint32_t)(agora_ms / janelas[id].largura_ms);
+    unsigned nb  = janelas[id].baldes;
+
+    if (!j->iniciada) {
+        memset(j, 0, sizeof(*j));
+        j->seq = seq;
+        j->iniciada = true;
+        return;
+    }
+    if ((int32_t)(seq - j->seq) <= 0) return;
+
+    uint32_t passos = seq - j->seq;
+    if (passos >= nb) {
+        // A janela inteira saiu: as filas também (sem comparar seq truncados).
+        for (unsigned g = 0; g < RS_NUM_GRANDEZAS; g++)
+            j->serie[g].fmin.len = j->serie[g].fmax.len = 0;
+        passos = nb;
+    }
+    for (uint32_t k = 1; k <= passos; k++) {
+        unsigned i = (seq - passos + k) % nb;
+        for (unsigned g = 0; g < RS_NUM_GRANDEZAS; g++) {
+            rs_serie_t *s = &j->serie[g];
+            s->n_tot     -= s->n[i];
+            s->soma_tot  -= s->soma[i];
+            s->soma2_tot -= s->soma2[i];
+            s->n[i] = 0;
+            s->soma[i] = 0;
+            s->soma2[i] = 0;
+        }
+    }
+    j->seq = seq;
+
+    uint32_t primeiro = seq - nb + 1;
+    for (unsigned g = 0; g < RS_NUM_GRANDEZAS; g++) {
+        fila_expira(&j->serie[g].fmin, primeiro);
+        fila_expira(&j->serie[g].fmax, primeiro);
+    }
+}
+
+static void serie_add(rs_serie_t *s, uint32_t seq, unsigned i, int16_t v) {
+    s->n[i]++;
+    s->soma[i]  += v;
+    s->soma2[i] += (int32_t)v * v;
+    s->n_tot++;
+    s->soma_tot  += v;
+    s->soma2_tot += (int32_t)v * v;
+    fila_push(&s->fmin, seq, v, true);
+    fila_push(&s->fmax, seq, v, false);
+}
+
+// Com 'criar', um sensor novo usa uma posição livre ou a do sensor parado há
+// mais tempo, se ele já saiu da janela de 24 h.
+static rs_no_t *busca_no(uint8_t node, uint8_t sensor, bool criar, uint64_t agora_ms) {
+    const uint64_t dia_ms = (uint64_t)janelas[RS_JANELA_24H].largura_ms * BALDES_24H;
+    rs_no_t *livre = NULL, *velho = NULL;
+
+    for (unsigned i = 0; i < ROLLSTATS_MAX_SENSORES; i++) {
+        if (nos[i].usado && nos[i].node == node && nos[i].sensor == sensor) return &nos[i];
+        if (!nos[i].usado && !livre) livre = &nos[i];
+        if (nos[i].usado && (!velho || nos[i].ultimo_ms < velho->ultimo_ms)) velho = &nos[i];
+    }
+    if (!criar) return NULL;
+    if (!livre && velho && agora_ms - velho->ultimo_ms > dia_ms) livre = velho;
+    if (!livre) return NULL;
+    memset(livre, 0, sizeof(*livre));
+    livre->usado = true;
+    livre->node   = node;
+    livre->sensor = sensor;
+    return livre;
+}
+
+bool rollstats_add(uint8_t node, uint8_t sensor, int16_t temperatura, int16_t umidade, uint64_t agora_ms) {
+    rs_no_t *no = busca_no(node, sensor, true, agora_ms);
+    if (!no) {
+        recusadas++;
+        return false;
+    }
+    no->ultimo_ms = agora_ms;
+
+    for (unsigned id = 0; id < RS_NUM_JANELAS; id++) {
+        rs_janela_estado_t *j = &no->jan[id];
+        janela_avanca(j, (rs_janela_t)id, agora_ms);
+
+        unsigned i = j->seq % janelas[id].baldes;
+        serie_add(&j->serie[RS_TEMPERATURA], j->seq, i, temperatura);
+        serie_add(&j->serie[RS_UMIDADE],     j->seq, i, umidade);
+    }
+    return true;
+}
+
+bool rollstats_get(uint8_t node, uint8_t sensor, rs_janela_t janela, rs_grandeza_t g, uint64_t agora_ms,
+                   rs_resultado_t *out) {
+    rs_no_t *no = busca_no(node, sensor, false, agora_ms);
+    if (!no) return false;
+
+    rs_janela_estado_t *j = &no->jan[janela];
+    janela_avanca(j, janela, agora_ms);
+
+    rs_serie_t *s = &j->serie[g];
+    if (s->n_tot == 0) return false;
+
+    // Somas inteiras exatas; a subtração só vira ponto flutuante no fim.
+    double n   = s->n_tot;
+    double var = ((double)s->soma2_tot - (double)s->soma_tot * s->soma_tot / n) / n;
+
+    out->n      = s->n_tot;
+    out->min    = s->fmin.e[s->fmin.head].v;
+    out->max    = s->fmax.e[s->fmax.head].v;
+    out->media  = (float)(s->soma_tot / n);
+    out->desvio = var > 0 ? (float)sqrt(var) : 0.0f;
+    return true;
+}
+
+const char *rollstats_nome(rs_janela_t janela) {
+    return janelas[janela].nome;
+}
+
+void rollstats_report(uint64_t agora_ms) {
+    static const char *const grandeza[RS_NUM_GRANDEZAS] = { "temp", "umid" };
+    bool algum = false;
+
+    for (unsigned k = 0; k < ROLLSTATS_MAX_SENSORES; k++) {
+        if (!nos[k].usado) continue;
+        algum = true;
+        for (unsigned id = 0; id < RS_NUM_JANELAS; id++) {
+            for (unsigned g = 0; g < RS_NUM_GRANDEZAS; g++) {
+                rs_resultado_t r;
+                if (!rollstats_get(nos[k].node, nos[k].sensor, (rs_janela_t)id, (rs_grandeza_t)g,
+                                   agora_ms, &r))
+                    continue;
+                printf("no %u.%u %-4s %s: n=%lu min=%.2f max=%.2f media=%.2f desvio=%.2f\n",
+                       nos[k].node, nos[k].sensor, janelas[id].nome, grandeza[g], (unsigned long)r.n,
+                       r.min / 100.0, r.max / 100.0, r.media / 100.0, r.desvio / 100.0);
+            }
+        }
+    }
+    if (!algum) printf("Nenhuma amostra recebida.\n");
+    if (recusadas)
+        printf("%lu amostras fora das estatisticas (tabela de %d sensores cheia)\n",
+               (unsigned long)recusadas, ROLLSTATS_MAX_SENSORES);
+}
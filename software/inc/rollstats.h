@@ -0,0 +1,58 @@
+#ifndef ROLLSTATS_H_
+#define ROLLSTATS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Estatísticas em janela deslizante (1 min, 1 h, 24 h) de temperatura e
+// umidade, por sensor (nó e barramento AHT10 do nó). Cada janela é um anel
+// de baldes de tempo fixo com somas corridas (n, soma, soma dos quadrados) e
+// duas filas monotônicas (mínimo e máximo), então cada amostra custa O(1)
+// (amortizado), qualquer que seja o tamanho da janela. Toda a memória é
+// estática: ROLLSTATS_MAX_SENSORES sensores, ~8 KB por sensor.
+//
+// A tabela cabe ROLLSTATS_MAX_NOS nós com ROLLSTATS_SENSORES_POR_NO
+// barramentos cada. Cheia, um sensor novo toma o lugar de um sem amostras
+// há mais de 24 h; se não houver, fica de fora.
+//
+// A janela anda em passos de um balde: a de 1 min cobre de 59 a 60 s.
+
+#define ROLLSTATS_MAX_NOS          4   // Slots do TDMA
+#define ROLLSTATS_SENSORES_POR_NO  4
+#define ROLLSTATS_MAX_SENSORES     (ROLLSTATS_MAX_NOS * ROLLSTATS_SENSORES_POR_NO)
+
+typedef enum {
+    RS_JANELA_1MIN = 0,
+    RS_JANELA_1H,
+    RS_JANELA_24H,
+    RS_NUM_JANELAS
+} rs_janela_t;
+
+typedef enum {
+    RS_TEMPERATURA = 0,
+    RS_UMIDADE,
+    RS_NUM_GRANDEZAS
+} rs_grandeza_t;
+
+typedef struct {
+    uint32_t n;
+    int16_t  min, max;      // x100, como no quadro
+    float    media;         // x100
+    float    desvio;        // x100 (desvio padrão populacional)
+} rs_resultado_t;
+
+// Registra uma amostra (x100) do sensor 'sensor' do nó 'node' no instante
+// 'agora_ms'. Devolve false se a tabela de sensores está cheia (e nenhum
+// sensor está parado há mais de 24 h).
+bool rollstats_add(uint8_t node, uint8_t sensor, int16_t temperatura, int16_t umidade, uint64_t agora_ms);
+
+// Estatística da janela até 'agora_ms'; false se o sensor não tem amostras nela.
+bool rollstats_get(uint8_t node, uint8_t sensor, rs_janela_t janela, rs_grandeza_t g, uint64_t agora_ms,
+                   rs_resultado_t *out);
+
+const char *rollstats_nome(rs_janela_t janela);
+
+// Imprime todas as janelas de todos os sensores.
+void rollstats_report(uint64_t agora_ms);
+
+#endif
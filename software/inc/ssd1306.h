@@ -6,7 +6,11 @@ extern void ssd1306_send_buffer(uint8_t ssd[], int buffer_length);
 extern void ssd1306_init();
 extern void ssd1306_scroll(bool set);
 extern void render_on_display(uint8_t *ssd, struct render_area *area);
+extern void ssd1306_send_command_stream(const uint8_t *cmds, int number);
+extern void ssd1306_write_columns(uint8_t *ssd, uint8_t x_0, uint8_t x_1, uint8_t page_0, uint8_t page_1);
+extern void ssd1306_scroll_content_left(uint8_t *ssd, uint8_t x_0, uint8_t x_1, uint8_t page_0, uint8_t page_1);
 extern void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set);
+extern void ssd1306_draw_vspan(uint8_t *ssd, int x, int y_0, int y_1, bool set);
 extern void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool set);
 extern void ssd1306_draw_char(uint8_t *ssd, int16_t x, int16_t y, uint8_t character);
 extern void ssd1306_draw_string(uint8_t *ssd, int16_t x, int16_t y, char *string);
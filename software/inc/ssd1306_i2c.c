@@ -74,6 +74,57 @@ void ssd1306_scroll(bool set) {
     ssd1306_send_command_list(commands, count_of(commands));
 }
 
+// Lista de comandos numa única transação (byte de controle 0x00): 1 byte de
+// overhead no total, em vez de um por comando como em ssd1306_send_command_list().
+// Listas maiores que o buffer vão em várias transações de até 15 comandos (o
+// controlador continua os parâmetros de um comando na transação seguinte,
+// como em ssd1306_send_command_list()).
+void ssd1306_send_command_stream(const uint8_t *cmds, int number) {
+    uint8_t buffer[16];
+
+    buffer[0] = 0x00;
+    while (number > 0) {
+        int n = number < (int)sizeof(buffer) - 1 ? number : (int)sizeof(buffer) - 1;
+        memcpy(buffer + 1, cmds, n);
+        i2c_write_blocking(i2c1, ssd1306_i2c_address, buffer, n + 1, false);
+        cmds   += n;
+        number -= n;
+    }
+}
+
+// Envia só as colunas x_0..x_1 das páginas page_0..page_1 do buffer (que tem
+// o quadro inteiro): endereçamento por coluna e uma escrita de dados.
+void ssd1306_write_columns(uint8_t *ssd, uint8_t x_0, uint8_t x_1, uint8_t page_0, uint8_t page_1) {
+    static uint8_t buffer[ssd1306_buffer_length + 1];
+    uint8_t commands[] = {
+        ssd1306_set_column_address, x_0, x_1,
+        ssd1306_set_page_address, page_0, page_1
+    };
+    int n = 0;
+
+    ssd1306_send_command_stream(commands, count_of(commands));
+    buffer[n++] = 0x40;
+    for (int page = page_0; page <= page_1; page++)
+        for (int x = x_0; x <= x_1; x++)
+            buffer[n++] = ssd[page * ssd1306_width + x];
+    i2c_write_blocking(i2c1, ssd1306_i2c_address, buffer, n, false);
+}
+
+// Content scroll (2Dh): desloca uma vez, uma coluna para a esquerda, as colunas
+// x_0..x_1 das páginas page_0..page_1; a coluna x_1 fica com lixo e deve ser
+// reescrita. Só nos controladores que têm o comando (SSD1306B, SSD1309,
+// SSD1315); o buffer em RAM é deslocado junto. Dois comandos seguidos
+// precisam de pelo menos dois quadros (~20 ms) entre si.
+void ssd1306_scroll_content_left(uint8_t *ssd, uint8_t x_0, uint8_t x_1, uint8_t page_0, uint8_t page_1) {
+    uint8_t commands[] = {
+        ssd1306_set_content_scroll_left, 0x00, page_0, 0x01, page_1, x_0, x_1
+    };
+
+    ssd1306_send_command_stream(commands, count_of(commands));
+    for (int page = page_0; page <= page_1; page++)
+        memmove(&ssd[page * ssd1306_width + x_0], &ssd[page * ssd1306_width + x_0 + 1], x_1 - x_0);
+}
+
 // Atualiza uma parte do display com uma área de renderização
 void render_on_display(uint8_t *ssd, struct render_area *area) {
     uint8_t commands[] = {
@@ -104,36 +155,53 @@ void ssd1306_set_pixel(uint8_t *ssd, int x, int y, bool set) {
     ssd[byte_idx] = byte;
 }
 
-// Algoritmo de Bresenham básico
+// Trecho vertical [y_0, y_1] da coluna x, um byte por página (sem passar
+// pixel a pixel); o que sai do display é cortado.
+void ssd1306_draw_vspan(uint8_t *ssd, int x, int y_0, int y_1, bool set) {
+    if (y_0 > y_1) { int t = y_0; y_0 = y_1; y_1 = t; }
+    if (x < 0 || x >= ssd1306_width || y_1 < 0 || y_0 >= ssd1306_height) return;
+    if (y_0 < 0) y_0 = 0;
+    if (y_1 >= ssd1306_height) y_1 = ssd1306_height - 1;
+
+    for (int page = y_0 / 8; page <= y_1 / 8; page++) {
+        int lo = page == y_0 / 8 ? y_0 % 8 : 0;
+        int hi = page == y_1 / 8 ? y_1 % 8 : 7;
+        uint8_t mask = (uint8_t)((0xFF << lo) & (0xFF >> (7 - hi)));
+        uint8_t *b = &ssd[page * ssd1306_width + x];
+        *b = set ? (*b | mask) : (*b & ~mask);
+    }
+}
+
+// Divisão com arredondamento para o inteiro mais próximo (d > 0).
+static int div_round(int n, int d) {
+    return n >= 0 ? (n + d / 2) / d : -((-n + d / 2) / d);
+}
+
+// Linha por colunas: em cada coluna x, um trecho vertical do y da reta em
+// x - 0.5 até antes do y em x + 0.5, que já é da coluna seguinte. Acende
+// max(dx, dy) + 1 pixels, como o Bresenham.
 void ssd1306_draw_line(uint8_t *ssd, int x_0, int y_0, int x_1, int y_1, bool set) {
-    int dx = abs(x_1 - x_0); // Deslocamentos
-    int dy = -abs(y_1 - y_0);
-    int sx = x_0 < x_1 ? 1 : -1; // Direção de avanço
-    int sy = y_0 < y_1 ? 1 : -1;
-    int error = dx + dy; // Erro acumulado
-    int error_2;
-
-    while (true) {
-        ssd1306_set_pixel(ssd, x_0, y_0, set); // Acende pixel no ponto atual
-        if (x_0 == x_1 && y_0 == y_1) {
-            break; // Verifica se o ponto final foi alcançado
-        }
-
-        error_2 = 2 * error; // Ajusta o erro acumulado
-
-        if (error_2 >= dy) {
-            error += dy;
-            x_0 += sx; // Avança na direção x
-        }
-        if (error_2 <= dx) {
-            error += dx;
-            y_0 += sy; // Avança na direção y
-        }
+    if (x_0 > x_1) {
+        int t;
+        t = x_0; x_0 = x_1; x_1 = t;
+        t = y_0; y_0 = y_1; y_1 = t;
+    }
+
+    int dx = x_1 - x_0;
+    int dy = y_1 - y_0;
+    int sy = dy < 0 ? -1 : 1;
+    int y_a = y_0;
+
+    for (int x = x_0; x < x_1; x++) {
+        int y_b = y_0 + div_round(dy * (2 * (x - x_0) + 1), 2 * dx);
+        ssd1306_draw_vspan(ssd, x, y_a, y_b == y_a ? y_a : y_b - sy, set);
+        y_a = y_b;
     }
+    ssd1306_draw_vspan(ssd, x_1, y_a, y_1, set);
 }
 
 // Adquire os pixels para um caractere (de acordo com ssd1306_font.h)
-inline int ssd1306_get_font(uint8_t character)
+static inline int ssd1306_get_font(uint8_t character)
 {
   if (character >= 'A' && character <= 'Z') {
     return character - 'A' + 1;
@@ -214,6 +282,7 @@ void ssd1306_config(ssd1306_t *ssd) {
 void ssd1306_init_bm(ssd1306_t *ssd, uint8_t width, uint8_t height, bool external_vcc, uint8_t address, i2c_inst_t *i2c) {
     ssd->width = width;
     ssd->height = height;
+    ssd->external_vcc = external_vcc;
     ssd->pages = height / 8U;
     ssd->address = address;
     ssd->i2c_port = i2c;
@@ -237,7 +306,7 @@ void ssd1306_send_data(ssd1306_t *ssd) {
 
 // Desenha o bitmap (a ser fornecido em display_oled.c) no display
 void ssd1306_draw_bitmap(ssd1306_t *ssd, const uint8_t *bitmap) {
-    for (int i = 0; i < ssd->bufsize - 1; i++) {
+    for (size_t i = 0; i < ssd->bufsize - 1; i++) {
         ssd->ram_buffer[i + 1] = bitmap[i];
 
         ssd1306_send_data(ssd);
@@ -49,6 +49,7 @@
 #define ssd1306_set_page_address _u(0x22)
 #define ssd1306_set_horizontal_scroll _u(0x26)
 #define ssd1306_set_scroll _u(0x2E)
+#define ssd1306_set_content_scroll_left _u(0x2D)
 
 #define ssd1306_set_display_start_line _u(0x40)
 